@@ -0,0 +1,253 @@
+/*
+ * Aggregates the benchmark runs into the analysis/res/ files.
+ *
+ * Reads every log once from <run_dir>/log/ and <run_dir>/<patch>/log/
+ * (run_nas_vectors.sh), together with the trace sizes from the matching
+ * traces/ directories, and writes:
+ *    runs.csv, summary.csv              every run, grouped by (app, patch, mode)
+ *    runs.bin, nas_comp_write.bin       the same runs and all the Pallas timer
+ *                                       lines as columns, see columns.cc
+ *    durations.csv, overhead.csv,
+ *    nas_{vanilla,eztrace}_time_mean.csv,
+ *    nas_overhead_mean.csv,
+ *    trace_size.csv, nas_trace_size_mean.csv,
+ *    nas_comp_write.csv                 the files read by the plotting scripts,
+ *                                       from the first <run_dir> only
+ *    overhead_phases.csv                the overhead split by Pallas phase, an
+ *                                       approximation from the timer totals
+ *    overhead_ci.csv                    medians, bootstrap confidence intervals
+ *                                       and repetitions needed for an overhead
+ *                                       precision of +/- <precision> percent
+ *    archive_sections.csv               raw and compressed bytes of every trace
+ *                                       by section, see archive.cc
+ *    compression.csv                    trace size, compression ratio and
+ *                                       compression/write time by app and
+ *                                       <run_dir>/<patch>
+ *
+ * Logs are memory-mapped and parsed in parallel, one file per task, then
+ * the files of every trace are scanned in parallel.
+ *
+ * With -c, nothing is written: the exit status is 0 once every app has at
+ * least <min_reps> vanilla/eztrace pairs and its overhead is known within
+ * +/- <precision> percent, 2 otherwise. run_interleaved.sh uses it to stop
+ * early.
+ *
+ * Usage: aggregator [-o <res_dir>] [-j <threads>] [-p <precision>]
+ *                   [-c <min_reps>] <run_dir>...
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <thread>
+#include <tuple>
+
+#include "aggregator.h"
+
+namespace fs = std::filesystem ;
+
+/******************************************/
+
+static void Usage(const char *prog)
+{
+   std::cerr << "Usage: " << prog << " [-o <res_dir>] [-j <threads>] [-p <precision>]"
+             << " [-c <min_reps>] <run_dir>..." << std::endl ;
+}
+
+/******************************************/
+
+/* <run_dir>/<sub>/ and <run_dir>/<patch>/<sub>/ */
+static std::vector<fs::path> SubDirs(const fs::path& runDir, const char *sub)
+{
+   std::vector<fs::path> dirs ;
+   std::error_code ec ;
+   if (fs::is_directory(runDir / sub, ec))
+      dirs.push_back(runDir / sub) ;
+   for (const auto& entry : fs::directory_iterator(runDir, ec)) {
+      if (entry.is_directory() && fs::is_directory(entry.path() / sub, ec))
+         dirs.push_back(entry.path() / sub) ;
+   }
+   return dirs ;
+}
+
+/******************************************/
+
+/* Runs task(i) for i in [0, count) on nthreads threads */
+template <typename Task>
+static void ParallelFor(size_t count, unsigned nthreads, Task task)
+{
+   std::atomic<size_t> next(0) ;
+   auto worker = [&]() {
+      for (size_t i = next++; i < count; i = next++)
+         task(i) ;
+   } ;
+
+   nthreads = std::max(1u, std::min<unsigned>(nthreads, count)) ;
+   std::vector<std::thread> threads ;
+   for (unsigned t = 1; t < nthreads; ++t)
+      threads.emplace_back(worker) ;
+   worker() ;
+   for (std::thread& t : threads)
+      t.join() ;
+}
+
+/******************************************/
+
+int main(int argc, char *argv[])
+{
+   std::string resDir = "." ;
+   unsigned nthreads = std::thread::hardware_concurrency() ;
+   double precision = 1.0 ;   /* percent of the vanilla time */
+   int minReps = -1 ;         /* check mode when set */
+   std::vector<fs::path> runDirs ;
+   std::error_code ec ;
+
+   for (int i = 1; i < argc; ++i) {
+      if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+         resDir = argv[++i] ;
+      }
+      else if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+         nthreads = static_cast<unsigned>(std::atoi(argv[++i])) ;
+      }
+      else if (std::strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+         precision = std::atof(argv[++i]) ;
+      }
+      else if (std::strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+         minReps = std::atoi(argv[++i]) ;
+      }
+      else if (argv[i][0] == '-') {
+         Usage(argv[0]) ;
+         return 1 ;
+      }
+      else if (!fs::is_directory(argv[i], ec)) {
+         std::cerr << "aggregator: " << argv[i] << " is not a directory" << std::endl ;
+         return 1 ;
+      }
+      else {
+         /* A glob over run_nas_benchmark also matches the first <run_dir> */
+         fs::path dir = fs::canonical(argv[i]) ;
+         if (std::find(runDirs.begin(), runDirs.end(), dir) == runDirs.end())
+            runDirs.push_back(dir) ;
+      }
+   }
+   if (runDirs.empty()) {
+      Usage(argv[0]) ;
+      return 1 ;
+   }
+
+   std::vector<RunLog> runs ;
+   std::vector<TraceSize> traces ;
+   std::vector<std::string> tracePaths ;
+
+   for (const fs::path& runDir : runDirs) {
+      std::string runName = runDir.filename().string() ;
+      for (const fs::path& dir : SubDirs(runDir, "log")) {
+         std::string patch = dir.parent_path() == runDir ?
+                             "" : dir.parent_path().filename().string() ;
+         for (const auto& entry : fs::directory_iterator(dir, ec)) {
+            RunLog run ;
+            if (!entry.is_regular_file() || !ParseLogName(entry.path().string(), run))
+               continue ;
+            run.run = runName ;
+            run.patch = patch ;
+            runs.push_back(std::move(run)) ;
+         }
+      }
+      for (const fs::path& dir : SubDirs(runDir, "traces")) {
+         std::string patch = dir.parent_path() == runDir ?
+                             "" : dir.parent_path().filename().string() ;
+         for (const auto& entry : fs::directory_iterator(dir, ec)) {
+            if (!entry.is_directory())
+               continue ;
+            TraceSize trace ;
+            trace.name = entry.path().filename().string() ;
+            trace.run = runName ;
+            trace.patch = patch ;
+            traces.push_back(trace) ;
+            tracePaths.push_back(entry.path().string()) ;
+         }
+      }
+   }
+
+   /* Logs first, the trace sizes take a directory walk each and are not
+    * needed by the check */
+   std::vector<char> failed(runs.size(), 0) ;
+   size_t ntraces = minReps >= 0 ? 0 : traces.size() ;
+   std::vector<std::vector<std::string>> traceFiles(ntraces) ;
+   ParallelFor(runs.size() + ntraces, nthreads, [&](size_t i) {
+      if (i < runs.size()) {
+         failed[i] = !ParseLog(runs[i].path, runs[i]) ;
+      }
+      else {
+         size_t t = i - runs.size() ;
+         traces[t].size = TraceDirSize(tracePaths[t]) ;
+         traceFiles[t] = ListArchiveFiles(tracePaths[t]) ;
+      }
+   }) ;
+
+   /* One task per archive file, a trace has files for each of its threads */
+   std::vector<std::pair<size_t, size_t>> files ;
+   for (size_t t = 0; t < ntraces; ++t)
+      for (size_t f = 0; f < traceFiles[t].size(); ++f)
+         files.push_back({t, f}) ;
+   std::vector<SectionSize> fileSizes(files.size()) ;
+   ParallelFor(files.size(), nthreads, [&](size_t i) {
+      auto [t, f] = files[i] ;
+      fileSizes[i] = InspectArchiveFile(tracePaths[t] + "/" + traceFiles[t][f]) ;
+   }) ;
+   for (size_t i = 0; i < files.size(); ++i) {
+      auto [t, f] = files[i] ;
+      SectionSize& s = traces[t].sections[ClassifyArchiveFile(traceFiles[t][f])] ;
+      s.files += fileSizes[i].files ;
+      s.raw += fileSizes[i].raw ;
+      s.compressed += fileSizes[i].compressed ;
+      s.codecs |= fileSizes[i].codecs ;
+   }
+
+   size_t kept = 0 ;
+   for (size_t i = 0; i < runs.size(); ++i) {
+      if (failed[i])
+         std::cerr << "aggregator: cannot read " << runs[i].path << std::endl ;
+      else if (kept++ != i)
+         runs[kept-1] = std::move(runs[i]) ;
+   }
+   runs.resize(kept) ;
+
+   std::sort(runs.begin(), runs.end(),
+             [](const RunLog& a, const RunLog& b) { return a.path < b.path ; }) ;
+   std::sort(traces.begin(), traces.end(),
+             [](const TraceSize& a, const TraceSize& b) {
+                return std::tie(a.run, a.patch, a.name) < std::tie(b.run, b.patch, b.name) ;
+             }) ;
+
+   if (minReps >= 0)
+      return CheckPrecision(runs, precision, minReps) ? 0 : 2 ;
+
+   /* <app>_trace_<iter> (or <app>_trace) is the trace of the eztrace run
+    * <app>_<iter>_eztrace.log of the same directory */
+   std::map<std::tuple<std::string, std::string, std::string, int>, uint64_t> traceOf ;
+   for (const TraceSize& trace : traces) {
+      size_t pos = trace.name.rfind("_trace") ;
+      if (pos == std::string::npos)
+         continue ;
+      std::string rest = trace.name.substr(pos + 6) ;
+      int iter = rest.size() > 1 && rest[0] == '_' ? std::atoi(rest.c_str() + 1) : 0 ;
+      traceOf[{trace.run, trace.patch, trace.name.substr(0, pos), iter}] = trace.size ;
+   }
+   for (RunLog& run : runs) {
+      auto it = traceOf.find({run.run, run.patch, run.app, run.iter}) ;
+      if (run.mode == "eztrace" && it != traceOf.end())
+         run.traceSize = static_cast<int64_t>(it->second) ;
+   }
+
+   WriteResults(resDir, runDirs[0].filename().string(), runs, traces) ;
+   WriteStats(resDir, runs, precision) ;
+   WriteCompression(resDir, runs, traces) ;
+   WriteRunColumns(resDir + "/runs.bin", runs) ;
+   WriteTimerColumns(resDir + "/nas_comp_write.bin", runs) ;
+   return 0 ;
+}
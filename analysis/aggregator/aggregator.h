@@ -0,0 +1,101 @@
+#ifndef AGGREGATOR_H
+#define AGGREGATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/* One timer line appended by pallas_stats_collect:
+ * name,n_calls,total_time,min,max,mean
+ * The fields are kept as written so the outputs match the logs exactly. */
+struct TimerLine
+{
+   std::string name ;
+   std::string fields[5] ;
+} ;
+
+/* Everything we keep from one run log, named <app>[_<iter>]_<mode>.log */
+struct RunLog
+{
+   std::string path ;
+   std::string run ;        /* run directory, e.g. 20_iter or vectors */
+   std::string app ;        /* bt.C.x, lulesh, ... */
+   std::string patch ;      /* <run>/<patch>/log/, empty for <run>/log/ */
+   std::string mode ;       /* vanilla or eztrace */
+   int iter = 0 ;           /* 0 when the log name has no iteration */
+
+   bool hasTime = false ;
+   double time = 0.0 ;      /* [TIME], in seconds */
+   std::string timeText ;
+   bool hasMaxMemory = false ;
+   int64_t maxMemory = 0 ;  /* [MAX_MEMORY], in KB */
+
+   std::vector<TimerLine> timers ;
+
+   /* Written by pallas_stats_provenance, empty for older logs */
+   std::string pallasCommit ;
+   std::string eztraceCommit ;
+   std::string buildFlags ;
+   std::string host ;
+
+   int64_t traceSize = -1 ; /* size of the run's trace, -1 without one */
+} ;
+
+/* Parts of a Pallas archive, see archive.cc */
+enum Section
+{
+   SECTION_DEFINITIONS, SECTION_GRAMMAR, SECTION_TIMESTAMPS, SECTION_DURATIONS,
+   SECTION_ATTRIBUTES, SECTION_OTHER, NUM_SECTIONS
+} ;
+
+enum Codec { CODEC_NONE = 1, CODEC_ZSTD = 2, CODEC_ZFP = 4 } ;
+
+struct SectionSize
+{
+   uint64_t files = 0 ;
+   uint64_t raw = 0 ;        /* decompressed */
+   uint64_t compressed = 0 ; /* on disk */
+   unsigned codecs = 0 ;     /* Codec flags */
+} ;
+
+struct TraceSize
+{
+   std::string name ;       /* trace directory, e.g. bt.C.x_trace_1 */
+   std::string run ;
+   std::string patch ;
+   uint64_t size = 0 ;      /* apparent size, as du -sb */
+   SectionSize sections[NUM_SECTIONS] ;
+} ;
+
+/* parse.cc */
+bool ParseLogName(const std::string& path, RunLog& run) ;
+bool ParseLog(const std::string& path, RunLog& run) ;
+uint64_t TraceDirSize(const std::string& path) ;
+
+/* archive.cc */
+const char *SectionName(int section) ;
+std::string CodecName(unsigned codecs) ;
+Section ClassifyArchiveFile(const std::string& relPath) ;
+std::vector<std::string> ListArchiveFiles(const std::string& dir) ;
+SectionSize InspectArchiveFile(const std::string& path) ;
+void WriteCompression(const std::string& resDir, const std::vector<RunLog>& runs,
+                      const std::vector<TraceSize>& traces) ;
+
+/* results.cc */
+std::string ShortName(const std::string& app) ;
+std::string FormatReal(double value) ;
+void WriteResults(const std::string& resDir, const std::string& refRun,
+                  const std::vector<RunLog>& runs,
+                  const std::vector<TraceSize>& traces) ;
+
+/* stats.cc */
+double Median(std::vector<double> values) ;
+void WriteStats(const std::string& resDir, const std::vector<RunLog>& runs,
+                double precision) ;
+bool CheckPrecision(const std::vector<RunLog>& runs, double precision, int minReps) ;
+
+/* columns.cc */
+bool WriteRunColumns(const std::string& path, const std::vector<RunLog>& runs) ;
+bool WriteTimerColumns(const std::string& path, const std::vector<RunLog>& runs) ;
+
+#endif
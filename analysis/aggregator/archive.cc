@@ -0,0 +1,361 @@
+/*
+ * Bytes of a Pallas archive by section, raw and compressed.
+ *
+ * Files are classified by their path in the archive (see sectionRules) and
+ * scanned for compressed chunks, found by their magic numbers:
+ *    zstd   frames, whose header gives the decompressed size; the frame is
+ *           walked block by block to find where it ends
+ *    zfp    streams written with a full header, whose field dimensions give
+ *           the decompressed size; a stream runs to the next one or to the
+ *           end of the file
+ * The bytes outside any chunk are stored as is, their raw size is their
+ * size on disk.
+ */
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <tuple>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "aggregator.h"
+
+namespace fs = std::filesystem ;
+
+namespace {
+
+struct SectionRule
+{
+   const char *pattern ;    /* substring of the file name */
+   Section section ;
+} ;
+
+/* First match wins. Files at the root of the archive are the global
+ * definitions, the other .pallas files hold the grammar of a thread
+ * (events, sequences, loops) */
+const SectionRule sectionRules[] = {
+   { "timestamp", SECTION_TIMESTAMPS },
+   { "duration", SECTION_DURATIONS },
+   { "attribute", SECTION_ATTRIBUTES },
+   { "archive", SECTION_DEFINITIONS },
+   { "def", SECTION_DEFINITIONS },
+   { "string", SECTION_DEFINITIONS },
+   { ".pallas", SECTION_GRAMMAR },
+} ;
+
+const char *sectionNames[NUM_SECTIONS] = {
+   "definitions", "grammar", "timestamps", "durations", "attributes", "other"
+} ;
+
+const uint8_t ZSTD_MAGIC[4] = { 0x28, 0xB5, 0x2F, 0xFD } ;
+const uint8_t ZFP_MAGIC[4] = { 'z', 'f', 'p', 5 } ;   /* codec version 5 */
+
+uint64_t ReadLE(const uint8_t *p, int bytes)
+{
+   uint64_t value = 0 ;
+   for (int i = bytes - 1; i >= 0; --i)
+      value = (value << 8) | p[i] ;
+   return value ;
+}
+
+/* Parses the zstd frame at `p`. Returns its size on disk, 0 if it is not
+ * a valid frame, and sets `raw` to its decompressed size */
+size_t ZstdFrame(const uint8_t *p, const uint8_t *last, uint64_t& raw)
+{
+   const uint8_t *cur = p + 4 ;
+   if (cur >= last)
+      return 0 ;
+   uint8_t descriptor = *cur++ ;
+   int fcsFlag = descriptor >> 6 ;
+   bool singleSegment = descriptor & 0x20 ;
+   bool checksum = descriptor & 0x04 ;
+   int dictFlag = descriptor & 0x03 ;
+   if (descriptor & 0x08)               /* reserved bit */
+      return 0 ;
+
+   static const int dictBytes[4] = { 0, 1, 2, 4 } ;
+   static const int fcsBytes[4] = { 0, 2, 4, 8 } ;
+   int fcsSize = fcsFlag == 0 && singleSegment ? 1 : fcsBytes[fcsFlag] ;
+   size_t header = (singleSegment ? 0 : 1) + dictBytes[dictFlag] + fcsSize ;
+   if (static_cast<size_t>(last - cur) < header)
+      return 0 ;
+   cur += header - fcsSize ;
+   bool hasContentSize = fcsSize > 0 ;
+   uint64_t contentSize = hasContentSize ? ReadLE(cur, fcsSize) : 0 ;
+   if (fcsSize == 2)
+      contentSize += 256 ;
+   cur += fcsSize ;
+
+   /* Without a content size, compressed blocks count as their size on disk */
+   uint64_t blocksRaw = 0 ;
+   for (;;) {
+      if (last - cur < 3)
+         return 0 ;
+      uint32_t block = static_cast<uint32_t>(ReadLE(cur, 3)) ;
+      cur += 3 ;
+      bool lastBlock = block & 1 ;
+      int type = (block >> 1) & 3 ;
+      size_t size = block >> 3 ;
+      if (type == 3)
+         return 0 ;
+      size_t stored = type == 1 ? 1 : size ;
+      if (static_cast<size_t>(last - cur) < stored)
+         return 0 ;
+      cur += stored ;
+      blocksRaw += size ;
+      if (lastBlock)
+         break ;
+   }
+   if (checksum) {
+      if (last - cur < 4)
+         return 0 ;
+      cur += 4 ;
+   }
+
+   raw = hasContentSize ? contentSize : blocksRaw ;
+   return cur - p ;
+}
+
+/* Decompressed size of the zfp stream at `p`, 0 when its header has no
+ * field metadata. The header is a stream of 64-bit words, least
+ * significant bit first: 32 bits of magic then 52 bits of metadata. */
+uint64_t ZfpRawSize(const uint8_t *p, const uint8_t *last)
+{
+   if (last - p < 16)
+      return 0 ;
+   uint64_t meta = (ReadLE(p, 8) >> 32) | (ReadLE(p + 8, 8) << 32) ;
+   meta &= (uint64_t(1) << 52) - 1 ;
+
+   static const uint64_t typeSize[4] = { 4, 8, 4, 8 } ;   /* int32, int64, float, double */
+   uint64_t elemSize = typeSize[meta & 3] ;
+   int dims = static_cast<int>((meta >> 2) & 3) + 1 ;
+   static const int dimBits[5] = { 0, 48, 24, 16, 12 } ;
+   uint64_t mask = (uint64_t(1) << dimBits[dims]) - 1 ;
+   uint64_t count = 1 ;
+   for (int d = 0; d < dims; ++d)
+      count *= ((meta >> (4 + d * dimBits[dims])) & mask) + 1 ;
+   return count * elemSize ;
+}
+
+/* Position of the next `magic` in [p, last), or last */
+const uint8_t *Find(const uint8_t *p, const uint8_t *last, const uint8_t magic[4])
+{
+   const void *found = memmem(p, last - p, magic, 4) ;
+   return found ? static_cast<const uint8_t *>(found) : last ;
+}
+
+} // namespace
+
+/******************************************/
+
+const char *SectionName(int section)
+{
+   return sectionNames[section] ;
+}
+
+/******************************************/
+
+std::string CodecName(unsigned codecs)
+{
+   std::string name ;
+   if (codecs & CODEC_ZSTD)
+      name = "zstd" ;
+   if (codecs & CODEC_ZFP)
+      name += name.empty() ? "zfp" : "+zfp" ;
+   return name.empty() ? "none" : name ;
+}
+
+/******************************************/
+
+Section ClassifyArchiveFile(const std::string& relPath)
+{
+   fs::path p(relPath) ;
+   std::string file = p.filename().string() ;
+   std::transform(file.begin(), file.end(), file.begin(), ::tolower) ;
+   if (!p.has_parent_path() && p.extension() == ".pallas")
+      return SECTION_DEFINITIONS ;
+   for (const SectionRule& rule : sectionRules) {
+      if (file.find(rule.pattern) != std::string::npos)
+         return rule.section ;
+   }
+   return SECTION_OTHER ;
+}
+
+/******************************************/
+
+std::vector<std::string> ListArchiveFiles(const std::string& dir)
+{
+   std::vector<std::string> files ;
+   std::error_code ec ;
+   for (fs::recursive_directory_iterator it(dir, ec), end; it != end; it.increment(ec)) {
+      if (ec)
+         break ;
+      if (it->is_regular_file(ec))
+         files.push_back(fs::relative(it->path(), dir, ec).string()) ;
+   }
+   std::sort(files.begin(), files.end()) ;
+   return files ;
+}
+
+/******************************************/
+
+SectionSize InspectArchiveFile(const std::string& path)
+{
+   SectionSize s ;
+   s.files = 1 ;
+
+   int fd = open(path.c_str(), O_RDONLY) ;
+   if (fd < 0)
+      return s ;
+   struct stat st ;
+   if (fstat(fd, &st) != 0 || st.st_size == 0) {
+      close(fd) ;
+      return s ;
+   }
+   size_t size = static_cast<size_t>(st.st_size) ;
+   void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) ;
+   close(fd) ;
+   if (map == MAP_FAILED)
+      return s ;
+   madvise(map, size, MADV_SEQUENTIAL) ;
+
+   const uint8_t *begin = static_cast<const uint8_t *>(map) ;
+   const uint8_t *last = begin + size ;
+   const uint8_t *cur = begin ;
+   uint64_t plain = 0 ;
+   while (cur < last) {
+      const uint8_t *zstd = Find(cur, last, ZSTD_MAGIC) ;
+      const uint8_t *zfp = Find(cur, std::min(zstd, last), ZFP_MAGIC) ;
+      if (zfp < zstd) {
+         uint64_t raw = ZfpRawSize(zfp, last) ;
+         const uint8_t *next = std::min(Find(zfp + 4, last, ZFP_MAGIC), Find(zfp + 4, last, ZSTD_MAGIC)) ;
+         if (raw == 0) {
+            plain += next - cur ;
+         }
+         else {
+            plain += zfp - cur ;
+            s.raw += raw ;
+            s.compressed += next - zfp ;
+            s.codecs |= CODEC_ZFP ;
+         }
+         cur = next ;
+         continue ;
+      }
+      plain += zstd - cur ;
+      if (zstd == last)
+         break ;
+      uint64_t raw = 0 ;
+      size_t frame = ZstdFrame(zstd, last, raw) ;
+      if (frame == 0) {
+         plain += 4 ;
+         cur = zstd + 4 ;
+         continue ;
+      }
+      s.raw += raw ;
+      s.compressed += frame ;
+      s.codecs |= CODEC_ZSTD ;
+      cur = zstd + frame ;
+   }
+   s.raw += plain ;
+   s.compressed += plain ;
+   if (plain > 0)
+      s.codecs |= CODEC_NONE ;
+
+   munmap(map, size) ;
+   return s ;
+}
+
+/******************************************/
+
+void WriteCompression(const std::string& resDir, const std::vector<RunLog>& runs,
+                      const std::vector<TraceSize>& traces)
+{
+   std::string path = resDir + "/archive_sections.csv" ;
+   std::ofstream out(path) ;
+   if (!out)
+      std::cerr << "aggregator: cannot write " << path << std::endl ;
+   out << "NAME,RUN,PATCH,SECTION,CODEC,FILES,RAW_SIZE,COMPRESSED_SIZE,RATIO\n" ;
+
+   /* Means by (app, run, patch): the iterations of a run are the same
+    * configuration */
+   struct Mean
+   {
+      int traces = 0 ;
+      double size = 0.0 ;
+      double raw = 0.0 ;
+      int runs = 0 ;
+      double compress = 0.0 ;
+      double write = 0.0 ;
+   } ;
+   std::map<std::tuple<std::string, std::string, std::string>, Mean> means ;
+
+   auto row = [&](const TraceSize& trace, const char *section, const SectionSize& s) {
+      out << trace.name << "," << trace.run << "," << trace.patch << ","
+          << section << "," << CodecName(s.codecs) << "," << s.files << ","
+          << s.raw << "," << s.compressed << ","
+          << (s.compressed ? FormatReal(double(s.raw) / s.compressed) : "") << "\n" ;
+   } ;
+
+   for (const TraceSize& trace : traces) {
+      SectionSize total ;
+      for (int sec = 0; sec < NUM_SECTIONS; ++sec) {
+         const SectionSize& s = trace.sections[sec] ;
+         if (s.files == 0)
+            continue ;
+         row(trace, SectionName(sec), s) ;
+         total.files += s.files ;
+         total.raw += s.raw ;
+         total.compressed += s.compressed ;
+         total.codecs |= s.codecs ;
+      }
+      row(trace, "total", total) ;
+
+      /* bt.C.x_trace_1 -> bt.C.x */
+      std::string app = trace.name.substr(0, trace.name.find("_trace")) ;
+      Mean& m = means[{app, trace.run, trace.patch}] ;
+      m.traces++ ;
+      m.size += total.compressed ;
+      m.raw += total.raw ;
+   }
+
+   for (const RunLog& run : runs) {
+      auto it = means.find({run.app, run.run, run.patch}) ;
+      if (run.mode != "eztrace" || it == means.end())
+         continue ;
+      Mean& m = it->second ;
+      m.runs++ ;
+      for (const TimerLine& timer : run.timers) {
+         double total = std::strtod(timer.fields[1].c_str(), nullptr) ;
+         if (timer.name == "zstd" || timer.name == "zfp" || timer.name == "sz")
+            m.compress += total ;
+         else if (timer.name == "write")
+            m.write += total ;
+      }
+   }
+
+   /* The table of analysis/plot/compression.csv, one row per app and
+    * configuration */
+   path = resDir + "/compression.csv" ;
+   std::ofstream table(path) ;
+   if (!table)
+      std::cerr << "aggregator: cannot write " << path << std::endl ;
+   table << "NAME,RUN,PATCH,TRACE_SIZE_MB,RAW_SIZE_MB,RATIO,COMPRESSION_DURATION_NS,WRITE_DURATION_NS\n" ;
+   const double MB = 1024.0 * 1024.0 ;
+   for (const auto& [key, m] : means) {
+      table << ShortName(std::get<0>(key)) << "," << std::get<1>(key) << ","
+            << std::get<2>(key) << ","
+            << FormatReal(m.size / m.traces / MB) << ","
+            << FormatReal(m.raw / m.traces / MB) << ","
+            << (m.size > 0 ? FormatReal(m.raw / m.size) : "") << ","
+            << (m.runs ? FormatReal(m.compress / m.runs) : "") << ","
+            << (m.runs ? FormatReal(m.write / m.runs) : "") << "\n" ;
+   }
+}
@@ -0,0 +1,221 @@
+/*
+ * Flat binary column files, loaded by analysis/prog/columns.py (numeric
+ * columns without copy, string columns as copied categoricals)
+ *
+ *    char     magic[8]          "PALCOL1"
+ *    uint64_t nrows, ncols
+ *    ncols column descriptors of 64 bytes:
+ *       char     name[40]
+ *       uint32_t type           0: float64, 1: int64, 2: string
+ *       uint32_t reserved
+ *       uint64_t offset         start of the nrows values
+ *       uint64_t dictOffset     string columns only
+ *
+ * String columns are stored as uint32 codes into a dictionary of
+ * uint64 count followed by count (uint32 length, bytes) entries.
+ * Every section starts on a 64-byte boundary, values are little-endian.
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+
+#include "aggregator.h"
+
+namespace {
+
+enum ColumnType : uint32_t { COL_REAL = 0, COL_INT = 1, COL_STRING = 2 } ;
+
+struct ColumnDesc
+{
+   char name[40] ;
+   uint32_t type ;
+   uint32_t reserved ;
+   uint64_t offset ;
+   uint64_t dictOffset ;
+} ;
+static_assert(sizeof(ColumnDesc) == 64, "column descriptor must be 64 bytes") ;
+
+struct Column
+{
+   std::string name ;
+   ColumnType type ;
+   std::vector<double> reals ;
+   std::vector<int64_t> ints ;
+   std::vector<uint32_t> codes ;
+   std::vector<std::string> dict ;
+   std::map<std::string, uint32_t> index ;
+
+   void AddString(const std::string& value)
+   {
+      auto it = index.find(value) ;
+      if (it == index.end()) {
+         it = index.emplace(value, static_cast<uint32_t>(dict.size())).first ;
+         dict.push_back(value) ;
+      }
+      codes.push_back(it->second) ;
+   }
+} ;
+
+class ColumnTable
+{
+public:
+   Column& Add(const char *name, ColumnType type)
+   {
+      m_columns.push_back(Column()) ;
+      m_columns.back().name = name ;
+      m_columns.back().type = type ;
+      return m_columns.back() ;
+   }
+
+   bool Write(const std::string& path, uint64_t nrows) const ;
+
+private:
+   std::deque<Column> m_columns ;    /* Add() hands out references */
+} ;
+
+/******************************************/
+
+static void Pad(std::ofstream& out)
+{
+   static const char zeros[64] = {} ;
+   uint64_t pos = static_cast<uint64_t>(out.tellp()) ;
+   if (pos % 64)
+      out.write(zeros, 64 - pos % 64) ;
+}
+
+/******************************************/
+
+bool ColumnTable::Write(const std::string& path, uint64_t nrows) const
+{
+   std::ofstream out(path, std::ios::binary) ;
+   if (!out) {
+      std::cerr << "aggregator: cannot write " << path << std::endl ;
+      return false ;
+   }
+
+   uint64_t ncols = m_columns.size() ;
+   out.write("PALCOL1", 8) ;
+   out.write(reinterpret_cast<const char *>(&nrows), sizeof(nrows)) ;
+   out.write(reinterpret_cast<const char *>(&ncols), sizeof(ncols)) ;
+
+   /* Descriptors are rewritten once the offsets are known */
+   std::vector<ColumnDesc> descs(ncols) ;
+   std::streampos descPos = out.tellp() ;
+   out.write(reinterpret_cast<const char *>(descs.data()), ncols * sizeof(ColumnDesc)) ;
+
+   for (uint64_t c = 0; c < ncols; ++c) {
+      const Column& col = m_columns[c] ;
+      ColumnDesc& desc = descs[c] ;
+      std::strncpy(desc.name, col.name.c_str(), sizeof(desc.name) - 1) ;
+      desc.type = col.type ;
+
+      Pad(out) ;
+      desc.offset = static_cast<uint64_t>(out.tellp()) ;
+      switch (col.type) {
+         case COL_REAL:
+            out.write(reinterpret_cast<const char *>(col.reals.data()),
+                      col.reals.size() * sizeof(double)) ;
+            break ;
+         case COL_INT:
+            out.write(reinterpret_cast<const char *>(col.ints.data()),
+                      col.ints.size() * sizeof(int64_t)) ;
+            break ;
+         case COL_STRING: {
+            out.write(reinterpret_cast<const char *>(col.codes.data()),
+                      col.codes.size() * sizeof(uint32_t)) ;
+            Pad(out) ;
+            desc.dictOffset = static_cast<uint64_t>(out.tellp()) ;
+            uint64_t count = col.dict.size() ;
+            out.write(reinterpret_cast<const char *>(&count), sizeof(count)) ;
+            for (const std::string& s : col.dict) {
+               uint32_t len = static_cast<uint32_t>(s.size()) ;
+               out.write(reinterpret_cast<const char *>(&len), sizeof(len)) ;
+               out.write(s.data(), len) ;
+            }
+            break ;
+         }
+      }
+   }
+
+   out.seekp(descPos) ;
+   out.write(reinterpret_cast<const char *>(descs.data()), ncols * sizeof(ColumnDesc)) ;
+   return static_cast<bool>(out) ;
+}
+
+} // namespace
+
+/******************************************/
+
+bool WriteRunColumns(const std::string& path, const std::vector<RunLog>& runs)
+{
+   ColumnTable table ;
+   Column& name = table.Add("NAME", COL_STRING) ;
+   Column& run = table.Add("RUN", COL_STRING) ;
+   Column& app = table.Add("APP", COL_STRING) ;
+   Column& patch = table.Add("PATCH", COL_STRING) ;
+   Column& mode = table.Add("MODE", COL_STRING) ;
+   Column& iter = table.Add("ITER", COL_INT) ;
+   Column& time = table.Add("TIME", COL_REAL) ;
+   Column& maxMemory = table.Add("MAX_MEMORY", COL_INT) ;
+   Column& traceSize = table.Add("TRACE_SIZE", COL_INT) ;
+   Column& pallasCommit = table.Add("PALLAS_COMMIT", COL_STRING) ;
+   Column& eztraceCommit = table.Add("EZTRACE_COMMIT", COL_STRING) ;
+   Column& buildFlags = table.Add("BUILD_FLAGS", COL_STRING) ;
+   Column& host = table.Add("HOST", COL_STRING) ;
+
+   for (const RunLog& r : runs) {
+      name.AddString(ShortName(r.app)) ;
+      run.AddString(r.run) ;
+      app.AddString(r.app) ;
+      patch.AddString(r.patch) ;
+      mode.AddString(r.mode) ;
+      iter.ints.push_back(r.iter) ;
+      time.reals.push_back(r.hasTime ? r.time : std::nan("")) ;
+      maxMemory.ints.push_back(r.hasMaxMemory ? r.maxMemory : -1) ;
+      traceSize.ints.push_back(r.traceSize) ;
+      pallasCommit.AddString(r.pallasCommit) ;
+      eztraceCommit.AddString(r.eztraceCommit) ;
+      buildFlags.AddString(r.buildFlags) ;
+      host.AddString(r.host) ;
+   }
+   return table.Write(path, runs.size()) ;
+}
+
+/******************************************/
+
+bool WriteTimerColumns(const std::string& path, const std::vector<RunLog>& runs)
+{
+   static const char *fieldNames[5] = { "n_calls", "total_time", "min", "max", "mean" } ;
+
+   ColumnTable table ;
+   Column& source = table.Add("source", COL_STRING) ;
+   Column& run = table.Add("run", COL_STRING) ;
+   Column& patch = table.Add("patch", COL_STRING) ;
+   Column& mode = table.Add("mode", COL_STRING) ;
+   Column& iter = table.Add("iter", COL_INT) ;
+   Column& algo = table.Add("algo", COL_STRING) ;
+   Column *fields[5] ;
+   for (int i = 0; i < 5; ++i)
+      fields[i] = &table.Add(fieldNames[i], COL_REAL) ;
+
+   uint64_t nrows = 0 ;
+   for (const RunLog& r : runs) {
+      for (const TimerLine& timer : r.timers) {
+         source.AddString(ShortName(r.app)) ;
+         run.AddString(r.run) ;
+         patch.AddString(r.patch) ;
+         mode.AddString(r.mode) ;
+         iter.ints.push_back(r.iter) ;
+         algo.AddString(timer.name) ;
+         for (int i = 0; i < 5; ++i)
+            fields[i]->reals.push_back(std::strtod(timer.fields[i].c_str(), nullptr)) ;
+         ++nrows ;
+      }
+   }
+   return table.Write(path, nrows) ;
+}
@@ -0,0 +1,255 @@
+/*
+ * Compares two result sets written by the aggregator (their runs.csv) and
+ * flags the statistically significant changes of time, memory and trace
+ * size, for each (app, run, patch, mode) found in both.
+ *
+ * A metric is a regression when the new runs are larger with a one-sided
+ * Mann-Whitney U test at level <alpha> and the medians differ by more than
+ * <threshold> percent; an improvement symmetrically. The test makes no
+ * assumption on the distributions, which are skewed for run times.
+ *
+ * One row per metric and group is written to <output> (stdout by default):
+ *    APP,RUN,PATCH,MODE,METRIC,N_BASE,N_NEW,MEDIAN_BASE,MEDIAN_NEW,
+ *    CHANGE_PCT,P_VALUE,STATUS
+ * and the commits of both sets are printed on stderr.
+ *
+ * The exit status suits `git bisect run`: 0 without regression, 1 with one,
+ * 125 (skip) when the result sets cannot be compared.
+ *
+ * Usage: compare [-a <alpha>] [-t <threshold>] [-o <output>]
+ *                <base/runs.csv> <new/runs.csv>
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <tuple>
+
+#include "aggregator.h"
+
+namespace {
+
+const int EXIT_REGRESSION = 1 ;
+const int EXIT_SKIP = 125 ;
+
+const char *metrics[] = { "TIME", "MAX_MEMORY", "TRACE_SIZE" } ;
+const int NUM_METRICS = 3 ;
+
+typedef std::tuple<std::string, std::string, std::string, std::string> GroupKey ;
+
+struct Group
+{
+   std::vector<double> values[NUM_METRICS] ;
+} ;
+
+struct ResultSet
+{
+   std::map<GroupKey, Group> groups ;
+   std::set<std::string> commits ;
+} ;
+
+std::vector<std::string> Split(const std::string& line)
+{
+   std::vector<std::string> fields ;
+   std::stringstream in(line) ;
+   std::string field ;
+   while (std::getline(in, field, ','))
+      fields.push_back(field) ;
+   if (!line.empty() && line.back() == ',')
+      fields.push_back("") ;
+   return fields ;
+}
+
+/* Columns are found by name, runs.csv of older aggregators have no
+ * TRACE_SIZE nor commits */
+bool ReadRuns(const std::string& path, ResultSet& set)
+{
+   std::ifstream in(path) ;
+   std::string line ;
+   if (!in || !std::getline(in, line)) {
+      std::cerr << "compare: cannot read " << path << std::endl ;
+      return false ;
+   }
+   std::vector<std::string> header = Split(line) ;
+   auto column = [&](const char *name) {
+      auto it = std::find(header.begin(), header.end(), name) ;
+      return it == header.end() ? -1 : static_cast<int>(it - header.begin()) ;
+   } ;
+   int app = column("APP"), run = column("RUN"), patch = column("PATCH"), mode = column("MODE") ;
+   int pallas = column("PALLAS_COMMIT"), eztrace = column("EZTRACE_COMMIT") ;
+   int metric[NUM_METRICS] ;
+   for (int m = 0; m < NUM_METRICS; ++m)
+      metric[m] = column(metrics[m]) ;
+   if (app < 0 || run < 0 || patch < 0 || mode < 0) {
+      std::cerr << "compare: " << path << " is not a runs.csv" << std::endl ;
+      return false ;
+   }
+
+   while (std::getline(in, line)) {
+      std::vector<std::string> f = Split(line) ;
+      f.resize(header.size()) ;
+      Group& g = set.groups[{f[app], f[run], f[patch], f[mode]}] ;
+      for (int m = 0; m < NUM_METRICS; ++m) {
+         if (metric[m] >= 0 && !f[metric[m]].empty())
+            g.values[m].push_back(std::strtod(f[metric[m]].c_str(), nullptr)) ;
+      }
+      if (pallas >= 0 && !f[pallas].empty())
+         set.commits.insert("pallas " + f[pallas] +
+                            (eztrace >= 0 ? ", eztrace " + f[eztrace] : "")) ;
+   }
+   return true ;
+}
+
+/* P(new > base) under the null hypothesis, from the normal approximation of
+ * the U statistic with the correction for ties. Returns 1 for empty samples
+ * or all-equal values. */
+double MannWhitneyGreater(const std::vector<double>& base, const std::vector<double>& cand)
+{
+   size_t n1 = base.size(), n2 = cand.size() ;
+   if (n1 == 0 || n2 == 0)
+      return 1.0 ;
+
+   std::vector<std::pair<double, int>> all ;
+   for (double v : base)
+      all.push_back({v, 0}) ;
+   for (double v : cand)
+      all.push_back({v, 1}) ;
+   std::sort(all.begin(), all.end()) ;
+
+   /* Midranks */
+   double rankSum = 0.0, ties = 0.0 ;
+   size_t n = all.size() ;
+   for (size_t i = 0; i < n; ) {
+      size_t j = i ;
+      while (j < n && all[j].first == all[i].first)
+         ++j ;
+      double rank = (i + 1 + j) / 2.0 ;
+      double t = static_cast<double>(j - i) ;
+      ties += t * t * t - t ;
+      for (size_t k = i; k < j; ++k)
+         if (all[k].second == 1)
+            rankSum += rank ;
+      i = j ;
+   }
+
+   double u = rankSum - n2 * (n2 + 1) / 2.0 ;
+   double mean = n1 * n2 / 2.0 ;
+   double var = n1 * n2 / 12.0 * ((n + 1) - ties / (n * (n - 1.0))) ;
+   if (!(var > 0))
+      return 1.0 ;
+   double z = (u - mean - 0.5) / std::sqrt(var) ;
+   return 0.5 * std::erfc(z / std::sqrt(2.0)) ;
+}
+
+void Usage(const char *prog)
+{
+   std::cerr << "Usage: " << prog << " [-a <alpha>] [-t <threshold>] [-o <output>]"
+             << " <base/runs.csv> <new/runs.csv>" << std::endl ;
+}
+
+} // namespace
+
+/******************************************/
+
+int main(int argc, char *argv[])
+{
+   double alpha = 0.01 ;
+   double threshold = 2.0 ;   /* percent of the base median */
+   std::string output ;
+   std::vector<std::string> inputs ;
+
+   for (int i = 1; i < argc; ++i) {
+      if (std::strcmp(argv[i], "-a") == 0 && i + 1 < argc) {
+         alpha = std::atof(argv[++i]) ;
+      }
+      else if (std::strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+         threshold = std::atof(argv[++i]) ;
+      }
+      else if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+         output = argv[++i] ;
+      }
+      else if (argv[i][0] == '-') {
+         Usage(argv[0]) ;
+         return EXIT_SKIP ;
+      }
+      else {
+         inputs.push_back(argv[i]) ;
+      }
+   }
+   if (inputs.size() != 2) {
+      Usage(argv[0]) ;
+      return EXIT_SKIP ;
+   }
+
+   ResultSet base, cand ;
+   if (!ReadRuns(inputs[0], base) || !ReadRuns(inputs[1], cand))
+      return EXIT_SKIP ;
+   for (const auto& [label, set] : { std::make_pair("base", &base), std::make_pair("new", &cand) }) {
+      std::cerr << label << ":" ;
+      for (const std::string& c : set->commits)
+         std::cerr << " [" << c << "]" ;
+      std::cerr << (set->commits.empty() ? " unknown commits" : "") << std::endl ;
+   }
+
+   std::ofstream file ;
+   if (!output.empty()) {
+      file.open(output) ;
+      if (!file) {
+         std::cerr << "compare: cannot write " << output << std::endl ;
+         return EXIT_SKIP ;
+      }
+   }
+   std::ostream& out = output.empty() ? std::cout : file ;
+   out << "APP,RUN,PATCH,MODE,METRIC,N_BASE,N_NEW,MEDIAN_BASE,MEDIAN_NEW,"
+          "CHANGE_PCT,P_VALUE,STATUS\n" ;
+
+   int compared = 0, regressions = 0 ;
+   for (const auto& [key, b] : base.groups) {
+      auto it = cand.groups.find(key) ;
+      if (it == cand.groups.end())
+         continue ;
+      const Group& c = it->second ;
+      for (int m = 0; m < NUM_METRICS; ++m) {
+         if (b.values[m].empty() || c.values[m].empty())
+            continue ;
+         ++compared ;
+         double medBase = Median(b.values[m]) ;
+         double medNew = Median(c.values[m]) ;
+         double change = medBase != 0 ? 100.0 * (medNew - medBase) / std::fabs(medBase) : 0.0 ;
+         double pWorse = MannWhitneyGreater(b.values[m], c.values[m]) ;
+         double pBetter = MannWhitneyGreater(c.values[m], b.values[m]) ;
+
+         const char *status = "unchanged" ;
+         double p = std::min(pWorse, pBetter) ;
+         if (pWorse < alpha && change > threshold) {
+            status = "regression" ;
+            ++regressions ;
+            std::cerr << "regression: " << std::get<0>(key) << " " << std::get<1>(key)
+                      << (std::get<2>(key).empty() ? "" : "/" + std::get<2>(key))
+                      << " " << std::get<3>(key) << " " << metrics[m] << " "
+                      << FormatReal(change) << "% (p = " << FormatReal(pWorse) << ")" << std::endl ;
+         }
+         else if (pBetter < alpha && change < -threshold) {
+            status = "improvement" ;
+         }
+
+         out << std::get<0>(key) << "," << std::get<1>(key) << "," << std::get<2>(key) << ","
+             << std::get<3>(key) << "," << metrics[m] << ","
+             << b.values[m].size() << "," << c.values[m].size() << ","
+             << FormatReal(medBase) << "," << FormatReal(medNew) << ","
+             << FormatReal(change) << "," << FormatReal(p) << "," << status << "\n" ;
+      }
+   }
+
+   if (compared == 0) {
+      std::cerr << "compare: no group in common" << std::endl ;
+      return EXIT_SKIP ;
+   }
+   return regressions > 0 ? EXIT_REGRESSION : 0 ;
+}
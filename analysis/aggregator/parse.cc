@@ -0,0 +1,232 @@
+#include <cctype>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <set>
+#include <string_view>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "aggregator.h"
+
+namespace fs = std::filesystem ;
+
+/******************************************/
+
+static bool IsNumber(std::string_view s)
+{
+   double value ;
+   auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value) ;
+   return !s.empty() && ec == std::errc() && end == s.data() + s.size() ;
+}
+
+/******************************************/
+
+static bool IsIdentifier(std::string_view s)
+{
+   if (s.empty() || std::isdigit(static_cast<unsigned char>(s[0])))
+      return false ;
+   for (char c : s) {
+      if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_')
+         return false ;
+   }
+   return true ;
+}
+
+/******************************************/
+
+static std::string_view Trim(std::string_view s)
+{
+   size_t begin = s.find_first_not_of(" \t\r") ;
+   if (begin == std::string_view::npos)
+      return {} ;
+   size_t end = s.find_last_not_of(" \t\r") ;
+   return s.substr(begin, end - begin + 1) ;
+}
+
+/******************************************/
+
+/* Returns the text following `tag` on the line, or an empty view */
+static std::string_view TagValue(std::string_view line, std::string_view tag)
+{
+   size_t pos = line.find(tag) ;
+   if (pos == std::string_view::npos)
+      return {} ;
+   return Trim(line.substr(pos + tag.size())) ;
+}
+
+/******************************************/
+
+/* name,n_calls,total_time,min,max,mean
+ * The separators are found with memchr, which the libc vectorizes, and most
+ * lines of a log are rejected on their first field. */
+static bool ParseTimerLine(std::string_view line, TimerLine& timer)
+{
+   const char *cur = line.data() ;
+   const char *last = line.data() + line.size() ;
+   std::string_view fields[6] ;
+
+   for (int i = 0; i < 6; ++i) {
+      const char *sep = static_cast<const char *>(std::memchr(cur, ',', last - cur)) ;
+      if ((i < 5) == (sep == nullptr))
+         return false ;
+      if (sep == nullptr)
+         sep = last ;
+      fields[i] = Trim(std::string_view(cur, sep - cur)) ;
+      if (i == 0 && !IsIdentifier(fields[0]))
+         return false ;
+      cur = sep + 1 ;
+   }
+   for (int i = 1; i < 6; ++i) {
+      if (!IsNumber(fields[i]))
+         return false ;
+   }
+
+   timer.name.assign(fields[0]) ;
+   for (int i = 1; i < 6; ++i)
+      timer.fields[i-1].assign(fields[i]) ;
+   return true ;
+}
+
+/******************************************/
+
+/* <app>_<iter>_<mode>.log or <app>_<mode>.log */
+bool ParseLogName(const std::string& path, RunLog& run)
+{
+   fs::path p(path) ;
+   if (p.extension() != ".log")
+      return false ;
+
+   std::string stem = p.stem().string() ;
+   size_t sep = stem.rfind('_') ;
+   if (sep == std::string::npos || sep == 0)
+      return false ;
+
+   run.path = path ;
+   run.mode = stem.substr(sep + 1) ;
+   run.app = stem.substr(0, sep) ;
+   run.iter = 0 ;
+
+   sep = run.app.rfind('_') ;
+   if (sep != std::string::npos && sep > 0) {
+      std::string iter = run.app.substr(sep + 1) ;
+      if (!iter.empty() &&
+          iter.find_first_not_of("0123456789") == std::string::npos) {
+         run.iter = std::atoi(iter.c_str()) ;
+         run.app = run.app.substr(0, sep) ;
+      }
+   }
+
+   return true ;
+}
+
+/******************************************/
+
+static void ParseLine(std::string_view line, RunLog& run, TimerLine& timer)
+{
+   std::string_view value ;
+   if (!(value = TagValue(line, "[TIME]")).empty()) {
+      if (IsNumber(value)) {
+         run.hasTime = true ;
+         std::from_chars(value.data(), value.data() + value.size(), run.time) ;
+         run.timeText.assign(value) ;
+      }
+   }
+   else if (!(value = TagValue(line, "[MAX_MEMORY]")).empty()) {
+      if (IsNumber(value)) {
+         run.hasMaxMemory = true ;
+         std::from_chars(value.data(), value.data() + value.size(), run.maxMemory) ;
+      }
+   }
+   else if (!(value = TagValue(line, "[PALLAS_COMMIT]")).empty()) {
+      run.pallasCommit.assign(value) ;
+   }
+   else if (!(value = TagValue(line, "[EZTRACE_COMMIT]")).empty()) {
+      run.eztraceCommit.assign(value) ;
+   }
+   else if (!(value = TagValue(line, "[BUILD_FLAGS]")).empty()) {
+      run.buildFlags.assign(value) ;
+   }
+   else if (!(value = TagValue(line, "[HOST]")).empty()) {
+      run.host.assign(value) ;
+   }
+   else if (ParseTimerLine(line, timer)) {
+      run.timers.push_back(timer) ;
+   }
+}
+
+/******************************************/
+
+/* The log is mapped read-only and split on '\n' in place, nothing is copied
+ * but the fields we keep */
+bool ParseLog(const std::string& path, RunLog& run)
+{
+   int fd = open(path.c_str(), O_RDONLY) ;
+   if (fd < 0)
+      return false ;
+
+   struct stat st ;
+   if (fstat(fd, &st) != 0) {
+      close(fd) ;
+      return false ;
+   }
+   if (st.st_size == 0) {
+      close(fd) ;
+      return true ;
+   }
+
+   size_t size = static_cast<size_t>(st.st_size) ;
+   void *map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) ;
+   close(fd) ;
+   if (map == MAP_FAILED)
+      return false ;
+   madvise(map, size, MADV_SEQUENTIAL) ;
+
+   const char *cur = static_cast<const char *>(map) ;
+   const char *last = cur + size ;
+   TimerLine timer ;
+   while (cur < last) {
+      const char *eol = static_cast<const char *>(std::memchr(cur, '\n', last - cur)) ;
+      if (eol == nullptr)
+         eol = last ;
+      ParseLine(std::string_view(cur, eol - cur), run, timer) ;
+      cur = eol + 1 ;
+   }
+
+   munmap(map, size) ;
+   return true ;
+}
+
+/******************************************/
+
+/* Apparent size of a directory tree, counting the directories themselves
+ * and hard links once, like `du -sb` */
+uint64_t TraceDirSize(const std::string& path)
+{
+   std::set<std::pair<dev_t, ino_t>> seen ;
+   uint64_t size = 0 ;
+
+   auto account = [&](const fs::path& entry) {
+      struct stat st ;
+      if (lstat(entry.c_str(), &st) != 0)
+         return ;
+      if (st.st_nlink > 1 && !S_ISDIR(st.st_mode) &&
+          !seen.insert({st.st_dev, st.st_ino}).second)
+         return ;
+      size += st.st_size ;
+   } ;
+
+   account(path) ;
+   std::error_code ec ;
+   for (fs::recursive_directory_iterator it(path, ec), end; it != end; it.increment(ec)) {
+      if (ec)
+         break ;
+      account(it->path()) ;
+   }
+   return size ;
+}
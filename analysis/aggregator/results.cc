@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <tuple>
+
+#include "aggregator.h"
+
+/******************************************/
+
+/* bt.C.x -> bt, the name used in every res/ file */
+std::string ShortName(const std::string& app)
+{
+   return app.substr(0, app.find('.')) ;
+}
+
+/******************************************/
+
+std::string FormatReal(double value)
+{
+   char buf[64] ;
+   std::snprintf(buf, sizeof(buf), "%.10g", value) ;
+   return buf ;
+}
+
+/******************************************/
+
+namespace {
+
+struct Stats
+{
+   int count = 0 ;
+   double sum = 0.0 ;
+   double min = 0.0 ;
+   double max = 0.0 ;
+
+   void Add(double value)
+   {
+      if (count == 0 || value < min)
+         min = value ;
+      if (count == 0 || value > max)
+         max = value ;
+      sum += value ;
+      ++count ;
+   }
+
+   double Mean() const { return count ? sum / count : 0.0 ; }
+} ;
+
+std::ofstream OpenResult(const std::string& resDir, const char *name,
+                         const char *header)
+{
+   std::string path = resDir + "/" + name ;
+   std::ofstream out(path) ;
+   if (!out)
+      std::cerr << "aggregator: cannot write " << path << std::endl ;
+   out << header << "\n" ;
+   return out ;
+}
+
+/* Split of the eztrace overhead of one run, in seconds, from the Pallas
+ * timers (ns) of its log. write_vector and write_duration_vector wrap the
+ * serialization of the vectors, which contains the compression and the
+ * file writes; what the timers do not cover is event recording and
+ * grammar detection.
+ *
+ * This is an approximation: the timer totals are summed over the threads
+ * of the last process that wrote them while the overhead is wall-clock
+ * time, and nothing checks that zstd and write really nest inside the
+ * vector timers. A phase can come out negative when these assumptions do
+ * not hold; such runs are reported. */
+struct Phases
+{
+   double record = 0.0 ;
+   double serialize = 0.0 ;
+   double compress = 0.0 ;
+   double write = 0.0 ;
+} ;
+
+const double TIMER_UNIT = 1e-9 ;
+
+Phases SplitOverhead(const RunLog& eztrace, double overhead)
+{
+   double vectors = 0.0 ;
+   Phases p ;
+   for (const TimerLine& timer : eztrace.timers) {
+      double total = std::strtod(timer.fields[1].c_str(), nullptr) * TIMER_UNIT ;
+      if (timer.name == "write_vector" || timer.name == "write_duration_vector")
+         vectors += total ;
+      else if (timer.name == "zstd")
+         p.compress += total ;
+      else if (timer.name == "write")
+         p.write += total ;
+   }
+   p.serialize = vectors - p.compress - p.write ;
+   p.record = overhead - vectors ;
+   return p ;
+}
+
+void WriteModeMeans(const std::string& resDir,
+                    const std::map<std::string, Stats>& means,
+                    const char *file, const char *header)
+{
+   std::ofstream out = OpenResult(resDir, file, header) ;
+   for (const auto& [name, s] : means) {
+      out << name << "," << FormatReal(s.Mean()) << ","
+          << FormatReal(s.min) << "," << FormatReal(s.max) << "\n" ;
+   }
+}
+
+} // namespace
+
+/******************************************/
+
+void WriteResults(const std::string& resDir, const std::string& refRun,
+                  const std::vector<RunLog>& runs,
+                  const std::vector<TraceSize>& traces)
+{
+   /* Every run, grouped by (app, patch, mode) */
+   {
+      std::ofstream out = OpenResult(resDir, "runs.csv",
+                                     "NAME,RUN,APP,PATCH,MODE,ITER,TIME,MAX_MEMORY,TRACE_SIZE,"
+                                     "PALLAS_COMMIT,EZTRACE_COMMIT,BUILD_FLAGS,HOST") ;
+      for (const RunLog& run : runs) {
+         out << ShortName(run.app) << "," << run.run << "," << run.app << ","
+             << run.patch << ","
+             << run.mode << "," << run.iter << ","
+             << (run.hasTime ? run.timeText : "") << ","
+             << (run.hasMaxMemory ? std::to_string(run.maxMemory) : "") << ","
+             << (run.traceSize >= 0 ? std::to_string(run.traceSize) : "") << ","
+             << run.pallasCommit << "," << run.eztraceCommit << ","
+             << run.buildFlags << "," << run.host << "\n" ;
+      }
+   }
+   {
+      std::map<std::tuple<std::string, std::string, std::string, std::string>,
+               std::pair<Stats, Stats>> groups ;
+      for (const RunLog& run : runs) {
+         auto& g = groups[{ShortName(run.app), run.run, run.patch, run.mode}] ;
+         if (run.hasTime)
+            g.first.Add(run.time) ;
+         if (run.hasMaxMemory)
+            g.second.Add(static_cast<double>(run.maxMemory)) ;
+      }
+      std::ofstream out = OpenResult(resDir, "summary.csv",
+                                     "NAME,RUN,PATCH,MODE,N,MEAN_TIME,MIN_TIME,MAX_TIME,MEAN_MAX_MEMORY") ;
+      for (const auto& [key, g] : groups) {
+         const Stats& t = g.first ;
+         out << std::get<0>(key) << "," << std::get<1>(key) << ","
+             << std::get<2>(key) << "," << std::get<3>(key) << ","
+             << t.count << ","
+             << FormatReal(t.Mean()) << "," << FormatReal(t.min) << ","
+             << FormatReal(t.max) << ","
+             << (g.second.count ? FormatReal(g.second.Mean()) : "") << "\n" ;
+      }
+   }
+
+   /* The files read by overhead.py, for the runs of refRun without a patch.
+    * Vanilla and eztrace runs are paired by (app, iteration), not by
+    * their order in the log directory. */
+   std::ofstream durations = OpenResult(resDir, "durations.csv", "NAME,TIME") ;
+   std::map<std::pair<std::string, int>, std::pair<const RunLog*, const RunLog*>> pairs ;
+   std::map<std::string, Stats> vanilla, eztrace ;
+
+   for (const RunLog& run : runs) {
+      if (run.run != refRun || !run.patch.empty() || !run.hasTime)
+         continue ;
+      std::string name = ShortName(run.app) ;
+      durations << name << "," << run.timeText << "\n" ;
+
+      auto& pair = pairs[{run.app, run.iter}] ;
+      if (run.mode == "vanilla") {
+         vanilla[name].Add(run.time) ;
+         pair.first = &run ;
+      }
+      else if (run.mode == "eztrace") {
+         eztrace[name].Add(run.time) ;
+         pair.second = &run ;
+      }
+   }
+
+   WriteModeMeans(resDir, vanilla, "nas_vanilla_time_mean.csv",
+                  "NAME,MEAN_VANILLA,MIN_VANILLA,MAX_VANILLA") ;
+   WriteModeMeans(resDir, eztrace, "nas_eztrace_time_mean.csv",
+                  "NAME,MEAN_EZTRACE,MIN_EZTRACE,MAX_EZTRACE") ;
+
+   {
+      std::ofstream out = OpenResult(resDir, "overhead.csv", "NAME,DIFF") ;
+      std::map<std::string, Stats> overhead ;
+      std::map<std::string, std::pair<int, Phases>> phases ;
+      std::map<std::string, int> negative ;
+      for (const auto& [key, pair] : pairs) {
+         if (!pair.first || !pair.second) {
+            std::cerr << "aggregator: no " << (pair.first ? "eztrace" : "vanilla")
+                      << " run for " << key.first << " iteration " << key.second
+                      << ", skipped" << std::endl ;
+            continue ;
+         }
+         std::string name = ShortName(key.first) ;
+         double diff = std::fabs(pair.second->time - pair.first->time) ;
+         out << name << "," << FormatReal(diff) << "\n" ;
+         overhead[name].Add(diff) ;
+
+         Phases p = SplitOverhead(*pair.second, pair.second->time - pair.first->time) ;
+         if (p.record < 0 || p.serialize < 0 || p.compress < 0 || p.write < 0)
+            negative[name]++ ;
+         auto& sum = phases[name] ;
+         sum.first++ ;
+         sum.second.record += p.record ;
+         sum.second.serialize += p.serialize ;
+         sum.second.compress += p.compress ;
+         sum.second.write += p.write ;
+      }
+
+      std::ofstream mean = OpenResult(resDir, "nas_overhead_mean.csv", "NAME,MEAN_OVH") ;
+      for (const auto& [name, s] : overhead)
+         mean << name << "," << FormatReal(s.Mean()) << "\n" ;
+
+      std::ofstream split = OpenResult(resDir, "overhead_phases.csv",
+                                       "NAME,OVERHEAD,RECORD,SERIALIZE,COMPRESS,WRITE") ;
+      for (const auto& [name, sum] : phases) {
+         double n = sum.first ;
+         if (negative.count(name))
+            std::cerr << "aggregator: " << name << ": " << negative[name] << " of " << sum.first
+                      << " runs have a negative overhead phase, the Pallas timers do not"
+                      << " nest as overhead_phases.csv assumes" << std::endl ;
+         const Phases& p = sum.second ;
+         split << name << ","
+               << FormatReal((p.record + p.serialize + p.compress + p.write) / n) << ","
+               << FormatReal(p.record / n) << "," << FormatReal(p.serialize / n) << ","
+               << FormatReal(p.compress / n) << "," << FormatReal(p.write / n) << "\n" ;
+      }
+   }
+
+   {
+      std::ofstream out = OpenResult(resDir, "trace_size.csv", "SIZE,NAME") ;
+      std::map<std::string, Stats> sizes ;
+      for (const TraceSize& trace : traces) {
+         if (trace.run != refRun || !trace.patch.empty())
+            continue ;
+         out << trace.size << "," << trace.name << "\n" ;
+         sizes[ShortName(trace.name)].Add(static_cast<double>(trace.size)) ;
+      }
+
+      std::ofstream mean = OpenResult(resDir, "nas_trace_size_mean.csv", "NAME,MEAN_SIZE") ;
+      for (const auto& [name, s] : sizes)
+         mean << name << "," << static_cast<uint64_t>(s.Mean() + 0.5) << "\n" ;
+   }
+
+   {
+      std::ofstream out = OpenResult(resDir, "nas_comp_write.csv",
+                                     "source,algo,n_calls,total_time,min,max,mean") ;
+      for (const RunLog& run : runs) {
+         if (run.run != refRun || !run.patch.empty())
+            continue ;
+         for (const TimerLine& timer : run.timers) {
+            out << ShortName(run.app) << "," << timer.name ;
+            for (const std::string& field : timer.fields)
+               out << "," << field ;
+            out << "\n" ;
+         }
+      }
+   }
+}
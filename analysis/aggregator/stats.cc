@@ -0,0 +1,182 @@
+/*
+ * Robust statistics over the runs: medians with bootstrap confidence
+ * intervals, and the eztrace overhead of each (app, run, patch) computed on
+ * vanilla/eztrace runs paired by iteration.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <tuple>
+
+#include "aggregator.h"
+
+/******************************************/
+
+double Median(std::vector<double> values)
+{
+   if (values.empty())
+      return std::nan("") ;
+   size_t mid = values.size() / 2 ;
+   std::nth_element(values.begin(), values.begin() + mid, values.end()) ;
+   double m = values[mid] ;
+   if (values.size() % 2 == 0)
+      m = (m + *std::max_element(values.begin(), values.begin() + mid)) / 2 ;
+   return m ;
+}
+
+/******************************************/
+
+namespace {
+
+const int BOOTSTRAP_SAMPLES = 2000 ;
+const double CI_LEVEL = 0.95 ;
+
+struct Interval
+{
+   double median = std::nan("") ;
+   double low = std::nan("") ;
+   double high = std::nan("") ;
+
+   double HalfWidth() const { return (high - low) / 2 ; }
+} ;
+
+/* Percentile bootstrap of the median. The seed is fixed so that the same
+ * logs always give the same intervals. */
+Interval BootstrapMedian(const std::vector<double>& values)
+{
+   Interval ci ;
+   if (values.empty())
+      return ci ;
+   ci.median = Median(values) ;
+   if (values.size() < 2) {
+      ci.low = ci.high = ci.median ;
+      return ci ;
+   }
+
+   std::mt19937_64 rng(42) ;
+   std::uniform_int_distribution<size_t> pick(0, values.size() - 1) ;
+   std::vector<double> medians(BOOTSTRAP_SAMPLES) ;
+   std::vector<double> sample(values.size()) ;
+   for (double& m : medians) {
+      for (double& s : sample)
+         s = values[pick(rng)] ;
+      m = Median(sample) ;
+   }
+
+   std::sort(medians.begin(), medians.end()) ;
+   double tail = (1.0 - CI_LEVEL) / 2 ;
+   ci.low = medians[static_cast<size_t>(tail * (BOOTSTRAP_SAMPLES - 1))] ;
+   ci.high = medians[static_cast<size_t>((1.0 - tail) * (BOOTSTRAP_SAMPLES - 1))] ;
+   return ci ;
+}
+
+/* The half-width shrinks as 1/sqrt(n) */
+int RequiredRepetitions(const Interval& ci, size_t n, double precision)
+{
+   if (n < 2 || !(ci.HalfWidth() > 0))
+      return static_cast<int>(n) ;
+   double ratio = ci.HalfWidth() / precision ;
+   return std::max(static_cast<int>(n),
+                   static_cast<int>(std::ceil(n * ratio * ratio))) ;
+}
+
+typedef std::tuple<std::string, std::string, std::string> GroupKey ;  /* name, run, patch */
+
+struct Group
+{
+   std::vector<double> vanilla ;
+   std::vector<double> eztrace ;
+   std::vector<double> overhead ;   /* in percent of the vanilla time */
+} ;
+
+std::map<GroupKey, Group> GroupRuns(const std::vector<RunLog>& runs)
+{
+   std::map<GroupKey, Group> groups ;
+   std::map<std::tuple<std::string, std::string, std::string, int>,
+            std::pair<const RunLog*, const RunLog*>> pairs ;
+
+   for (const RunLog& run : runs) {
+      if (!run.hasTime)
+         continue ;
+      Group& g = groups[{ShortName(run.app), run.run, run.patch}] ;
+      auto& pair = pairs[{run.app, run.run, run.patch, run.iter}] ;
+      if (run.mode == "vanilla") {
+         g.vanilla.push_back(run.time) ;
+         pair.first = &run ;
+      }
+      else if (run.mode == "eztrace") {
+         g.eztrace.push_back(run.time) ;
+         pair.second = &run ;
+      }
+   }
+
+   for (const auto& [key, pair] : pairs) {
+      if (!pair.first || !pair.second || !(pair.first->time > 0))
+         continue ;
+      Group& g = groups[{ShortName(std::get<0>(key)), std::get<1>(key), std::get<2>(key)}] ;
+      g.overhead.push_back(100.0 * (pair.second->time / pair.first->time - 1.0)) ;
+   }
+   return groups ;
+}
+
+} // namespace
+
+/******************************************/
+
+void WriteStats(const std::string& resDir, const std::vector<RunLog>& runs,
+                double precision)
+{
+   std::string path = resDir + "/overhead_ci.csv" ;
+   std::ofstream out(path) ;
+   if (!out) {
+      std::cerr << "aggregator: cannot write " << path << std::endl ;
+      return ;
+   }
+
+   out << "NAME,RUN,PATCH,N,MEDIAN_VANILLA,VANILLA_CI_LOW,VANILLA_CI_HIGH,"
+          "MEDIAN_EZTRACE,EZTRACE_CI_LOW,EZTRACE_CI_HIGH,"
+          "MEDIAN_OVH,OVH_CI_LOW,OVH_CI_HIGH,REQUIRED_N\n" ;
+   for (const auto& [key, g] : GroupRuns(runs)) {
+      Interval vanilla = BootstrapMedian(g.vanilla) ;
+      Interval eztrace = BootstrapMedian(g.eztrace) ;
+      Interval overhead = BootstrapMedian(g.overhead) ;
+      out << std::get<0>(key) << "," << std::get<1>(key) << "," << std::get<2>(key) << ","
+          << g.overhead.size() << ","
+          << FormatReal(vanilla.median) << "," << FormatReal(vanilla.low) << ","
+          << FormatReal(vanilla.high) << ","
+          << FormatReal(eztrace.median) << "," << FormatReal(eztrace.low) << ","
+          << FormatReal(eztrace.high) << ","
+          << FormatReal(overhead.median) << "," << FormatReal(overhead.low) << ","
+          << FormatReal(overhead.high) << ","
+          << RequiredRepetitions(overhead, g.overhead.size(), precision) << "\n" ;
+   }
+}
+
+/******************************************/
+
+/* True when every group has at least minReps pairs and an overhead interval
+ * narrower than +/- precision percent, false without any group */
+bool CheckPrecision(const std::vector<RunLog>& runs, double precision, int minReps)
+{
+   std::map<GroupKey, Group> groups = GroupRuns(runs) ;
+   if (groups.empty()) {
+      std::cerr << "no vanilla/eztrace pair with a [TIME] line" << std::endl ;
+      return false ;
+   }
+   bool done = true ;
+   for (const auto& [key, g] : groups) {
+      Interval overhead = BootstrapMedian(g.overhead) ;
+      bool ok = static_cast<int>(g.overhead.size()) >= minReps &&
+                overhead.HalfWidth() <= precision ;
+      std::cerr << std::get<0>(key) << ": n=" << g.overhead.size()
+                << " overhead=" << FormatReal(overhead.median)
+                << "% +/-" << FormatReal(overhead.HalfWidth()) << "%"
+                << (ok ? "" : " (needs more runs)") << std::endl ;
+      done = done && ok ;
+   }
+   return done ;
+}
@@ -0,0 +1,41 @@
+import struct
+import numpy as np
+import pandas as pd
+
+# Reader for the .bin column files written by analysis/aggregator (see columns.cc).
+# Numeric columns are views on the memory-mapped file, nothing is copied.
+# String columns are not: pd.Categorical.from_codes copies their uint32
+# codes into its own (signed, narrower) code array, and the dictionary is
+# decoded into Python strings.
+
+HEADER = struct.Struct("<8sQQ")
+DESC = struct.Struct("<40sIIQQ")
+DTYPES = {0: "<f8", 1: "<i8", 2: "<u4"}
+
+
+def load_columns(path):
+    raw = np.memmap(path, dtype=np.uint8, mode="r")
+    magic, nrows, ncols = HEADER.unpack_from(raw, 0)
+    if magic != b"PALCOL1\0":
+        raise ValueError(f"{path} n'est pas un fichier de colonnes")
+
+    columns = {}
+    for c in range(ncols):
+        name, kind, _, offset, dict_offset = DESC.unpack_from(raw, HEADER.size + c * DESC.size)
+        name = name.rstrip(b"\0").decode()
+        values = np.frombuffer(raw, dtype=DTYPES[kind], count=nrows, offset=offset)
+        if kind == 2:
+            (count,) = struct.unpack_from("<Q", raw, dict_offset)
+            pos = dict_offset + 8
+            strings = []
+            for _ in range(count):
+                (length,) = struct.unpack_from("<I", raw, pos)
+                strings.append(bytes(raw[pos + 4:pos + 4 + length]).decode())
+                pos += 4 + length
+            values = pd.Categorical.from_codes(values, categories=strings)
+        columns[name] = values
+    return columns
+
+
+def load_frame(path):
+    return pd.DataFrame(load_columns(path), copy=False)
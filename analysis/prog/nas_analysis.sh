@@ -1,8 +1,10 @@
 #!/bin/sh
 
-bash $PWD/trace_size.sh
-bash $PWD/overhead.sh
-bash $PWD/nas_overhead_mean.sh
-bash $PWD/nas_trace_size_mean.sh
-bash $PWD/nas_durations_vanilla.sh
-bash $PWD/nas_durations_eztrace.sh
\ No newline at end of file
+agg_dir=$PWD/../aggregator
+nas_root=$PWD/../../run_benchmarks/run_nas_benchmark
+nas_dir=$nas_root/20_iter
+
+cmake -S $agg_dir -B $agg_dir/build > /dev/null && cmake --build $agg_dir/build > /dev/null || exit 1
+
+## The res/*.csv files come from the first directory, the .bin columns from all of them
+$agg_dir/build/aggregator -o $PWD/../res $nas_dir $(ls -d $nas_root/*/ | grep -v NPB3.4-MPI)
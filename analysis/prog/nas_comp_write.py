@@ -1,13 +1,15 @@
 import pandas as pd
 import matplotlib.pyplot as plt
 import numpy as np
+from columns import load_frame
 
 
-df = pd.read_csv("../res/nas_comp_write.csv")
+df = load_frame("../res/nas_comp_write.bin")
+df = df[(df['run'] == "20_iter") & (df['patch'] == "")]
 colonnes = ['n_calls', 'total_time', 'min', 'max', 'mean']
 
 
-mean = df.groupby(['source', 'algo'])[colonnes].mean().reset_index()
+mean = df.groupby(['source', 'algo'], observed=True)[colonnes].mean().reset_index()
 
 mean.to_csv("../res/nas_comp_write_mean.csv", index=False)
 
@@ -0,0 +1,70 @@
+#include <cstdio>
+#include <filesystem>
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+
+#include "bench_result.h"
+
+namespace fs = std::filesystem ;
+
+static const char *RESULT_HEADER =
+   "bench,input,threads,events,seconds,events_per_s,bytes,bytes_per_s,peak_rss_kb" ;
+
+/******************************************/
+
+void ReportResult(BenchResult result, const std::string& path)
+{
+   if (result.peakRssKb == 0) {
+      struct rusage usage ;
+      getrusage(RUSAGE_SELF, &usage) ;
+      result.peakRssKb = usage.ru_maxrss ;
+   }
+
+   double eventsPerS = result.seconds > 0 ? result.events / result.seconds : 0.0 ;
+   double bytesPerS = result.seconds > 0 ? result.bytes / result.seconds : 0.0 ;
+   char row[1024] ;
+   std::snprintf(row, sizeof(row), "%s,%s,%d,%llu,%.6f,%.6g,%llu,%.6g,%ld",
+                 result.bench.c_str(), result.input.c_str(), result.threads,
+                 static_cast<unsigned long long>(result.events), result.seconds,
+                 eventsPerS, static_cast<unsigned long long>(result.bytes),
+                 bytesPerS, result.peakRssKb) ;
+
+   std::printf("%s\n%s\n", RESULT_HEADER, row) ;
+
+   if (path.empty())
+      return ;
+   std::error_code ec ;
+   bool isNew = !fs::exists(path, ec) || fs::file_size(path, ec) == 0 ;
+   FILE *out = std::fopen(path.c_str(), "a") ;
+   if (!out) {
+      std::fprintf(stderr, "Cannot write %s\n", path.c_str()) ;
+      return ;
+   }
+   if (isNew)
+      std::fprintf(out, "%s\n", RESULT_HEADER) ;
+   std::fprintf(out, "%s\n", row) ;
+   std::fclose(out) ;
+}
+
+/******************************************/
+
+uint64_t PathSize(const std::string& path)
+{
+   uint64_t size = 0 ;
+   struct stat st ;
+   if (lstat(path.c_str(), &st) != 0)
+      return 0 ;
+   size += st.st_size ;
+   if (!S_ISDIR(st.st_mode))
+      return size ;
+
+   std::error_code ec ;
+   for (fs::recursive_directory_iterator it(path, ec), end; it != end; it.increment(ec)) {
+      if (ec)
+         break ;
+      if (lstat(it->path().c_str(), &st) == 0)
+         size += st.st_size ;
+   }
+   return size ;
+}
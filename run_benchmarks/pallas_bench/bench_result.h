@@ -0,0 +1,34 @@
+#ifndef BENCH_RESULT_H
+#define BENCH_RESULT_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/* One row of the benchmark results. Every tool of pallas_bench writes the
+ * same columns, so write and read runs land in the same table:
+ * bench,input,threads,events,seconds,events_per_s,bytes,bytes_per_s,peak_rss_kb */
+struct BenchResult
+{
+   std::string bench ;      /* replay, read_full, ... */
+   std::string input ;
+   int threads = 1 ;
+   uint64_t events = 0 ;
+   double seconds = 0.0 ;
+   uint64_t bytes = 0 ;     /* archive bytes written or read */
+   long peakRssKb = 0 ;
+} ;
+
+/* Prints the row on stdout and appends it to `path` when not empty,
+ * with the header if the file is new */
+void ReportResult(BenchResult result, const std::string& path) ;
+
+/* Apparent size of a file or directory tree, like `du -sb` */
+uint64_t PathSize(const std::string& path) ;
+
+inline double SecondsSince(std::chrono::steady_clock::time_point start)
+{
+   return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() ;
+}
+
+#endif
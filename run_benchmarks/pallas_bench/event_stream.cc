@@ -0,0 +1,162 @@
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "event_stream.h"
+
+static const char EVS_MAGIC[8] = "PALEVS1" ;
+
+/******************************************/
+
+EventStream::~EventStream()
+{
+   if (m_map)
+      munmap(m_map, m_size) ;
+}
+
+/******************************************/
+
+bool EventStream::Open(const std::string& path)
+{
+   int fd = open(path.c_str(), O_RDONLY) ;
+   if (fd < 0)
+      return false ;
+   struct stat st ;
+   if (fstat(fd, &st) != 0 || st.st_size < 16) {
+      close(fd) ;
+      return false ;
+   }
+   m_size = static_cast<size_t>(st.st_size) ;
+   m_map = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0) ;
+   close(fd) ;
+   if (m_map == MAP_FAILED) {
+      m_map = nullptr ;
+      return false ;
+   }
+   madvise(m_map, m_size, MADV_SEQUENTIAL) ;
+
+   const char *cur = static_cast<const char *>(m_map) ;
+   const char *last = cur + m_size ;
+   if (std::memcmp(cur, EVS_MAGIC, sizeof(EVS_MAGIC)) != 0)
+      return false ;
+   cur += sizeof(EVS_MAGIC) ;
+
+   uint32_t nregions, nthreads ;
+   std::memcpy(&nregions, cur, sizeof(nregions)) ;
+   std::memcpy(&nthreads, cur + 4, sizeof(nthreads)) ;
+   cur += 8 ;
+
+   m_regions.resize(nregions) ;
+   for (uint32_t r = 0; r < nregions; ++r) {
+      uint32_t len ;
+      if (last - cur < 4)
+         return false ;
+      std::memcpy(&len, cur, sizeof(len)) ;
+      cur += 4 ;
+      if (static_cast<size_t>(last - cur) < len)
+         return false ;
+      m_regions[r].assign(cur, len) ;
+      cur += len ;
+   }
+
+   size_t offset = cur - static_cast<const char *>(m_map) ;
+   cur += (8 - offset % 8) % 8 ;
+
+   m_threads.resize(nthreads) ;
+   for (uint32_t t = 0; t < nthreads; ++t) {
+      if (last - cur < 8)
+         return false ;
+      std::memcpy(&m_threads[t].count, cur, sizeof(uint64_t)) ;
+      cur += 8 ;
+      if (static_cast<uint64_t>(last - cur) / sizeof(Event) < m_threads[t].count)
+         return false ;
+      m_threads[t].events = reinterpret_cast<const Event *>(cur) ;
+      cur += m_threads[t].count * sizeof(Event) ;
+   }
+   return true ;
+}
+
+/******************************************/
+
+uint64_t EventStream::totalEvents() const
+{
+   uint64_t total = 0 ;
+   for (const ThreadEvents& t : m_threads)
+      total += t.count ;
+   return total ;
+}
+
+/******************************************/
+
+bool EventStreamWriter::Open(const std::string& path,
+                             const std::vector<std::string>& regions,
+                             uint32_t nthreads)
+{
+   m_file = std::fopen(path.c_str(), "wb") ;
+   if (!m_file)
+      return false ;
+
+   uint32_t nregions = static_cast<uint32_t>(regions.size()) ;
+   std::fwrite(EVS_MAGIC, sizeof(EVS_MAGIC), 1, m_file) ;
+   std::fwrite(&nregions, sizeof(nregions), 1, m_file) ;
+   std::fwrite(&nthreads, sizeof(nthreads), 1, m_file) ;
+   for (const std::string& name : regions) {
+      uint32_t len = static_cast<uint32_t>(name.size()) ;
+      std::fwrite(&len, sizeof(len), 1, m_file) ;
+      std::fwrite(name.data(), 1, len, m_file) ;
+   }
+   static const char zeros[8] = {} ;
+   long offset = std::ftell(m_file) ;
+   std::fwrite(zeros, 1, (8 - offset % 8) % 8, m_file) ;
+   m_buffer.reserve(BUFFER_EVENTS) ;
+   return true ;
+}
+
+/******************************************/
+
+void EventStreamWriter::Flush()
+{
+   std::fwrite(m_buffer.data(), sizeof(Event), m_buffer.size(), m_file) ;
+   m_count += m_buffer.size() ;
+   m_buffer.clear() ;
+}
+
+/******************************************/
+
+void EventStreamWriter::EndThread()
+{
+   if (m_countPos < 0)
+      return ;
+   Flush() ;
+   off_t end = ftello(m_file) ;
+   fseeko(m_file, m_countPos, SEEK_SET) ;
+   std::fwrite(&m_count, sizeof(m_count), 1, m_file) ;
+   fseeko(m_file, end, SEEK_SET) ;
+   m_countPos = -1 ;
+}
+
+/******************************************/
+
+void EventStreamWriter::BeginThread()
+{
+   EndThread() ;
+   m_count = 0 ;
+   m_countPos = ftello(m_file) ;
+   std::fwrite(&m_count, sizeof(m_count), 1, m_file) ;
+}
+
+/******************************************/
+
+bool EventStreamWriter::Close()
+{
+   if (!m_file)
+      return true ;
+   EndThread() ;
+   bool ok = std::ferror(m_file) == 0 ;
+   ok = (std::fclose(m_file) == 0) && ok ;
+   m_file = nullptr ;
+   return ok ;
+}
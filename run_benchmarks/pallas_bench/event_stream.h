@@ -0,0 +1,94 @@
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+
+/*
+ * Event streams replayed into the Pallas writer (.evs files)
+ *
+ *    char     magic[8]           "PALEVS1"
+ *    uint32_t nregions, nthreads
+ *    nregions x (uint32_t length, name bytes), zero-padded to 8 bytes
+ *    nthreads x (uint64_t nevents, nevents x Event)
+ *
+ * Timestamps are in ns and increase within a thread. A stream is written
+ * either in one go (evs_record) or thread by thread (evs_generate).
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+enum EventKind : uint32_t { EVS_ENTER = 0, EVS_LEAVE = 1 } ;
+
+struct Event
+{
+   uint64_t timestamp ;
+   uint32_t region ;
+   uint32_t kind ;
+} ;
+static_assert(sizeof(Event) == 16, "Event must be 16 bytes") ;
+
+/* A mapped .evs file, the events are read in place */
+class EventStream
+{
+public:
+   EventStream() = default ;
+   ~EventStream() ;
+   EventStream(const EventStream&) = delete ;
+   EventStream& operator=(const EventStream&) = delete ;
+
+   bool Open(const std::string& path) ;
+
+   const std::vector<std::string>& regions() const { return m_regions ; }
+   uint32_t numThreads() const { return static_cast<uint32_t>(m_threads.size()) ; }
+   uint64_t numEvents(uint32_t thread) const { return m_threads[thread].count ; }
+   const Event *events(uint32_t thread) const { return m_threads[thread].events ; }
+   uint64_t totalEvents() const ;
+
+private:
+   struct ThreadEvents
+   {
+      uint64_t count ;
+      const Event *events ;
+   } ;
+
+   void *m_map = nullptr ;
+   size_t m_size = 0 ;
+   std::vector<std::string> m_regions ;
+   std::vector<ThreadEvents> m_threads ;
+} ;
+
+/* Writes a stream thread by thread, the event count of a thread is
+ * patched when the next thread begins */
+class EventStreamWriter
+{
+public:
+   ~EventStreamWriter() { Close() ; }
+
+   bool Open(const std::string& path,
+             const std::vector<std::string>& regions, uint32_t nthreads) ;
+   void BeginThread() ;
+   void Add(uint64_t timestamp, uint32_t region, EventKind kind)
+   {
+      Event e = { timestamp, region, kind } ;
+      m_buffer.push_back(e) ;
+      if (m_buffer.size() == BUFFER_EVENTS)
+         Flush() ;
+   }
+   bool Close() ;
+
+private:
+   static const size_t BUFFER_EVENTS = 1 << 16 ;
+
+   void Flush() ;
+   void EndThread() ;
+
+   FILE *m_file = nullptr ;
+   off_t m_countPos = -1 ;
+   uint64_t m_count = 0 ;
+   std::vector<Event> m_buffer ;
+} ;
+
+#endif
@@ -0,0 +1,223 @@
+/*
+ * Generates synthetic event streams for pallas_replay, to map the writer's
+ * throughput and compression over the shape of the input rather than over
+ * a few applications.
+ *
+ *    evs_generate [options] output.evs
+ *      -t threads      threads in the stream (1)
+ *      -e events       events per thread, at least (1000000)
+ *      -d depth        depth of the call tree in a loop body (3)
+ *      -b fanout       calls made by each function of the tree (2)
+ *      -l loops        loop nesting around the call tree (2)
+ *      -i iterations   iterations of each loop (10)
+ *      -f functions    distinct functions (32)
+ *      -r regularity   probability that an iteration repeats the body (1.0)
+ *      -s noise        relative standard deviation of the durations (0.1)
+ *      -S seed         (42)
+ *
+ * The program is the same on every thread, as in an SPMD application: a
+ * loop nest repeated until the event count is reached, whose body is a
+ * call tree. With regularity < 1, an iteration may call other functions
+ * than the body, which breaks the repetitions Pallas detects. Durations are
+ * drawn around a mean per function, with the given relative noise.
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+#include "event_stream.h"
+
+namespace {
+
+struct Params
+{
+   uint32_t threads = 1 ;
+   uint64_t events = 1000000 ;
+   int depth = 3 ;
+   int fanout = 2 ;
+   int loops = 2 ;
+   int iterations = 10 ;
+   uint32_t functions = 32 ;
+   double regularity = 1.0 ;
+   double noise = 0.1 ;
+   uint64_t seed = 42 ;
+} ;
+
+/* Call tree of a loop body, nodes in preorder */
+struct Node
+{
+   uint32_t region ;
+   std::vector<int> children ;
+} ;
+
+class Generator
+{
+public:
+   Generator(const Params& params, const std::vector<Node>& body,
+             const std::vector<double>& meanDuration, uint32_t thread)
+      : m_params(params), m_body(body), m_meanDuration(meanDuration),
+        m_rng(params.seed * 1000003 + thread + 1)
+   {}
+
+   void Run(EventStreamWriter& writer)
+   {
+      m_writer = &writer ;
+      m_emitted = 0 ;
+      m_time = 0 ;
+      while (m_emitted < m_params.events)
+         Loop(0) ;
+   }
+
+private:
+   void Loop(int level)
+   {
+      if (level == m_params.loops) {
+         if (m_params.regularity < 1.0 && m_uniform(m_rng) >= m_params.regularity)
+            Irregular(0, m_params.depth) ;
+         else
+            Call(0) ;
+         return ;
+      }
+      for (int i = 0; i < m_params.iterations; ++i)
+         Loop(level + 1) ;
+   }
+
+   void Call(int node)
+   {
+      uint32_t region = m_body[node].region ;
+      Enter(region) ;
+      for (int child : m_body[node].children)
+         Call(child) ;
+      Leave(region) ;
+   }
+
+   /* A tree of the body's shape, on random functions */
+   void Irregular(int depth, int maxDepth)
+   {
+      uint32_t region = m_rng() % m_params.functions ;
+      Enter(region) ;
+      if (depth < maxDepth)
+         for (int c = 0; c < m_params.fanout; ++c)
+            Irregular(depth + 1, maxDepth) ;
+      Leave(region) ;
+   }
+
+   void Enter(uint32_t region)
+   {
+      m_writer->Add(m_time, region, EVS_ENTER) ;
+      ++m_emitted ;
+      m_time += Duration(region) ;
+   }
+
+   void Leave(uint32_t region)
+   {
+      m_writer->Add(m_time, region, EVS_LEAVE) ;
+      ++m_emitted ;
+      m_time += Duration(region) / 4 + 1 ;
+   }
+
+   uint64_t Duration(uint32_t region)
+   {
+      double mean = m_meanDuration[region] ;
+      double d = mean ;
+      if (m_params.noise > 0)
+         d += mean * m_params.noise * m_normal(m_rng) ;
+      return d < 1.0 ? 1 : static_cast<uint64_t>(d) ;
+   }
+
+   const Params& m_params ;
+   const std::vector<Node>& m_body ;
+   const std::vector<double>& m_meanDuration ;
+   std::mt19937_64 m_rng ;
+   std::uniform_real_distribution<double> m_uniform{0.0, 1.0} ;
+   std::normal_distribution<double> m_normal{0.0, 1.0} ;
+   EventStreamWriter *m_writer = nullptr ;
+   uint64_t m_emitted = 0 ;
+   uint64_t m_time = 0 ;
+} ;
+
+/******************************************/
+
+int BuildBody(std::vector<Node>& body, int depth, const Params& params, std::mt19937_64& rng)
+{
+   int index = static_cast<int>(body.size()) ;
+   body.push_back({ static_cast<uint32_t>(rng() % params.functions), {} }) ;
+   if (depth < params.depth) {
+      for (int c = 0; c < params.fanout; ++c) {
+         int child = BuildBody(body, depth + 1, params, rng) ;
+         body[index].children.push_back(child) ;
+      }
+   }
+   return index ;
+}
+
+/******************************************/
+
+void Usage(const char *prog)
+{
+   std::fprintf(stderr,
+                "Usage: %s [-t threads] [-e events] [-d depth] [-b fanout] [-l loops]\n"
+                "          [-i iterations] [-f functions] [-r regularity] [-s noise]\n"
+                "          [-S seed] output.evs\n", prog) ;
+   std::exit(1) ;
+}
+
+} // namespace
+
+/******************************************/
+
+int main(int argc, char *argv[])
+{
+   Params params ;
+   int opt ;
+   while ((opt = getopt(argc, argv, "t:e:d:b:l:i:f:r:s:S:h")) != -1) {
+      switch (opt) {
+         case 't': params.threads = std::strtoul(optarg, nullptr, 10) ; break ;
+         case 'e': params.events = std::strtoull(optarg, nullptr, 10) ; break ;
+         case 'd': params.depth = std::atoi(optarg) ; break ;
+         case 'b': params.fanout = std::atoi(optarg) ; break ;
+         case 'l': params.loops = std::atoi(optarg) ; break ;
+         case 'i': params.iterations = std::atoi(optarg) ; break ;
+         case 'f': params.functions = std::strtoul(optarg, nullptr, 10) ; break ;
+         case 'r': params.regularity = std::atof(optarg) ; break ;
+         case 's': params.noise = std::atof(optarg) ; break ;
+         case 'S': params.seed = std::strtoull(optarg, nullptr, 10) ; break ;
+         default: Usage(argv[0]) ;
+      }
+   }
+   if (optind + 1 != argc || params.threads < 1 || params.functions < 1 ||
+       params.depth < 0 || params.fanout < 1 || params.loops < 0 || params.iterations < 1)
+      Usage(argv[0]) ;
+
+   std::vector<std::string> regions ;
+   std::vector<double> meanDuration ;
+   std::mt19937_64 rng(params.seed) ;
+   std::uniform_real_distribution<double> logDuration(std::log(100.0), std::log(100000.0)) ;
+   for (uint32_t f = 0; f < params.functions; ++f) {
+      regions.push_back("function_" + std::to_string(f)) ;
+      meanDuration.push_back(std::exp(logDuration(rng))) ;
+   }
+
+   std::vector<Node> body ;
+   BuildBody(body, 0, params, rng) ;
+
+   EventStreamWriter writer ;
+   if (!writer.Open(argv[optind], regions, params.threads)) {
+      std::fprintf(stderr, "Cannot write %s\n", argv[optind]) ;
+      return 1 ;
+   }
+   for (uint32_t t = 0; t < params.threads; ++t) {
+      writer.BeginThread() ;
+      Generator(params, body, meanDuration, t).Run(writer) ;
+   }
+   if (!writer.Close()) {
+      std::fprintf(stderr, "Cannot write %s\n", argv[optind]) ;
+      return 1 ;
+   }
+   return 0 ;
+}
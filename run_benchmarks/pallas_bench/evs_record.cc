@@ -0,0 +1,265 @@
+/*
+ * PMPI recorder: captures the MPI calls of an application once, the same
+ * events EZTrace's mpi module gives to Pallas, and writes them as an
+ * event stream that pallas_replay feeds to the writer without MPI.
+ *
+ *    EVS_PREFIX=bt mpirun -x LD_PRELOAD=./libevs_record.so -np 64 ./bt.C.x
+ *
+ * writes bt.<rank>.evs at MPI_Finalize (EVS_PREFIX defaults to "trace").
+ * Every thread that calls MPI records into its own buffer and becomes a
+ * thread of the stream, in the order of their first call, so programs
+ * initialized with MPI_THREAD_MULTIPLE are recorded too. Calls made
+ * before MPI_Init/MPI_Init_thread returns are not recorded.
+ */
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "event_stream.h"
+
+namespace {
+
+enum Region : uint32_t {
+   R_SEND, R_RECV, R_ISEND, R_IRECV, R_WAIT, R_WAITALL, R_WAITANY, R_TEST,
+   R_SENDRECV, R_BARRIER, R_BCAST, R_REDUCE, R_ALLREDUCE, R_ALLTOALL,
+   R_ALLTOALLV, R_ALLGATHER, R_GATHER, R_SCATTER, NUM_REGIONS
+} ;
+
+const char *regionNames[NUM_REGIONS] = {
+   "MPI_Send", "MPI_Recv", "MPI_Isend", "MPI_Irecv", "MPI_Wait", "MPI_Waitall",
+   "MPI_Waitany", "MPI_Test", "MPI_Sendrecv", "MPI_Barrier", "MPI_Bcast",
+   "MPI_Reduce", "MPI_Allreduce", "MPI_Alltoall", "MPI_Alltoallv",
+   "MPI_Allgather", "MPI_Gather", "MPI_Scatter"
+} ;
+
+/* Set once origin is, by StartRecording */
+std::atomic<bool> recording(false) ;
+uint64_t origin = 0 ;
+
+/* The buffers outlive their threads, which may exit before MPI_Finalize */
+std::mutex threadsMutex ;
+std::vector<std::unique_ptr<std::vector<Event>>> threadEvents ;
+thread_local std::vector<Event> *myEvents = nullptr ;
+
+inline uint64_t Now()
+{
+   struct timespec ts ;
+   clock_gettime(CLOCK_MONOTONIC, &ts) ;
+   return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec - origin ;
+}
+
+inline void Record(uint32_t region, EventKind kind)
+{
+   if (!recording.load(std::memory_order_acquire))
+      return ;
+   if (!myEvents) {
+      std::unique_ptr<std::vector<Event>> events(new std::vector<Event>) ;
+      events->reserve(1 << 20) ;
+      myEvents = events.get() ;
+      std::lock_guard<std::mutex> lock(threadsMutex) ;
+      threadEvents.push_back(std::move(events)) ;
+   }
+   myEvents->push_back({ Now(), region, kind }) ;
+}
+
+/* Enter on construction, leave on destruction */
+struct Scope
+{
+   uint32_t region ;
+   explicit Scope(uint32_t r) : region(r) { Record(region, EVS_ENTER) ; }
+   ~Scope() { Record(region, EVS_LEAVE) ; }
+} ;
+
+void StartRecording()
+{
+   origin = 0 ;
+   origin = Now() ;
+   recording.store(true, std::memory_order_release) ;
+}
+
+} // namespace
+
+/******************************************/
+
+extern "C" {
+
+int MPI_Init(int *argc, char ***argv)
+{
+   int ret = PMPI_Init(argc, argv) ;
+   StartRecording() ;
+   return ret ;
+}
+
+int MPI_Init_thread(int *argc, char ***argv, int required, int *provided)
+{
+   int ret = PMPI_Init_thread(argc, argv, required, provided) ;
+   StartRecording() ;
+   return ret ;
+}
+
+int MPI_Finalize()
+{
+   int rank = 0 ;
+   PMPI_Comm_rank(MPI_COMM_WORLD, &rank) ;
+
+   const char *prefix = std::getenv("EVS_PREFIX") ;
+   std::string path = std::string(prefix ? prefix : "trace") + "." + std::to_string(rank) + ".evs" ;
+
+   /* The other threads must be done with MPI by now */
+   recording.store(false, std::memory_order_release) ;
+   std::lock_guard<std::mutex> lock(threadsMutex) ;
+
+   EventStreamWriter writer ;
+   std::vector<std::string> names(regionNames, regionNames + NUM_REGIONS) ;
+   uint32_t nthreads = static_cast<uint32_t>(std::max<size_t>(threadEvents.size(), 1)) ;
+   if (writer.Open(path, names, nthreads)) {
+      for (uint32_t t = 0; t < nthreads; ++t) {
+         writer.BeginThread() ;
+         if (t >= threadEvents.size())
+            continue ;
+         for (const Event& e : *threadEvents[t])
+            writer.Add(e.timestamp, e.region, static_cast<EventKind>(e.kind)) ;
+      }
+   }
+   if (!writer.Close())
+      std::fprintf(stderr, "evs_record: cannot write %s\n", path.c_str()) ;
+   threadEvents.clear() ;
+   myEvents = nullptr ;
+
+   return PMPI_Finalize() ;
+}
+
+/******************************************/
+
+int MPI_Send(const void *buf, int count, MPI_Datatype type, int dest, int tag, MPI_Comm comm)
+{
+   Scope s(R_SEND) ;
+   return PMPI_Send(buf, count, type, dest, tag, comm) ;
+}
+
+int MPI_Recv(void *buf, int count, MPI_Datatype type, int source, int tag,
+             MPI_Comm comm, MPI_Status *status)
+{
+   Scope s(R_RECV) ;
+   return PMPI_Recv(buf, count, type, source, tag, comm, status) ;
+}
+
+int MPI_Isend(const void *buf, int count, MPI_Datatype type, int dest, int tag,
+              MPI_Comm comm, MPI_Request *request)
+{
+   Scope s(R_ISEND) ;
+   return PMPI_Isend(buf, count, type, dest, tag, comm, request) ;
+}
+
+int MPI_Irecv(void *buf, int count, MPI_Datatype type, int source, int tag,
+              MPI_Comm comm, MPI_Request *request)
+{
+   Scope s(R_IRECV) ;
+   return PMPI_Irecv(buf, count, type, source, tag, comm, request) ;
+}
+
+int MPI_Wait(MPI_Request *request, MPI_Status *status)
+{
+   Scope s(R_WAIT) ;
+   return PMPI_Wait(request, status) ;
+}
+
+int MPI_Waitall(int count, MPI_Request requests[], MPI_Status statuses[])
+{
+   Scope s(R_WAITALL) ;
+   return PMPI_Waitall(count, requests, statuses) ;
+}
+
+int MPI_Waitany(int count, MPI_Request requests[], int *index, MPI_Status *status)
+{
+   Scope s(R_WAITANY) ;
+   return PMPI_Waitany(count, requests, index, status) ;
+}
+
+int MPI_Test(MPI_Request *request, int *flag, MPI_Status *status)
+{
+   Scope s(R_TEST) ;
+   return PMPI_Test(request, flag, status) ;
+}
+
+int MPI_Sendrecv(const void *sendbuf, int sendcount, MPI_Datatype sendtype, int dest,
+                 int sendtag, void *recvbuf, int recvcount, MPI_Datatype recvtype,
+                 int source, int recvtag, MPI_Comm comm, MPI_Status *status)
+{
+   Scope s(R_SENDRECV) ;
+   return PMPI_Sendrecv(sendbuf, sendcount, sendtype, dest, sendtag,
+                        recvbuf, recvcount, recvtype, source, recvtag, comm, status) ;
+}
+
+int MPI_Barrier(MPI_Comm comm)
+{
+   Scope s(R_BARRIER) ;
+   return PMPI_Barrier(comm) ;
+}
+
+int MPI_Bcast(void *buf, int count, MPI_Datatype type, int root, MPI_Comm comm)
+{
+   Scope s(R_BCAST) ;
+   return PMPI_Bcast(buf, count, type, root, comm) ;
+}
+
+int MPI_Reduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type,
+               MPI_Op op, int root, MPI_Comm comm)
+{
+   Scope s(R_REDUCE) ;
+   return PMPI_Reduce(sendbuf, recvbuf, count, type, op, root, comm) ;
+}
+
+int MPI_Allreduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type,
+                  MPI_Op op, MPI_Comm comm)
+{
+   Scope s(R_ALLREDUCE) ;
+   return PMPI_Allreduce(sendbuf, recvbuf, count, type, op, comm) ;
+}
+
+int MPI_Alltoall(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                 void *recvbuf, int recvcount, MPI_Datatype recvtype, MPI_Comm comm)
+{
+   Scope s(R_ALLTOALL) ;
+   return PMPI_Alltoall(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm) ;
+}
+
+int MPI_Alltoallv(const void *sendbuf, const int sendcounts[], const int sdispls[],
+                  MPI_Datatype sendtype, void *recvbuf, const int recvcounts[],
+                  const int rdispls[], MPI_Datatype recvtype, MPI_Comm comm)
+{
+   Scope s(R_ALLTOALLV) ;
+   return PMPI_Alltoallv(sendbuf, sendcounts, sdispls, sendtype,
+                         recvbuf, recvcounts, rdispls, recvtype, comm) ;
+}
+
+int MPI_Allgather(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                  void *recvbuf, int recvcount, MPI_Datatype recvtype, MPI_Comm comm)
+{
+   Scope s(R_ALLGATHER) ;
+   return PMPI_Allgather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, comm) ;
+}
+
+int MPI_Gather(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+               void *recvbuf, int recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm)
+{
+   Scope s(R_GATHER) ;
+   return PMPI_Gather(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm) ;
+}
+
+int MPI_Scatter(const void *sendbuf, int sendcount, MPI_Datatype sendtype,
+                void *recvbuf, int recvcount, MPI_Datatype recvtype, int root, MPI_Comm comm)
+{
+   Scope s(R_SCATTER) ;
+   return PMPI_Scatter(sendbuf, sendcount, sendtype, recvbuf, recvcount, recvtype, root, comm) ;
+}
+
+} // extern "C"
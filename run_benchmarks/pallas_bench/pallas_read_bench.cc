@@ -0,0 +1,287 @@
+/*
+ * Read-side benchmark of .evs event streams, with the results of
+ * pallas_replay.
+ *
+ *    pallas_read_bench [-t threads] [-T thread] [-w window] [-c cold|warm|both]
+ *                      [-r results.csv] [-n name] trace
+ *
+ * trace is an .evs stream, the baseline of the same events without
+ * encoding; Pallas archives are not read (a reader of them would
+ * implement TraceReader, trace_reader.h). Every measure opens the trace:
+ *    read_full     all the threads, spread over `threads` workers
+ *    read_thread   thread `thread` only
+ *    read_window   the events of a window in the middle of the trace, that
+ *                  spans `window` of its length, on every thread
+ *    read_stats    calls and inclusive time of every function
+ * With a cold cache, the files of the trace are dropped from the page cache
+ * before the measure (dirty pages are not: sync first); with a warm cache
+ * the measure is run once before being timed.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "bench_result.h"
+#include "trace_reader.h"
+
+namespace {
+
+const size_t BATCH_EVENTS = 4096 ;
+
+struct Options
+{
+   int threads = 1 ;
+   uint32_t thread = 0 ;
+   double window = 0.01 ;
+   std::string cache = "both" ;
+   std::string results ;
+   std::string name ;
+   std::string trace ;
+} ;
+
+struct Extent
+{
+   uint64_t first = UINT64_MAX ;
+   uint64_t last = 0 ;
+} ;
+
+/******************************************/
+
+void Usage(const char *prog)
+{
+   std::fprintf(stderr,
+                "Usage: %s [-t threads] [-T thread] [-w window] [-c cold|warm|both]\n"
+                "          [-r results.csv] [-n name] trace\n", prog) ;
+   std::exit(1) ;
+}
+
+/******************************************/
+
+void DropFromCache(const std::vector<std::string>& files)
+{
+   for (const std::string& file : files) {
+      int fd = open(file.c_str(), O_RDONLY) ;
+      if (fd < 0)
+         continue ;
+      posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) ;
+      close(fd) ;
+   }
+}
+
+/******************************************/
+
+std::unique_ptr<TraceReader> Open(const std::string& path)
+{
+   std::unique_ptr<TraceReader> reader = OpenTrace(path) ;
+   if (!reader) {
+      std::fprintf(stderr, "Cannot read trace %s\n", path.c_str()) ;
+      std::exit(1) ;
+   }
+   return reader ;
+}
+
+/******************************************/
+
+/* Reads one thread from `from` to `to`, returns the number of events */
+uint64_t ReadThread(const TraceReader& reader, uint32_t thread,
+                    uint64_t from, uint64_t to, Extent *extent)
+{
+   std::unique_ptr<ThreadCursor> cursor = reader.OpenThread(thread) ;
+   if (from > 0)
+      cursor->Seek(from) ;
+
+   std::vector<Event> batch(BATCH_EVENTS) ;
+   uint64_t count = 0 ;
+   size_t n ;
+   while ((n = cursor->Read(batch.data(), batch.size())) > 0) {
+      size_t kept = n ;
+      if (to != UINT64_MAX)
+         kept = std::upper_bound(batch.begin(), batch.begin() + n, to,
+                                 [](uint64_t t, const Event& e) { return t < e.timestamp ; })
+                - batch.begin() ;
+      count += kept ;
+      if (extent && kept > 0) {
+         extent->first = std::min(extent->first, batch[0].timestamp) ;
+         extent->last = std::max(extent->last, batch[kept - 1].timestamp) ;
+      }
+      if (kept < n)
+         break ;
+   }
+   return count ;
+}
+
+/******************************************/
+
+uint64_t ReadAll(const TraceReader& reader, int nthreads,
+                 uint64_t from, uint64_t to, Extent *extent)
+{
+   std::atomic<uint32_t> next(0) ;
+   std::atomic<uint64_t> total(0) ;
+   std::vector<Extent> extents(nthreads) ;
+   std::vector<std::thread> workers ;
+   for (int w = 0; w < nthreads; ++w) {
+      workers.emplace_back([&, w]() {
+         for (uint32_t t = next++; t < reader.numThreads(); t = next++)
+            total += ReadThread(reader, t, from, to, &extents[w]) ;
+      }) ;
+   }
+   for (std::thread& worker : workers)
+      worker.join() ;
+
+   if (extent) {
+      for (const Extent& e : extents) {
+         extent->first = std::min(extent->first, e.first) ;
+         extent->last = std::max(extent->last, e.last) ;
+      }
+   }
+   return total ;
+}
+
+/******************************************/
+
+/* Calls and inclusive time by function, from the format when it keeps
+ * them, by a replay otherwise. Returns the number of calls */
+uint64_t ComputeStats(const TraceReader& reader)
+{
+   std::vector<FunctionStats> stats ;
+   if (!reader.NativeStats(stats)) {
+      stats.assign(reader.regions().size(), FunctionStats()) ;
+      std::vector<Event> batch(BATCH_EVENTS) ;
+      std::vector<Event> stack ;
+      for (uint32_t t = 0; t < reader.numThreads(); ++t) {
+         std::unique_ptr<ThreadCursor> cursor = reader.OpenThread(t) ;
+         stack.clear() ;
+         size_t n ;
+         while ((n = cursor->Read(batch.data(), batch.size())) > 0) {
+            for (size_t i = 0; i < n; ++i) {
+               const Event& e = batch[i] ;
+               if (e.kind == EVS_ENTER) {
+                  stack.push_back(e) ;
+               }
+               else if (!stack.empty()) {
+                  const Event& enter = stack.back() ;
+                  if (enter.region < stats.size()) {
+                     ++stats[enter.region].calls ;
+                     stats[enter.region].inclusive += e.timestamp - enter.timestamp ;
+                  }
+                  stack.pop_back() ;
+               }
+            }
+         }
+      }
+   }
+
+   uint64_t calls = 0 ;
+   for (const FunctionStats& s : stats)
+      calls += s.calls ;
+   return calls ;
+}
+
+/******************************************/
+
+/* Runs `measure` on a freshly opened trace, with the requested cache */
+void Measure(const Options& opts, const std::string& bench, bool cold, int threads,
+             const std::function<uint64_t(const TraceReader&)>& measure)
+{
+   uint64_t bytes = 0 ;
+   if (cold) {
+      std::vector<std::string> files = Open(opts.trace)->files() ;
+      for (const std::string& file : files)
+         bytes += PathSize(file) ;
+      DropFromCache(files) ;
+   }
+   else {
+      std::unique_ptr<TraceReader> reader = Open(opts.trace) ;
+      for (const std::string& file : reader->files())
+         bytes += PathSize(file) ;
+      measure(*reader) ;
+   }
+
+   auto start = std::chrono::steady_clock::now() ;
+   std::unique_ptr<TraceReader> reader = Open(opts.trace) ;
+   uint64_t events = measure(*reader) ;
+
+   BenchResult result ;
+   result.bench = bench + (cold ? "_cold" : "_warm") ;
+   result.input = opts.name ;
+   result.threads = threads ;
+   result.events = events ;
+   result.seconds = SecondsSince(start) ;
+   result.bytes = bytes ;
+   ReportResult(result, opts.results) ;
+}
+
+} // namespace
+
+/******************************************/
+
+int main(int argc, char *argv[])
+{
+   Options opts ;
+   int opt ;
+   while ((opt = getopt(argc, argv, "t:T:w:c:r:n:h")) != -1) {
+      switch (opt) {
+         case 't': opts.threads = std::atoi(optarg) ; break ;
+         case 'T': opts.thread = std::strtoul(optarg, nullptr, 10) ; break ;
+         case 'w': opts.window = std::atof(optarg) ; break ;
+         case 'c': opts.cache = optarg ; break ;
+         case 'r': opts.results = optarg ; break ;
+         case 'n': opts.name = optarg ; break ;
+         default: Usage(argv[0]) ;
+      }
+   }
+   if (optind + 1 != argc || opts.threads < 1 || opts.window <= 0 ||
+       (opts.cache != "cold" && opts.cache != "warm" && opts.cache != "both"))
+      Usage(argv[0]) ;
+   opts.trace = argv[optind] ;
+   if (opts.name.empty())
+      opts.name = opts.trace ;
+
+   /* Extent of the trace, for the window */
+   Extent extent ;
+   {
+      std::unique_ptr<TraceReader> reader = Open(opts.trace) ;
+      if (opts.thread >= reader->numThreads()) {
+         std::fprintf(stderr, "The trace has %u threads\n", reader->numThreads()) ;
+         return 1 ;
+      }
+      ReadAll(*reader, opts.threads, 0, UINT64_MAX, &extent) ;
+   }
+   uint64_t length = extent.last > extent.first ? extent.last - extent.first : 0 ;
+   uint64_t half = static_cast<uint64_t>(length * std::min(opts.window, 1.0) / 2) ;
+   uint64_t middle = extent.first + length / 2 ;
+   uint64_t from = middle - std::min(half, middle) ;
+   uint64_t to = middle + half ;
+
+   std::vector<bool> modes ;
+   if (opts.cache != "warm")
+      modes.push_back(true) ;
+   if (opts.cache != "cold")
+      modes.push_back(false) ;
+
+   for (bool cold : modes) {
+      Measure(opts, "read_full", cold, opts.threads, [&](const TraceReader& reader) {
+         return ReadAll(reader, opts.threads, 0, UINT64_MAX, nullptr) ;
+      }) ;
+      Measure(opts, "read_thread", cold, 1, [&](const TraceReader& reader) {
+         return ReadThread(reader, opts.thread, 0, UINT64_MAX, nullptr) ;
+      }) ;
+      Measure(opts, "read_window", cold, opts.threads, [&](const TraceReader& reader) {
+         return ReadAll(reader, opts.threads, from, to, nullptr) ;
+      }) ;
+      Measure(opts, "read_stats", cold, 1, [&](const TraceReader& reader) {
+         return ComputeStats(reader) ;
+      }) ;
+   }
+   return 0 ;
+}
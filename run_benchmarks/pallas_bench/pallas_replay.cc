@@ -0,0 +1,252 @@
+/*
+ * Replays recorded event streams into the Pallas writer through its OTF2
+ * interface, at full speed and without MPI. Each thread of each .evs file
+ * is a location, the locations are spread over the worker threads.
+ *
+ *    pallas_replay [-t threads] [-o archive] [-r results.csv] [-n name] file.evs ...
+ *
+ * The vector size is a build option of Pallas: select an install with
+ * LD_LIBRARY_PATH (see run_sweep.sh). The codec comes from the Pallas
+ * configuration file given in PALLAS_CONFIG_PATH.
+ */
+
+#include <otf2/otf2.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "bench_result.h"
+#include "event_stream.h"
+
+namespace {
+
+struct Location
+{
+   const EventStream *stream ;
+   uint32_t file ;
+   uint32_t thread ;
+   OTF2_LocationRef ref ;
+   uint32_t regionBase ;   /* global ref of the stream's first region */
+} ;
+
+std::mutex archiveMutex ;
+
+OTF2_FlushType PreFlush(void *, OTF2_FileType, OTF2_LocationRef, void *, bool)
+{
+   return OTF2_FLUSH ;
+}
+
+OTF2_TimeStamp PostFlush(void *, OTF2_FileType, OTF2_LocationRef)
+{
+   return 0 ;
+}
+
+OTF2_FlushCallbacks flushCallbacks = { PreFlush, PostFlush } ;
+
+/******************************************/
+
+void Usage(const char *prog)
+{
+   std::fprintf(stderr,
+                "Usage: %s [-t threads] [-o archive] [-r results.csv] [-n name] file.evs ...\n",
+                prog) ;
+   std::exit(1) ;
+}
+
+/******************************************/
+
+void ReplayLocation(OTF2_Archive *archive, const Location& loc)
+{
+   OTF2_EvtWriter *writer ;
+   {
+      std::lock_guard<std::mutex> lock(archiveMutex) ;
+      writer = OTF2_Archive_GetEvtWriter(archive, loc.ref) ;
+   }
+   if (!writer) {
+      std::fprintf(stderr, "No event writer for location %llu\n",
+                   static_cast<unsigned long long>(loc.ref)) ;
+      return ;
+   }
+
+   const Event *events = loc.stream->events(loc.thread) ;
+   uint64_t count = loc.stream->numEvents(loc.thread) ;
+   for (uint64_t i = 0; i < count; ++i) {
+      const Event& e = events[i] ;
+      OTF2_RegionRef region = loc.regionBase + e.region ;
+      if (e.kind == EVS_ENTER)
+         OTF2_EvtWriter_Enter(writer, nullptr, e.timestamp, region) ;
+      else
+         OTF2_EvtWriter_Leave(writer, nullptr, e.timestamp, region) ;
+   }
+
+   std::lock_guard<std::mutex> lock(archiveMutex) ;
+   OTF2_Archive_CloseEvtWriter(archive, writer) ;
+}
+
+/******************************************/
+
+void WriteDefinitions(OTF2_Archive *archive,
+                      const std::vector<std::unique_ptr<EventStream>>& streams,
+                      const std::vector<std::string>& files,
+                      const std::vector<Location>& locations,
+                      uint64_t traceLength)
+{
+   OTF2_GlobalDefWriter *defs = OTF2_Archive_GetGlobalDefWriter(archive) ;
+
+#if defined(OTF2_VERSION_MAJOR) && OTF2_VERSION_MAJOR >= 3
+   OTF2_GlobalDefWriter_WriteClockProperties(defs, 1000000000, 0, traceLength,
+                                             OTF2_UNDEFINED_TIMESTAMP) ;
+#else
+   OTF2_GlobalDefWriter_WriteClockProperties(defs, 1000000000, 0, traceLength) ;
+#endif
+
+   OTF2_StringRef nextString = 0 ;
+   OTF2_GlobalDefWriter_WriteString(defs, nextString, "") ;
+   OTF2_StringRef empty = nextString++ ;
+   OTF2_GlobalDefWriter_WriteString(defs, nextString, "replay") ;
+   OTF2_StringRef machine = nextString++ ;
+   OTF2_GlobalDefWriter_WriteSystemTreeNode(defs, 0, machine, machine, OTF2_UNDEFINED_SYSTEM_TREE_NODE) ;
+
+   /* Regions are numbered stream after stream, in the order of Location::regionBase */
+   OTF2_RegionRef region = 0 ;
+   for (const std::unique_ptr<EventStream>& stream : streams) {
+      for (const std::string& name : stream->regions()) {
+         OTF2_GlobalDefWriter_WriteString(defs, nextString, name.c_str()) ;
+         OTF2_GlobalDefWriter_WriteRegion(defs, region++, nextString, nextString, empty,
+                                          OTF2_REGION_ROLE_FUNCTION, OTF2_PARADIGM_MPI,
+                                          OTF2_REGION_FLAG_NONE, empty, 0, 0) ;
+         ++nextString ;
+      }
+   }
+
+   for (uint32_t f = 0; f < files.size(); ++f) {
+      OTF2_GlobalDefWriter_WriteString(defs, nextString, files[f].c_str()) ;
+#if defined(OTF2_VERSION_MAJOR) && OTF2_VERSION_MAJOR >= 3
+      OTF2_GlobalDefWriter_WriteLocationGroup(defs, f, nextString, OTF2_LOCATION_GROUP_TYPE_PROCESS,
+                                              0, OTF2_UNDEFINED_LOCATION_GROUP) ;
+#else
+      OTF2_GlobalDefWriter_WriteLocationGroup(defs, f, nextString, OTF2_LOCATION_GROUP_TYPE_PROCESS, 0) ;
+#endif
+      ++nextString ;
+   }
+
+   for (const Location& loc : locations) {
+      std::string name = "thread " + std::to_string(loc.thread) ;
+      OTF2_GlobalDefWriter_WriteString(defs, nextString, name.c_str()) ;
+      OTF2_GlobalDefWriter_WriteLocation(defs, loc.ref, nextString, OTF2_LOCATION_TYPE_CPU_THREAD,
+                                         loc.stream->numEvents(loc.thread), loc.file) ;
+      ++nextString ;
+   }
+
+   OTF2_Archive_OpenDefFiles(archive) ;
+   for (const Location& loc : locations) {
+      OTF2_DefWriter *writer = OTF2_Archive_GetDefWriter(archive, loc.ref) ;
+      OTF2_Archive_CloseDefWriter(archive, writer) ;
+   }
+   OTF2_Archive_CloseDefFiles(archive) ;
+}
+
+} // namespace
+
+/******************************************/
+
+int main(int argc, char *argv[])
+{
+   int nthreads = 1 ;
+   std::string archiveDir = "replay_trace" ;
+   std::string resultsFile ;
+   std::string name ;
+
+   int opt ;
+   while ((opt = getopt(argc, argv, "t:o:r:n:h")) != -1) {
+      switch (opt) {
+         case 't': nthreads = std::atoi(optarg) ; break ;
+         case 'o': archiveDir = optarg ; break ;
+         case 'r': resultsFile = optarg ; break ;
+         case 'n': name = optarg ; break ;
+         default: Usage(argv[0]) ;
+      }
+   }
+   if (optind >= argc || nthreads < 1)
+      Usage(argv[0]) ;
+
+   std::vector<std::string> files(argv + optind, argv + argc) ;
+   std::vector<std::unique_ptr<EventStream>> streams ;
+   std::vector<Location> locations ;
+   uint32_t regionBase = 0 ;
+   uint64_t totalEvents = 0 ;
+   uint64_t traceLength = 0 ;
+   for (uint32_t f = 0; f < files.size(); ++f) {
+      streams.emplace_back(new EventStream) ;
+      EventStream& stream = *streams.back() ;
+      if (!stream.Open(files[f])) {
+         std::fprintf(stderr, "Cannot read event stream %s\n", files[f].c_str()) ;
+         return 1 ;
+      }
+      for (uint32_t t = 0; t < stream.numThreads(); ++t) {
+         locations.push_back({ &stream, f, t, static_cast<OTF2_LocationRef>(locations.size()), regionBase }) ;
+         uint64_t n = stream.numEvents(t) ;
+         if (n > 0 && stream.events(t)[n - 1].timestamp > traceLength)
+            traceLength = stream.events(t)[n - 1].timestamp ;
+      }
+      regionBase += static_cast<uint32_t>(stream.regions().size()) ;
+      totalEvents += stream.totalEvents() ;
+   }
+   if (name.empty())
+      name = files.size() == 1 ? files[0] : files[0] + "+" + std::to_string(files.size() - 1) ;
+
+   /* Pages the streams in, the replay must not measure the disk */
+   volatile uint64_t touch = 0 ;
+   for (const Location& loc : locations) {
+      const Event *events = loc.stream->events(loc.thread) ;
+      for (uint64_t i = 0; i < loc.stream->numEvents(loc.thread); i += 256)
+         touch += events[i].timestamp ;
+   }
+
+   std::string archiveName = "archive" ;
+   auto start = std::chrono::steady_clock::now() ;
+
+   OTF2_Archive *archive = OTF2_Archive_Open(archiveDir.c_str(), archiveName.c_str(),
+                                             OTF2_FILEMODE_WRITE, 1024 * 1024, 4 * 1024 * 1024,
+                                             OTF2_SUBSTRATE_POSIX, OTF2_COMPRESSION_NONE) ;
+   if (!archive) {
+      std::fprintf(stderr, "Cannot create archive %s\n", archiveDir.c_str()) ;
+      return 1 ;
+   }
+   OTF2_Archive_SetFlushCallbacks(archive, &flushCallbacks, nullptr) ;
+   OTF2_Archive_SetSerialCollectiveCallbacks(archive) ;
+   OTF2_Archive_OpenEvtFiles(archive) ;
+
+   std::atomic<size_t> next(0) ;
+   std::vector<std::thread> workers ;
+   for (int w = 0; w < nthreads; ++w) {
+      workers.emplace_back([&]() {
+         for (size_t i = next++; i < locations.size(); i = next++)
+            ReplayLocation(archive, locations[i]) ;
+      }) ;
+   }
+   for (std::thread& worker : workers)
+      worker.join() ;
+
+   OTF2_Archive_CloseEvtFiles(archive) ;
+   WriteDefinitions(archive, streams, files, locations, traceLength) ;
+   OTF2_Archive_Close(archive) ;
+
+   BenchResult result ;
+   result.bench = "replay" ;
+   result.input = name ;
+   result.threads = nthreads ;
+   result.events = totalEvents ;
+   result.seconds = SecondsSince(start) ;
+   result.bytes = PathSize(archiveDir) ;
+   ReportResult(result, resultsFile) ;
+   return 0 ;
+}
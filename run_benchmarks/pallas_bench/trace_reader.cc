@@ -0,0 +1,89 @@
+#include <algorithm>
+#include <cstring>
+
+#include "trace_reader.h"
+
+namespace {
+
+class StreamCursor : public ThreadCursor
+{
+public:
+   StreamCursor(const Event *events, uint64_t count)
+      : m_cur(events), m_end(events + count) {}
+
+   /* Timestamps increase within a thread: binary search */
+   void Seek(uint64_t timestamp) override
+   {
+      m_hasPending = false ;
+      m_cur = std::lower_bound(m_cur, m_end, timestamp,
+                               [](const Event& e, uint64_t t) { return e.timestamp < t ; }) ;
+   }
+
+protected:
+   size_t ReadEvents(Event *out, size_t max) override
+   {
+      size_t n = std::min<size_t>(max, m_end - m_cur) ;
+      std::memcpy(out, m_cur, n * sizeof(Event)) ;
+      m_cur += n ;
+      return n ;
+   }
+
+private:
+   const Event *m_cur ;
+   const Event *m_end ;
+} ;
+
+class StreamReader : public TraceReader
+{
+public:
+   bool Open(const std::string& path)
+   {
+      m_files.push_back(path) ;
+      return m_stream.Open(path) ;
+   }
+
+   uint32_t numThreads() const override { return m_stream.numThreads() ; }
+   const std::vector<std::string>& regions() const override { return m_stream.regions() ; }
+
+   std::unique_ptr<ThreadCursor> OpenThread(uint32_t thread) const override
+   {
+      return std::unique_ptr<ThreadCursor>(
+         new StreamCursor(m_stream.events(thread), m_stream.numEvents(thread))) ;
+   }
+
+private:
+   EventStream m_stream ;
+} ;
+
+} // namespace
+
+/******************************************/
+
+void ThreadCursor::Seek(uint64_t timestamp)
+{
+   Event e ;
+   m_hasPending = false ;
+   while (ReadEvents(&e, 1) == 1) {
+      if (e.timestamp >= timestamp) {
+         m_pending = e ;
+         m_hasPending = true ;
+         return ;
+      }
+   }
+}
+
+/******************************************/
+
+std::unique_ptr<TraceReader> OpenTrace(const std::string& path)
+{
+   bool isStream = path.size() >= 4 && path.compare(path.size() - 4, 4, ".evs") == 0 ;
+   if (!isStream) {
+      std::fprintf(stderr, "%s: only .evs streams can be read\n",
+                   path.c_str()) ;
+      return nullptr ;
+   }
+   std::unique_ptr<StreamReader> reader(new StreamReader) ;
+   if (!reader->Open(path))
+      return nullptr ;
+   return reader ;
+}
@@ -0,0 +1,72 @@
+#ifndef TRACE_READER_H
+#define TRACE_READER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "event_stream.h"
+
+/* Reads the events of one thread in order, by batches */
+class ThreadCursor
+{
+public:
+   virtual ~ThreadCursor() = default ;
+
+   /* Fills `out` with up to `max` events, returns 0 at the end */
+   size_t Read(Event *out, size_t max)
+   {
+      if (m_hasPending && max > 0) {
+         out[0] = m_pending ;
+         m_hasPending = false ;
+         return 1 + ReadEvents(out + 1, max - 1) ;
+      }
+      return ReadEvents(out, max) ;
+   }
+
+   /* Moves to the first event at or after `timestamp`. By default the
+    * events before it are read and dropped, a format with an index can
+    * do better */
+   virtual void Seek(uint64_t timestamp) ;
+
+protected:
+   virtual size_t ReadEvents(Event *out, size_t max) = 0 ;
+
+   bool m_hasPending = false ;
+   Event m_pending ;
+} ;
+
+struct FunctionStats
+{
+   uint64_t calls = 0 ;
+   uint64_t inclusive = 0 ;   /* ns */
+} ;
+
+/* A trace opened for reading. Only .evs streams have a reader so far, a
+ * Pallas backend implements this interface and is dispatched by OpenTrace */
+class TraceReader
+{
+public:
+   virtual ~TraceReader() = default ;
+
+   virtual uint32_t numThreads() const = 0 ;
+   virtual const std::vector<std::string>& regions() const = 0 ;
+   virtual std::unique_ptr<ThreadCursor> OpenThread(uint32_t thread) const = 0 ;
+
+   /* Statistics the format keeps without a replay, false if it has none.
+    * The statistics of the benchmark are computed by a replay otherwise */
+   virtual bool NativeStats(std::vector<FunctionStats>& stats) const { (void)stats ; return false ; }
+
+   /* Files to evict from the page cache for a cold read */
+   const std::vector<std::string>& files() const { return m_files ; }
+
+protected:
+   std::vector<std::string> m_files ;
+} ;
+
+/* Opens an .evs file. Returns null on error or for a format without a
+ * reader */
+std::unique_ptr<TraceReader> OpenTrace(const std::string& path) ;
+
+#endif
@@ -0,0 +1,159 @@
+#!/bin/bash
+
+## Collects the self-instrumentation files Pallas drops in the working
+## directory at finalize (zstd.csv, write.csv, ..., *_details.csv, pcw_*.csv)
+## into one structured file, instead of handling each file by name. Only
+## the timers listed below are touched, other CSV files are left in place.
+##
+## Source this file from a run script, then call after each traced run:
+##     pallas_stats_collect <log_file> <tag> <details_dir>
+##
+## Environment:
+##   PALLAS_STATS_FILE     structured output (default: <log_dir>/pallas_stats.csv)
+##   PALLAS_STATS_TIMERS   timers collected, as <timer>.csv and <timer>_details.csv
+##   PALLAS_STATS_LOG_TIMERS  timers whose last line is appended to the log,
+##                         in this order (default: those the analysis reads)
+##   PALLAS_STATS_DETAILS  1 keeps the per-call *_details.csv files in
+##                         <details_dir> (default), 0 drops them, hist only
+##                         keeps a log2 histogram of their durations
+##   PALLAS_STATS_SAMPLE   keep one call out of N in the kept *_details.csv
+##                         files (default: 1, every call)
+##   PALLAS_STATS_HIST     histogram output (default: <log_dir>/pallas_details_hist.csv)
+##
+## pallas_stats_provenance <log_file> [<pallas_src> [<pallas_build>]] records
+## which tracer produced a log, see below.
+
+PALLAS_STATS_DETAILS=${PALLAS_STATS_DETAILS:-1}
+PALLAS_STATS_SAMPLE=${PALLAS_STATS_SAMPLE:-1}
+
+## The [TIME]-grepped log gets the same lines as before the helper, in the
+## same order: results.cc (nas_comp_write.csv) reads them by position
+PALLAS_STATS_LOG_TIMERS=${PALLAS_STATS_LOG_TIMERS:-"zstd write write_vector write_duration_vector write_dur_subvec write_subvec"}
+PALLAS_STATS_TIMERS=${PALLAS_STATS_TIMERS:-"$PALLAS_STATS_LOG_TIMERS write_dur_vect \
+    write_dur_subvec_ftell write_dur_subvec_pcw write_dur_subvec_delete \
+    pcw pcw_enc_alg pcw_comp_alg pcw_write"}
+
+## One row per timer line written by Pallas. A timer file gets one line per
+## process that wrote it, `entry` is the index of that line.
+PALLAS_STATS_HEADER="tag,timer,entry,n_calls,total_time,min,max,mean"
+
+## Bucket b counts the calls with 2^b <= duration (ns) < 2^(b+1), so a
+## timer takes at most 64 rows whatever its number of calls (bucket 0 also
+## holds the zero durations).
+PALLAS_HIST_HEADER="tag,timer,bucket,count,total_time"
+
+pallas_stats_hist() {
+    local csv=$1
+    local tag=$2
+    local timer=$3
+    local hist_file=$4
+
+    if [ ! -s "$hist_file" ]; then
+        echo "$PALLAS_HIST_HEADER" > "$hist_file"
+    fi
+
+    awk -F',' -v tag="$tag" -v timer="$timer" '
+        $2 ~ /^[0-9]+$/ {
+            b = 0
+            for (t = $2; t >= 2; t = int(t / 2)) b++
+            count[b]++
+            total[b] += $2
+        }
+        END {
+            for (b = 0; b < 64; b++)
+                if (b in count) print tag "," timer "," b "," count[b] "," total[b]
+        }
+    ' "$csv" >> "$hist_file"
+}
+
+pallas_stats_collect() {
+    local log_file=$1
+    local tag=$2
+    local details_dir=$3
+    local stats_file=${PALLAS_STATS_FILE:-$(dirname "$log_file")/pallas_stats.csv}
+    local hist_file=${PALLAS_STATS_HIST:-$(dirname "$log_file")/pallas_details_hist.csv}
+
+    if [ ! -s "$stats_file" ]; then
+        echo "$PALLAS_STATS_HEADER" > "$stats_file"
+    fi
+
+    local timer
+    for timer in $PALLAS_STATS_LOG_TIMERS; do
+        if [ -f "$PWD/$timer.csv" ]; then
+            tail -n 1 "$PWD/$timer.csv" >> "$log_file"
+        fi
+    done
+
+    for timer in $PALLAS_STATS_TIMERS; do
+        local csv=$PWD/$timer.csv
+        local details=$PWD/${timer}_details.csv
+
+        if [ -f "$csv" ]; then
+            awk -F',' -v tag="$tag" -v timer="$timer" '
+                $2 ~ /^[0-9]/ { print tag "," timer "," n++ "," $2 "," $3 "," $4 "," $5 "," $6 }
+            ' "$csv" >> "$stats_file"
+            rm -f "$csv"
+        fi
+
+        if [ -f "$details" ]; then
+            case "$PALLAS_STATS_DETAILS" in
+                1)
+                    mkdir -p "$details_dir"
+                    awk -v n="$PALLAS_STATS_SAMPLE" 'n == 1 || NR % n == 1' \
+                        "$details" > "${details_dir}/${timer}_details_${tag}.csv"
+                    ;;
+                hist)
+                    pallas_stats_hist "$details" "$tag" "$timer" "$hist_file"
+                    ;;
+            esac
+            rm -f "$details"
+        fi
+    done
+}
+
+## Source and build trees of the tracer, from run_benchmarks/
+PALLAS_SRC=${PALLAS_SRC:-$PWD/../soft/pallas}
+EZTRACE_SRC=${EZTRACE_SRC:-$PWD/../soft/eztrace}
+
+## <commit>, or <commit>-dirty.<hash of the diff> for a patched tree
+## (run_nas_vectors.sh), so that two patches never look the same
+pallas_stats_commit() {
+    local src=$1
+    local commit
+    commit=$(git -C "$src" rev-parse --short=12 HEAD 2>/dev/null) || { echo unknown; return; }
+    if ! git -C "$src" diff --quiet HEAD 2>/dev/null; then
+        commit="$commit-dirty.$(git -C "$src" diff HEAD | sha1sum | cut -c1-8)"
+    fi
+    echo "$commit"
+}
+
+## The options of a build as configured: build type and feature switches
+## from its CMakeCache.txt
+pallas_stats_flags() {
+    local build=$1
+    sed -n 's/^\(CMAKE_BUILD_TYPE\|[A-Z_]*ENABLE_[A-Z0-9_]*\):[A-Z]*=\(.*\)$/\1=\2/p' \
+        "$build/CMakeCache.txt" 2>/dev/null | tr '\n' ' ' | sed 's/ $//'
+}
+
+## Appends to the log the commits of Pallas and EZTrace, their build options,
+## the vector size Pallas was compiled with and the host:
+##     [PALLAS_COMMIT] 1a2b3c4d5e6f
+##     [EZTRACE_COMMIT] 6f5e4d3c2b1a
+##     [BUILD_FLAGS] pallas: ... DEFAULT_VECTOR_SIZE=1000; eztrace: ...
+##     [HOST] <hostname>
+## A run of a sweep variant passes the tree of that variant.
+pallas_stats_provenance() {
+    local log_file=$1
+    local pallas_src=${2:-$PALLAS_SRC}
+    local pallas_build=${3:-$pallas_src/build}
+    local vector_size
+    vector_size=$(sed -n 's/^#define DEFAULT_VECTOR_SIZE \([0-9]*\).*/\1/p' \
+        "$pallas_src/libraries/pallas/include/pallas/pallas_linked_vector.h" 2>/dev/null)
+
+    {
+        echo "[PALLAS_COMMIT] $(pallas_stats_commit "$pallas_src")"
+        echo "[EZTRACE_COMMIT] $(pallas_stats_commit "$EZTRACE_SRC")"
+        echo "[BUILD_FLAGS] pallas: $(pallas_stats_flags "$pallas_build") DEFAULT_VECTOR_SIZE=${vector_size:-unknown}; eztrace: $(pallas_stats_flags "$EZTRACE_SRC/build")" | tr ',' ';'
+        echo "[HOST] $(hostname)"
+    } >> "$log_file"
+}
@@ -0,0 +1,97 @@
+#!/bin/bash
+
+## Runs the NAS benchmarks in vanilla and eztrace mode until the eztrace
+## overhead is known with the requested precision.
+## - every round runs all the configurations in a random order,
+## - the first NB_WARMUP rounds are discarded,
+## - ranks are pinned to cores,
+## - every sample has its own log, read by analysis/aggregator,
+## - after MIN_REPS rounds, the aggregator decides whether to stop, on the
+##   logs of this invocation only.
+## Every invocation writes to its own run directory, interleaved/<RUN_NAME>
+## (a timestamp by default), with the log/, traces/ and details/ layout the
+## aggregator reads. `aggregator run_nas_benchmark/interleaved` takes every
+## invocation as a patch of its own.
+
+nas_dir=$PWD/run_nas_benchmark/interleaved
+bin_dir=$nas_dir/../NPB3.4-MPI/bin
+RUN_NAME=${RUN_NAME:-$(date +%Y%m%d_%H%M%S)}
+run_dir=$nas_dir/$RUN_NAME
+log_dir=$run_dir/log
+traces_dir=$run_dir/traces
+details_dir=$run_dir/details
+agg_dir=$PWD/../analysis/aggregator
+
+source $PWD/pallas_stats.sh
+
+NB_RANKS=${NB_RANKS:-64}
+NB_WARMUP=${NB_WARMUP:-1}
+MIN_REPS=${MIN_REPS:-5}
+MAX_REPS=${MAX_REPS:-30}
+PRECISION=${PRECISION:-1}       # +/- percent on the overhead
+APPS=${APPS:-$(ls $bin_dir)}     # e.g. APPS="bt.C.x cg.C.x"
+
+if [ -n "$(ls -A $log_dir 2>/dev/null)" ]; then
+    echo "$log_dir already holds logs, pick another RUN_NAME"
+    exit 1
+fi
+
+MPIRUN="mpirun --bind-to core --map-by core -np $NB_RANKS"
+
+mkdir -p $log_dir
+mkdir -p $traces_dir
+
+cmake -S $agg_dir -B $agg_dir/build > /dev/null && cmake --build $agg_dir/build > /dev/null || exit 1
+
+cd $nas_dir
+
+## run_config <app_name> <mode> <log_file>
+run_config() {
+    local app_name=$1
+    local mode=$2
+    local log_file=$3
+
+    if [ "$mode" = "vanilla" ]; then
+        /usr/bin/time -f "[TIME] %e" \
+        $MPIRUN "$bin_dir/$app_name" < /dev/null >> "$log_file" 2>&1
+    else
+        /usr/bin/time -f "[TIME] %e" \
+        $MPIRUN eztrace -m -t "mpi compiler_instrumentation" "$bin_dir/$app_name" < /dev/null >> "$log_file" 2>&1
+    fi
+}
+
+configs=""
+for app_name in $APPS ; do
+    configs+="$app_name vanilla"$'\n'"$app_name eztrace"$'\n'
+done
+
+for w in $(seq $NB_WARMUP) ; do
+    echo "$configs" | shuf | while read -r app_name mode ; do
+        [ -n "$app_name" ] || continue
+        run_config "$app_name" "$mode" /dev/null
+        rm -rf $nas_dir/${app_name}_trace
+        rm -f $nas_dir/*.csv
+    done
+done
+
+for i in $(seq $MAX_REPS) ; do
+    echo "$configs" | shuf | while read -r app_name mode ; do
+        [ -n "$app_name" ] || continue
+        log_file="$log_dir/${app_name}_${i}_${mode}.log"
+        echo -n > "$log_file"
+
+        run_config "$app_name" "$mode" "$log_file"
+        pallas_stats_provenance "$log_file"
+
+        if [ "$mode" = "eztrace" ]; then
+            mv $nas_dir/${app_name}_trace $traces_dir/${app_name}_trace_${i}
+            pallas_stats_collect "$log_file" "${app_name}_${i}" "$details_dir"
+        fi
+    done
+
+    if [ "$i" -ge "$MIN_REPS" ] && \
+       $agg_dir/build/aggregator -c $MIN_REPS -p $PRECISION $run_dir ; then
+        echo "Overhead known within +/-${PRECISION}% after $i rounds"
+        break
+    fi
+done
@@ -3,38 +3,65 @@
 lulesh_dir=$PWD/run_lulesh
 log_dir=$lulesh_dir/iter_20/log
 traces_dir=$lulesh_dir/iter_20/traces
+details_dir=$lulesh_dir/iter_20/details
 
 mkdir -p $log_dir
 mkdir -p $traces_dir
 
+source $PWD/pallas_stats.sh
+
 cd $lulesh_dir
 
 NB_SIM=30
 NB_ITER=500
 SIZE=100
 
+## Halo exchange backends to run: p2p (point to point, the default) and/or
+## neighbor (MPI neighborhood collectives, lulesh2.0 -n), logged as the apps
+## lulesh and lulesh_neighbor. NB_RANKS runs them under mpirun, e.g.
+##   COMM_MODES="p2p neighbor" NB_RANKS=8 bash run_lulesh.sh
+COMM_MODES=${COMM_MODES:-p2p}
+NB_RANKS=${NB_RANKS:-}
+
+launch=""
+if [ -n "$NB_RANKS" ]; then
+    launch="mpirun -np $NB_RANKS"
+fi
+
+## NB_RANKS need not be a cube. SIZE is the side of each domain (weak
+## scaling); set MESH_SIZE to fix the side of the whole mesh instead and
+## sweep NB_RANKS over it (strong scaling), e.g.
+##   MESH_SIZE=120 NB_RANKS=48 bash run_lulesh.sh
+MESH_SIZE=${MESH_SIZE:-}
+size_opt="-s $SIZE"
+if [ -n "$MESH_SIZE" ]; then
+    size_opt="-S $MESH_SIZE"
+fi
+
 cd $lulesh_dir/LULESH
 
 for i in $(seq $NB_SIM) ; do 
+  for comm in $COMM_MODES ; do
 
-    log_file_vanilla="$log_dir/lulesh_${i}_vanilla.log"
-    log_file_eztrace="$log_dir/lulesh_${i}_eztrace.log"
+    case $comm in
+        p2p)      app_name=lulesh ;          comm_opt="" ;;
+        neighbor) app_name=lulesh_neighbor ; comm_opt="-n" ;;
+        *)        echo "Unknown comm mode $comm" >&2 ; exit 1 ;;
+    esac
 
-    /usr/bin/time -f "[TIME] %e" \
-    ./lulesh2.0 -p -i $NB_ITER -s $SIZE 2>&1 | tee -a "$log_file_vanilla"
+    log_file_vanilla="$log_dir/${app_name}_${i}_vanilla.log"
+    log_file_eztrace="$log_dir/${app_name}_${i}_eztrace.log"
 
     /usr/bin/time -f "[TIME] %e" \
-    eztrace -m -t "mpi" ./lulesh2.0 -p -i $NB_ITER -s $SIZE 2>&1 | tee -a "$log_file_eztrace"
-
-    mv *0_trace $traces_dir/lulesh_trace_${i} 
+    $launch ./lulesh2.0 -p -i $NB_ITER $size_opt $comm_opt 2>&1 | tee -a "$log_file_vanilla"
 
-    cat $PWD/zstd.csv | tail -n 1 >> "$log_file_eztrace"
-    cat $PWD/write.csv | tail -n 1 >> "$log_file_eztrace"
-    cat $PWD/write_vector.csv | tail -n 1 >> "$log_file_eztrace"        
-    cat $PWD/write_duration_vector.csv | tail -n 1 >> "$log_file_eztrace"
-    cat $PWD/write_dur_subvec.csv | tail -n 1 >> "$log_file_eztrace"
-    cat $PWD/write_subvec.csv | tail -n 1 >> "$log_file_eztrace"
+    /usr/bin/time -f "[TIME] %e" \
+    $launch eztrace -m -t "mpi" ./lulesh2.0 -p -i $NB_ITER $size_opt $comm_opt 2>&1 | tee -a "$log_file_eztrace"
 
+    mv *0_trace $traces_dir/${app_name}_trace_${i} 
 
-    rm $PWD/*.csv   
+    pallas_stats_collect "$log_file_eztrace" "${app_name}_${i}" "$details_dir"
+    pallas_stats_provenance "$log_file_vanilla"
+    pallas_stats_provenance "$log_file_eztrace"
+  done
 done
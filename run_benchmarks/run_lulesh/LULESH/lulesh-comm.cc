@@ -4,14 +4,11 @@
 #if USE_MPI
 
 #include <mpi.h>
+#include <stdio.h>
 #include <string.h>
 
 /* Comm Routines */
 
-#define ALLOW_UNPACKED_PLANE false
-#define ALLOW_UNPACKED_ROW   false
-#define ALLOW_UNPACKED_COL   false
-
 /*
    There are coherence issues for packing and unpacking message
    buffers.  Ideally, you would like a lot of threads to 
@@ -52,1208 +49,395 @@
    non-coherent load/store opcodes?
 */
 
-/******************************************/
-
-
-/* doRecv flag only works with regular block structure */
-void CommRecv(Domain& domain, Int_t msgType, Index_t xferFields,
-              Index_t dx, Index_t dy, Index_t dz, bool doRecv, bool planeOnly) {
-
-   if (domain.numRanks() == 1)
-      return ;
-
-   /* post recieve buffers for all incoming messages */
-   int myRank ;
-   Index_t maxPlaneComm = xferFields * domain.maxPlaneSize() ;
-   Index_t maxEdgeComm  = xferFields * domain.maxEdgeSize() ;
-   Index_t pmsg = 0 ; /* plane comm msg */
-   Index_t emsg = 0 ; /* edge comm msg */
-   Index_t cmsg = 0 ; /* corner comm msg */
-   MPI_Datatype baseType = ((sizeof(Real_t) == 4) ? MPI_FLOAT : MPI_DOUBLE) ;
-   bool rowMin, rowMax, colMin, colMax, planeMin, planeMax ;
-
-   /* assume communication to 6 neighbors by default */
-   rowMin = rowMax = colMin = colMax = planeMin = planeMax = true ;
-
-   if (domain.rowLoc() == 0) {
-      rowMin = false ;
-   }
-   if (domain.rowLoc() == (domain.tp()-1)) {
-      rowMax = false ;
-   }
-   if (domain.colLoc() == 0) {
-      colMin = false ;
-   }
-   if (domain.colLoc() == (domain.tp()-1)) {
-      colMax = false ;
-   }
-   if (domain.planeLoc() == 0) {
-      planeMin = false ;
-   }
-   if (domain.planeLoc() == (domain.tp()-1)) {
-      planeMax = false ;
-   }
-
-   for (Index_t i=0; i<26; ++i) {
-      domain.recvRequest[i] = MPI_REQUEST_NULL ;
-   }
-
-   MPI_Comm_rank(MPI_COMM_WORLD, &myRank) ;
-
-   /* post receives */
-
-   /* receive data from neighboring domain faces */
-   if (planeMin && doRecv) {
-      /* contiguous memory */
-      int fromRank = myRank - domain.tp()*domain.tp() ;
-      int recvCount = dx * dy * xferFields ;
-      MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm],
-                recvCount, baseType, fromRank, msgType,
-                MPI_COMM_WORLD, &domain.recvRequest[pmsg]) ;
-      ++pmsg ;
-   }
-   if (planeMax) {
-      /* contiguous memory */
-      int fromRank = myRank + domain.tp()*domain.tp() ;
-      int recvCount = dx * dy * xferFields ;
-      MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm],
-                recvCount, baseType, fromRank, msgType,
-                MPI_COMM_WORLD, &domain.recvRequest[pmsg]) ;
-      ++pmsg ;
-   }
-   if (rowMin && doRecv) {
-      /* semi-contiguous memory */
-      int fromRank = myRank - domain.tp() ;
-      int recvCount = dx * dz * xferFields ;
-      MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm],
-                recvCount, baseType, fromRank, msgType,
-                MPI_COMM_WORLD, &domain.recvRequest[pmsg]) ;
-      ++pmsg ;
-   }
-   if (rowMax) {
-      /* semi-contiguous memory */
-      int fromRank = myRank + domain.tp() ;
-      int recvCount = dx * dz * xferFields ;
-      MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm],
-                recvCount, baseType, fromRank, msgType,
-                MPI_COMM_WORLD, &domain.recvRequest[pmsg]) ;
-      ++pmsg ;
-   }
-   if (colMin && doRecv) {
-      /* scattered memory */
-      int fromRank = myRank - 1 ;
-      int recvCount = dy * dz * xferFields ;
-      MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm],
-                recvCount, baseType, fromRank, msgType,
-                MPI_COMM_WORLD, &domain.recvRequest[pmsg]) ;
-      ++pmsg ;
-   }
-   if (colMax) {
-      /* scattered memory */
-      int fromRank = myRank + 1 ;
-      int recvCount = dy * dz * xferFields ;
-      MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm],
-                recvCount, baseType, fromRank, msgType,
-                MPI_COMM_WORLD, &domain.recvRequest[pmsg]) ;
-      ++pmsg ;
-   }
-
-   if (!planeOnly) {
-      /* receive data from domains connected only by an edge */
-      if (rowMin && colMin && doRecv) {
-         int fromRank = myRank - domain.tp() - 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dz * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
-
-      if (rowMin && planeMin && doRecv) {
-         int fromRank = myRank - domain.tp()*domain.tp() - domain.tp() ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dx * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
-
-      if (colMin && planeMin && doRecv) {
-         int fromRank = myRank - domain.tp()*domain.tp() - 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dy * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
-
-      if (rowMax && colMax) {
-         int fromRank = myRank + domain.tp() + 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dz * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
-
-      if (rowMax && planeMax) {
-         int fromRank = myRank + domain.tp()*domain.tp() + domain.tp() ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dx * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
-
-      if (colMax && planeMax) {
-         int fromRank = myRank + domain.tp()*domain.tp() + 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dy * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
-
-      if (rowMax && colMin) {
-         int fromRank = myRank + domain.tp() - 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dz * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
-
-      if (rowMin && planeMax) {
-         int fromRank = myRank + domain.tp()*domain.tp() - domain.tp() ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dx * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
+/*
+   Each exchange (message type and number of fields) has a CommPlan,
+   built by its first CommRecv and CommSend: the neighbor ranks, the
+   offsets of the messages in commDataRecv/commDataSend and the indices
+   of the values each message carries.  Its receives and sends are
+   persistent requests, later calls only pack and start them.  With
+   neighborComm (-n), the plan rather gets a graph communicator of its
+   neighbors (MPI_Dist_graph_create_adjacent) and each exchange is one
+   neighborhood collective over the same buffers: MPI_Ineighbor_alltoallv,
+   or a persistent MPI_Neighbor_alltoallv_init request with MPI 4.
+
+   The packing and unpacking work on the raw storage of the fields:
+   the index lists are turned once into offsets in that storage, the
+   same for all the fields of an exchange (the nodal vectors share the
+   NodeLayout, the other fields are plain arrays).  Each message is
+   then a gather or scatter per field, shared by the threads when the
+   exchange is large enough.
+*/
 
-      if (colMin && planeMax) {
-         int fromRank = myRank + domain.tp()*domain.tp() - 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dy * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
+/* Fewest values an exchange or a message must carry before threads
+   share its packing or unpacking */
+#define COMM_THREAD_MIN 4096
 
-      if (rowMin && colMax && doRecv) {
-         int fromRank = myRank - domain.tp() + 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dz * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
+/******************************************/
 
-      if (rowMax && planeMin && doRecv) {
-         int fromRank = myRank - domain.tp()*domain.tp() + domain.tp() ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dx * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
+/* Neighbor directions as (col, row, plane) steps, in the order of the
+   messages: 6 faces, 12 edges, 8 corners.  CommSBN adds the messages
+   in this order, which fixes the summation order of the shared nodes */
+static const Int_t commDir[26][3] = {
+   /* faces */
+   { 0, 0,-1}, { 0, 0, 1}, { 0,-1, 0}, { 0, 1, 0}, {-1, 0, 0}, { 1, 0, 0},
+   /* edges */
+   {-1,-1, 0}, { 0,-1,-1}, {-1, 0,-1}, { 1, 1, 0}, { 0, 1, 1}, { 1, 0, 1},
+   {-1, 1, 0}, { 0,-1, 1}, {-1, 0, 1}, { 1,-1, 0}, { 0, 1,-1}, { 1, 0,-1},
+   /* corners */
+   {-1,-1,-1}, {-1,-1, 1}, { 1,-1,-1}, { 1,-1, 1},
+   {-1, 1,-1}, {-1, 1, 1}, { 1, 1,-1}, { 1, 1, 1}
+} ;
 
-      if (colMax && planeMin && doRecv) {
-         int fromRank = myRank - domain.tp()*domain.tp() + 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm],
-                   dy * xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
+/******************************************/
 
-      /* receive data from domains connected only by a corner */
-      if (rowMin && colMin && planeMin && doRecv) {
-         /* corner at domain logical coord (0, 0, 0) */
-         int fromRank = myRank - domain.tp()*domain.tp() - domain.tp() - 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL],
-                   xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg+cmsg]) ;
-         ++cmsg ;
-      }
-      if (rowMin && colMin && planeMax) {
-         /* corner at domain logical coord (0, 0, 1) */
-         int fromRank = myRank + domain.tp()*domain.tp() - domain.tp() - 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL],
-                   xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg+cmsg]) ;
-         ++cmsg ;
-      }
-      if (rowMin && colMax && planeMin && doRecv) {
-         /* corner at domain logical coord (1, 0, 0) */
-         int fromRank = myRank - domain.tp()*domain.tp() - domain.tp() + 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL],
-                   xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg+cmsg]) ;
-         ++cmsg ;
-      }
-      if (rowMin && colMax && planeMax) {
-         /* corner at domain logical coord (1, 0, 1) */
-         int fromRank = myRank + domain.tp()*domain.tp() - domain.tp() + 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL],
-                   xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg+cmsg]) ;
-         ++cmsg ;
-      }
-      if (rowMax && colMin && planeMin && doRecv) {
-         /* corner at domain logical coord (0, 1, 0) */
-         int fromRank = myRank - domain.tp()*domain.tp() + domain.tp() - 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL],
-                   xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg+cmsg]) ;
-         ++cmsg ;
-      }
-      if (rowMax && colMin && planeMax) {
-         /* corner at domain logical coord (0, 1, 1) */
-         int fromRank = myRank + domain.tp()*domain.tp() + domain.tp() - 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL],
-                   xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg+cmsg]) ;
-         ++cmsg ;
-      }
-      if (rowMax && colMax && planeMin && doRecv) {
-         /* corner at domain logical coord (1, 1, 0) */
-         int fromRank = myRank - domain.tp()*domain.tp() + domain.tp() + 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL],
-                   xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg+cmsg]) ;
-         ++cmsg ;
-      }
-      if (rowMax && colMax && planeMax) {
-         /* corner at domain logical coord (1, 1, 1) */
-         int fromRank = myRank + domain.tp()*domain.tp() + domain.tp() + 1 ;
-         MPI_Irecv(&domain.commDataRecv[pmsg * maxPlaneComm +
-                                         emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL],
-                   xferFields, baseType, fromRank, msgType,
-                   MPI_COMM_WORLD, &domain.recvRequest[pmsg+emsg+cmsg]) ;
-         ++cmsg ;
-      }
-   }
+static CommPlan& FindCommPlan(Domain& domain, Int_t msgType, Index_t xferFields)
+{
+   for (size_t p=0 ; p<domain.commPlans.size() ; ++p) {
+      CommPlan *plan = domain.commPlans[p] ;
+      if (plan->msgType == msgType && plan->xferFields == xferFields) {
+         return *plan ;
+      }
+   }
+
+   CommPlan *plan = new CommPlan ;
+   plan->msgType = msgType ;
+   plan->xferFields = xferFields ;
+   plan->numRecv = -1 ;
+   plan->numSend = -1 ;
+   plan->neighbor = (domain.neighborComm() != 0) ;
+   plan->graphComm = MPI_COMM_NULL ;
+   plan->collRequest = MPI_REQUEST_NULL ;
+   domain.commPlans.push_back(plan) ;
+   return *plan ;
 }
 
 /******************************************/
 
-void CommSend(Domain& domain, Int_t msgType,
-              Index_t xferFields, Domain_member *fieldData,
-              Index_t dx, Index_t dy, Index_t dz, bool doSend, bool planeOnly)
+/* Messages to or from the neighbors of the dx*dy*dz block, with the
+   indices of their values, plane by plane and row by row on both sides.
+   Unless doAll, only the neighbors of higher ranks (sign 1) or lower
+   ranks (sign -1) are kept */
+static Int_t BuildCommMsgs(Domain& domain, Index_t xferFields,
+                           Index_t dx, Index_t dy, Index_t dz,
+                           bool doAll, bool planeOnly, Int_t sign,
+                           CommMsg msg[26], std::vector<Index_t>& indices)
 {
-
-   if (domain.numRanks() == 1)
-      return ;
-
-   /* post recieve buffers for all incoming messages */
    int myRank ;
-   Index_t maxPlaneComm = xferFields * domain.maxPlaneSize() ;
-   Index_t maxEdgeComm  = xferFields * domain.maxEdgeSize() ;
-   Index_t pmsg = 0 ; /* plane comm msg */
-   Index_t emsg = 0 ; /* edge comm msg */
-   Index_t cmsg = 0 ; /* corner comm msg */
-   MPI_Datatype baseType = ((sizeof(Real_t) == 4) ? MPI_FLOAT : MPI_DOUBLE) ;
-   MPI_Status status[26] ;
-   Real_t *destAddr ;
-   bool rowMin, rowMax, colMin, colMax, planeMin, planeMax ;
-   /* assume communication to 6 neighbors by default */
-   rowMin = rowMax = colMin = colMax = planeMin = planeMax = true ;
-   if (domain.rowLoc() == 0) {
-      rowMin = false ;
-   }
-   if (domain.rowLoc() == (domain.tp()-1)) {
-      rowMax = false ;
-   }
-   if (domain.colLoc() == 0) {
-      colMin = false ;
-   }
-   if (domain.colLoc() == (domain.tp()-1)) {
-      colMax = false ;
-   }
-   if (domain.planeLoc() == 0) {
-      planeMin = false ;
-   }
-   if (domain.planeLoc() == (domain.tp()-1)) {
-      planeMax = false ;
-   }
-
-   for (Index_t i=0; i<26; ++i) {
-      domain.sendRequest[i] = MPI_REQUEST_NULL ;
-   }
+   Index_t loc[3] = { domain.colLoc(), domain.rowLoc(), domain.planeLoc() } ;
+   Index_t doms[3] = { domain.colDoms(), domain.rowDoms(), domain.planeDoms() } ;
+   Index_t size[3] = { dx, dy, dz } ;
+   Index_t stride[3] = { 1, doms[0], doms[0]*doms[1] } ;
+   Int_t numDir = planeOnly ? 6 : 26 ;
+   Int_t numMsg = 0 ;
+   Index_t offset = 0 ;
 
    MPI_Comm_rank(MPI_COMM_WORLD, &myRank) ;
 
-   /* post sends */
-
-   if (planeMin | planeMax) {
-      /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
-      int sendCount = dx * dy ;
-
-      if (planeMin) {
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm] ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<sendCount; ++i) {
-               destAddr[i] = (domain.*src)(i) ;
-            }
-            destAddr += sendCount ;
+   for (Int_t d=0 ; d<numDir ; ++d) {
+      const Int_t *dir = commDir[d] ;
+      Index_t lo[3], hi[3] ;
+      Index_t rankOffset = 0 ;
+      bool inside = true ;
+      for (Int_t a=0 ; a<3 ; ++a) {
+         if (loc[a] + dir[a] < 0 || loc[a] + dir[a] >= doms[a]) {
+            inside = false ;
          }
-         destAddr -= xferFields*sendCount ;
-
-         MPI_Isend(destAddr, xferFields*sendCount, baseType,
-                   myRank - domain.tp()*domain.tp(), msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg]) ;
-         ++pmsg ;
+         rankOffset += dir[a]*stride[a] ;
+         lo[a] = (dir[a] > 0) ? size[a] - 1 : 0 ;
+         hi[a] = (dir[a] == 0) ? size[a] : lo[a] + 1 ;
       }
-      if (planeMax && doSend) {
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm] ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<sendCount; ++i) {
-               destAddr[i] = (domain.*src)(dx*dy*(dz - 1) + i) ;
-            }
-            destAddr += sendCount ;
-         }
-         destAddr -= xferFields*sendCount ;
-
-         MPI_Isend(destAddr, xferFields*sendCount, baseType,
-                   myRank + domain.tp()*domain.tp(), msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg]) ;
-         ++pmsg ;
+      if (!inside || (!doAll && rankOffset*sign < 0)) {
+         continue ;
       }
-   }
-   if (rowMin | rowMax) {
-      /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
-      int sendCount = dx * dz ;
-
-      if (rowMin) {
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dx; ++j) {
-                  destAddr[i*dx+j] = (domain.*src)(i*dx*dy + j) ;
-               }
-            }
-            destAddr += sendCount ;
-         }
-         destAddr -= xferFields*sendCount ;
 
-         MPI_Isend(destAddr, xferFields*sendCount, baseType,
-                   myRank - domain.tp(), msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg]) ;
-         ++pmsg ;
-      }
-      if (rowMax && doSend) {
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dx; ++j) {
-                  destAddr[i*dx+j] = (domain.*src)(dx*(dy - 1) + i*dx*dy + j) ;
-               }
+      CommMsg& m = msg[numMsg++] ;
+      m.rank = myRank + rankOffset ;
+      m.first = indices.size() ;
+      m.offset = offset ;
+      for (Index_t k=lo[2] ; k<hi[2] ; ++k) {
+         for (Index_t j=lo[1] ; j<hi[1] ; ++j) {
+            for (Index_t i=lo[0] ; i<hi[0] ; ++i) {
+               indices.push_back(k*dx*dy + j*dx + i) ;
             }
-            destAddr += sendCount ;
          }
-         destAddr -= xferFields*sendCount ;
-
-         MPI_Isend(destAddr, xferFields*sendCount, baseType,
-                   myRank + domain.tp(), msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg]) ;
-         ++pmsg ;
       }
+      m.count = indices.size() - m.first ;
+      /* each message on its own cache lines, this never takes more
+         room than SetupCommBuffers gives the exchange */
+      offset += CACHE_ALIGN_REAL(m.count*xferFields) ;
    }
-   if (colMin | colMax) {
-      /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
-      int sendCount = dy * dz ;
-
-      if (colMin) {
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dy; ++j) {
-                  destAddr[i*dy + j] = (domain.*src)(i*dx*dy + j*dx) ;
-               }
-            }
-            destAddr += sendCount ;
-         }
-         destAddr -= xferFields*sendCount ;
+   return numMsg ;
+}
 
-         MPI_Isend(destAddr, xferFields*sendCount, baseType,
-                   myRank - 1, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg]) ;
-         ++pmsg ;
-      }
-      if (colMax && doSend) {
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dy; ++j) {
-                  destAddr[i*dy + j] = (domain.*src)(dx - 1 + i*dx*dy + j*dx) ;
-               }
-            }
-            destAddr += sendCount ;
-         }
-         destAddr -= xferFields*sendCount ;
+/******************************************/
 
-         MPI_Isend(destAddr, xferFields*sendCount, baseType,
-                   myRank + 1, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg]) ;
-         ++pmsg ;
+/* Offsets of the values at indices in the storage of the fields, which
+   must be the same for all of them */
+static void MapCommIndices(Domain& domain, Index_t xferFields,
+                           Domain_member *fieldData,
+                           const std::vector<Index_t>& indices,
+                           std::vector<Index_t>& offsets)
+{
+   offsets.resize(indices.size()) ;
+   for (Index_t fi=0 ; fi<xferFields; ++fi) {
+      Domain_member field = fieldData[fi] ;
+      Real_t *base = &(domain.*field)(0) ;
+      for (size_t i=0 ; i<indices.size() ; ++i) {
+         Index_t offset = Index_t(&(domain.*field)(indices[i]) - base) ;
+         if (fi == 0) {
+            offsets[i] = offset ;
+         }
+         else if (offsets[i] != offset) {
+            fprintf(stderr, "Halo exchange of fields with different layouts\n") ;
+            MPI_Abort(MPI_COMM_WORLD, -1) ;
+         }
       }
    }
+}
 
-   if (!planeOnly) {
-      if (rowMin && colMin) {
-         int toRank = myRank - domain.tp() - 1 ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               destAddr[i] = (domain.*src)(i*dx*dy) ;
-            }
-            destAddr += dz ;
-         }
-         destAddr -= xferFields*dz ;
-         MPI_Isend(destAddr, xferFields*dz, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
+/******************************************/
 
-      if (rowMin && planeMin) {
-         int toRank = myRank - domain.tp()*domain.tp() - domain.tp() ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dx; ++i) {
-               destAddr[i] = (domain.*src)(i) ;
-            }
-            destAddr += dx ;
+/* Packs the fields one after another in each message */
+static void CommPack(Real_t *const fields[], Index_t xferFields,
+                     const CommMsg msg[], Int_t numMsg,
+                     const Index_t offsets[], Real_t *buf, Index_t numValues)
+{
+#pragma omp parallel firstprivate(xferFields, numMsg) if (numValues >= COMM_THREAD_MIN)
+   for (Int_t m=0 ; m<numMsg ; ++m) {
+      Index_t count = msg[m].count ;
+      const Index_t *offset = &offsets[msg[m].first] ;
+      for (Index_t fi=0 ; fi<xferFields; ++fi) {
+         const Real_t *field = fields[fi] ;
+         Real_t *destAddr = &buf[msg[m].offset + fi*count] ;
+#pragma omp for simd nowait
+         for (Index_t i=0; i<count; ++i) {
+            destAddr[i] = field[offset[i]] ;
          }
-         destAddr -= xferFields*dx ;
-         MPI_Isend(destAddr, xferFields*dx, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
-         ++emsg ;
       }
+   }
+}
 
-      if (colMin && planeMin) {
-         int toRank = myRank - domain.tp()*domain.tp() - 1 ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dy; ++i) {
-               destAddr[i] = (domain.*src)(i*dx) ;
-            }
-            destAddr += dy ;
+/* Unpacks one message, adding it to the fields or overwriting them.
+   The offsets of a message are distinct, so its values scatter in any
+   order; the messages themselves go one after another */
+static void CommUnpackMsg(Real_t *const fields[], Index_t xferFields,
+                          const Index_t offset[], Index_t count,
+                          const Real_t *srcAddr, bool sum)
+{
+#pragma omp parallel firstprivate(xferFields, count, sum) if (count*xferFields >= COMM_THREAD_MIN)
+   for (Index_t fi=0 ; fi<xferFields; ++fi) {
+      Real_t *field = fields[fi] ;
+      const Real_t *src = &srcAddr[fi*count] ;
+      if (sum) {
+#pragma omp for simd nowait
+         for (Index_t i=0; i<count; ++i) {
+            field[offset[i]] += src[i] ;
          }
-         destAddr -= xferFields*dy ;
-         MPI_Isend(destAddr, xferFields*dy, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
-         ++emsg ;
       }
-
-      if (rowMax && colMax && doSend) {
-         int toRank = myRank + domain.tp() + 1 ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               destAddr[i] = (domain.*src)(dx*dy - 1 + i*dx*dy) ;
-            }
-            destAddr += dz ;
+      else {
+#pragma omp for simd nowait
+         for (Index_t i=0; i<count; ++i) {
+            field[offset[i]] = src[i] ;
          }
-         destAddr -= xferFields*dz ;
-         MPI_Isend(destAddr, xferFields*dz, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
-         ++emsg ;
       }
+   }
+}
 
-      if (rowMax && planeMax && doSend) {
-         int toRank = myRank + domain.tp()*domain.tp() + domain.tp() ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dx; ++i) {
-              destAddr[i] = (domain.*src)(dx*(dy-1) + dx*dy*(dz-1) + i) ;
-            }
-            destAddr += dx ;
-         }
-         destAddr -= xferFields*dx ;
-         MPI_Isend(destAddr, xferFields*dx, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
+/******************************************/
 
-      if (colMax && planeMax && doSend) {
-         int toRank = myRank + domain.tp()*domain.tp() + 1 ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dy; ++i) {
-               destAddr[i] = (domain.*src)(dx*dy*(dz-1) + dx - 1 + i*dx) ;
-            }
-            destAddr += dy ;
-         }
-         destAddr -= xferFields*dy ;
-         MPI_Isend(destAddr, xferFields*dy, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
+/* Graph communicator of the plan, with its receives as sources and its
+   sends as destinations, in the order of the messages */
+static void BuildCommGraph(CommPlan& plan)
+{
+   int sources[26], destinations[26] ;
+   Index_t xferFields = plan.xferFields ;
 
-      if (rowMax && colMin && doSend) {
-         int toRank = myRank + domain.tp() - 1 ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               destAddr[i] = (domain.*src)(dx*(dy-1) + i*dx*dy) ;
-            }
-            destAddr += dz ;
-         }
-         destAddr -= xferFields*dz ;
-         MPI_Isend(destAddr, xferFields*dz, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
+   for (Int_t m=0 ; m<plan.numRecv ; ++m) {
+      sources[m] = plan.recv[m].rank ;
+      plan.recvCounts[m] = plan.recv[m].count*xferFields ;
+      plan.recvDispls[m] = plan.recv[m].offset ;
+   }
+   for (Int_t m=0 ; m<plan.numSend ; ++m) {
+      destinations[m] = plan.send[m].rank ;
+      plan.sendCounts[m] = plan.send[m].count*xferFields ;
+      plan.sendDispls[m] = plan.send[m].offset ;
+   }
 
-      if (rowMin && planeMax && doSend) {
-         int toRank = myRank + domain.tp()*domain.tp() - domain.tp() ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dx; ++i) {
-               destAddr[i] = (domain.*src)(dx*dy*(dz-1) + i) ;
-            }
-            destAddr += dx ;
-         }
-         destAddr -= xferFields*dx ;
-         MPI_Isend(destAddr, xferFields*dx, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
+   MPI_Dist_graph_create_adjacent(MPI_COMM_WORLD,
+                                  plan.numRecv, sources, MPI_UNWEIGHTED,
+                                  plan.numSend, destinations, MPI_UNWEIGHTED,
+                                  MPI_INFO_NULL, 0, &plan.graphComm) ;
+}
 
-      if (colMin && planeMax && doSend) {
-         int toRank = myRank + domain.tp()*domain.tp() - 1 ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dy; ++i) {
-               destAddr[i] = (domain.*src)(dx*dy*(dz-1) + i*dx) ;
-            }
-            destAddr += dy ;
-         }
-         destAddr -= xferFields*dy ;
-         MPI_Isend(destAddr, xferFields*dy, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
+/******************************************/
 
-      if (rowMin && colMax) {
-         int toRank = myRank - domain.tp() + 1 ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               destAddr[i] = (domain.*src)(dx - 1 + i*dx*dy) ;
-            }
-            destAddr += dz ;
-         }
-         destAddr -= xferFields*dz ;
-         MPI_Isend(destAddr, xferFields*dz, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
+/* doRecv flag only works with regular block structure */
+void CommRecv(Domain& domain, Int_t msgType, Index_t xferFields,
+              Index_t dx, Index_t dy, Index_t dz, bool doRecv, bool planeOnly) {
 
-      if (rowMax && planeMin) {
-         int toRank = myRank - domain.tp()*domain.tp() + domain.tp() ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dx; ++i) {
-               destAddr[i] = (domain.*src)(dx*(dy - 1) + i) ;
-            }
-            destAddr += dx ;
-         }
-         destAddr -= xferFields*dx ;
-         MPI_Isend(destAddr, xferFields*dx, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
+   if (domain.numRanks() == 1)
+      return ;
 
-      if (colMax && planeMin) {
-         int toRank = myRank - domain.tp()*domain.tp() + 1 ;
-         destAddr = &domain.commDataSend[pmsg * maxPlaneComm +
-                                          emsg * maxEdgeComm] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            Domain_member src = fieldData[fi] ;
-            for (Index_t i=0; i<dy; ++i) {
-               destAddr[i] = (domain.*src)(dx - 1 + i*dx) ;
-            }
-            destAddr += dy ;
-         }
-         destAddr -= xferFields*dy ;
-         MPI_Isend(destAddr, xferFields*dy, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg]) ;
-         ++emsg ;
-      }
+   CommPlan& plan = FindCommPlan(domain, msgType, xferFields) ;
 
-      if (rowMin && colMin && planeMin) {
-         /* corner at domain logical coord (0, 0, 0) */
-         int toRank = myRank - domain.tp()*domain.tp() - domain.tp() - 1 ;
-         Real_t *comBuf = &domain.commDataSend[pmsg * maxPlaneComm +
-                                                emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            comBuf[fi] = (domain.*fieldData[fi])(0) ;
-         }
-         MPI_Isend(comBuf, xferFields, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg+cmsg]) ;
-         ++cmsg ;
-      }
-      if (rowMin && colMin && planeMax && doSend) {
-         /* corner at domain logical coord (0, 0, 1) */
-         int toRank = myRank + domain.tp()*domain.tp() - domain.tp() - 1 ;
-         Real_t *comBuf = &domain.commDataSend[pmsg * maxPlaneComm +
-                                                emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL] ;
-         Index_t idx = dx*dy*(dz - 1) ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            comBuf[fi] = (domain.*fieldData[fi])(idx) ;
-         }
-         MPI_Isend(comBuf, xferFields, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg+cmsg]) ;
-         ++cmsg ;
-      }
-      if (rowMin && colMax && planeMin) {
-         /* corner at domain logical coord (1, 0, 0) */
-         int toRank = myRank - domain.tp()*domain.tp() - domain.tp() + 1 ;
-         Real_t *comBuf = &domain.commDataSend[pmsg * maxPlaneComm +
-                                                emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL] ;
-         Index_t idx = dx - 1 ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            comBuf[fi] = (domain.*fieldData[fi])(idx) ;
-         }
-         MPI_Isend(comBuf, xferFields, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg+cmsg]) ;
-         ++cmsg ;
-      }
-      if (rowMin && colMax && planeMax && doSend) {
-         /* corner at domain logical coord (1, 0, 1) */
-         int toRank = myRank + domain.tp()*domain.tp() - domain.tp() + 1 ;
-         Real_t *comBuf = &domain.commDataSend[pmsg * maxPlaneComm +
-                                                emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL] ;
-         Index_t idx = dx*dy*(dz - 1) + (dx - 1) ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            comBuf[fi] = (domain.*fieldData[fi])(idx) ;
-         }
-         MPI_Isend(comBuf, xferFields, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg+cmsg]) ;
-         ++cmsg ;
-      }
-      if (rowMax && colMin && planeMin) {
-         /* corner at domain logical coord (0, 1, 0) */
-         int toRank = myRank - domain.tp()*domain.tp() + domain.tp() - 1 ;
-         Real_t *comBuf = &domain.commDataSend[pmsg * maxPlaneComm +
-                                                emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL] ;
-         Index_t idx = dx*(dy - 1) ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            comBuf[fi] = (domain.*fieldData[fi])(idx) ;
-         }
-         MPI_Isend(comBuf, xferFields, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg+cmsg]) ;
-         ++cmsg ;
-      }
-      if (rowMax && colMin && planeMax && doSend) {
-         /* corner at domain logical coord (0, 1, 1) */
-         int toRank = myRank + domain.tp()*domain.tp() + domain.tp() - 1 ;
-         Real_t *comBuf = &domain.commDataSend[pmsg * maxPlaneComm +
-                                                emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL] ;
-         Index_t idx = dx*dy*(dz - 1) + dx*(dy - 1) ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            comBuf[fi] = (domain.*fieldData[fi])(idx) ;
-         }
-         MPI_Isend(comBuf, xferFields, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg+cmsg]) ;
-         ++cmsg ;
-      }
-      if (rowMax && colMax && planeMin) {
-         /* corner at domain logical coord (1, 1, 0) */
-         int toRank = myRank - domain.tp()*domain.tp() + domain.tp() + 1 ;
-         Real_t *comBuf = &domain.commDataSend[pmsg * maxPlaneComm +
-                                                emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL] ;
-         Index_t idx = dx*dy - 1 ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            comBuf[fi] = (domain.*fieldData[fi])(idx) ;
+   if (plan.numRecv < 0) {
+      MPI_Datatype baseType = ((sizeof(Real_t) == 4) ? MPI_FLOAT : MPI_DOUBLE) ;
+      plan.numRecv = BuildCommMsgs(domain, xferFields, dx, dy, dz,
+                                   doRecv, planeOnly, 1,
+                                   plan.recv, plan.recvIndex) ;
+
+      /* the velocity gradients land in the ghost elements, face after
+         face, instead of the faces of the block */
+      if (msgType == MSG_MONOQ) {
+         for (size_t i=0 ; i<plan.recvIndex.size() ; ++i) {
+            plan.recvIndex[i] = domain.numElem() + i ;
          }
-         MPI_Isend(comBuf, xferFields, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg+cmsg]) ;
-         ++cmsg ;
       }
-      if (rowMax && colMax && planeMax && doSend) {
-         /* corner at domain logical coord (1, 1, 1) */
-         int toRank = myRank + domain.tp()*domain.tp() + domain.tp() + 1 ;
-         Real_t *comBuf = &domain.commDataSend[pmsg * maxPlaneComm +
-                                                emsg * maxEdgeComm +
-                                         cmsg * CACHE_COHERENCE_PAD_REAL] ;
-         Index_t idx = dx*dy*dz - 1 ;
-         for (Index_t fi=0; fi<xferFields; ++fi) {
-            comBuf[fi] = (domain.*fieldData[fi])(idx) ;
+
+      if (!plan.neighbor) {
+         for (Int_t m=0 ; m<plan.numRecv ; ++m) {
+            MPI_Recv_init(&domain.commDataRecv[plan.recv[m].offset],
+                          plan.recv[m].count*xferFields, baseType,
+                          plan.recv[m].rank, msgType,
+                          MPI_COMM_WORLD, &plan.recvRequest[m]) ;
          }
-         MPI_Isend(comBuf, xferFields, baseType, toRank, msgType,
-                   MPI_COMM_WORLD, &domain.sendRequest[pmsg+emsg+cmsg]) ;
-         ++cmsg ;
       }
    }
 
-   MPI_Waitall(26, domain.sendRequest, status) ;
+   /* post receives, the neighborhood collective receives with its sends */
+   if (!plan.neighbor) {
+      MPI_Startall(plan.numRecv, plan.recvRequest) ;
+   }
 }
 
 /******************************************/
 
-void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
+void CommSend(Domain& domain, Int_t msgType,
+              Index_t xferFields, Domain_member *fieldData,
+              Index_t dx, Index_t dy, Index_t dz, bool doSend, bool planeOnly)
+{
 
    if (domain.numRanks() == 1)
       return ;
 
-   /* summation order should be from smallest value to largest */
-   /* or we could try out kahan summation! */
-
-   int myRank ;
-   Index_t maxPlaneComm = xferFields * domain.maxPlaneSize() ;
-   Index_t maxEdgeComm  = xferFields * domain.maxEdgeSize() ;
-   Index_t pmsg = 0 ; /* plane comm msg */
-   Index_t emsg = 0 ; /* edge comm msg */
-   Index_t cmsg = 0 ; /* corner comm msg */
-   Index_t dx = domain.sizeX() + 1 ;
-   Index_t dy = domain.sizeY() + 1 ;
-   Index_t dz = domain.sizeZ() + 1 ;
-   MPI_Status status ;
-   Real_t *srcAddr ;
-   Index_t rowMin, rowMax, colMin, colMax, planeMin, planeMax ;
-   /* assume communication to 6 neighbors by default */
-   rowMin = rowMax = colMin = colMax = planeMin = planeMax = 1 ;
-   if (domain.rowLoc() == 0) {
-      rowMin = 0 ;
-   }
-   if (domain.rowLoc() == (domain.tp()-1)) {
-      rowMax = 0 ;
-   }
-   if (domain.colLoc() == 0) {
-      colMin = 0 ;
-   }
-   if (domain.colLoc() == (domain.tp()-1)) {
-      colMax = 0 ;
-   }
-   if (domain.planeLoc() == 0) {
-      planeMin = 0 ;
-   }
-   if (domain.planeLoc() == (domain.tp()-1)) {
-      planeMax = 0 ;
-   }
-
-   MPI_Comm_rank(MPI_COMM_WORLD, &myRank) ;
-
-   if (planeMin | planeMax) {
-      /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
-      Index_t opCount = dx * dy ;
-
-      if (planeMin) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(i) += srcAddr[i] ;
-            }
-            srcAddr += opCount ;
-         }
-         ++pmsg ;
+   CommPlan& plan = FindCommPlan(domain, msgType, xferFields) ;
+
+   if (plan.numSend < 0) {
+      MPI_Datatype baseType = ((sizeof(Real_t) == 4) ? MPI_FLOAT : MPI_DOUBLE) ;
+      plan.numSend = BuildCommMsgs(domain, xferFields, dx, dy, dz,
+                                   doSend, planeOnly, -1,
+                                   plan.send, plan.sendIndex) ;
+
+      if (plan.neighbor) {
+         if (plan.numRecv < 0) {
+            fprintf(stderr, "CommSend of message type %d before its CommRecv\n",
+                    int(msgType)) ;
+            MPI_Abort(MPI_COMM_WORLD, -1) ;
+         }
+         BuildCommGraph(plan) ;
+#if MPI_VERSION >= 4
+         MPI_Neighbor_alltoallv_init(domain.commDataSend, plan.sendCounts,
+                                     plan.sendDispls, baseType,
+                                     domain.commDataRecv, plan.recvCounts,
+                                     plan.recvDispls, baseType,
+                                     plan.graphComm, MPI_INFO_NULL,
+                                     &plan.collRequest) ;
+#endif
       }
-      if (planeMax) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(dx*dy*(dz - 1) + i) += srcAddr[i] ;
-            }
-            srcAddr += opCount ;
+      else {
+         for (Int_t m=0 ; m<plan.numSend ; ++m) {
+            MPI_Send_init(&domain.commDataSend[plan.send[m].offset],
+                          plan.send[m].count*xferFields, baseType,
+                          plan.send[m].rank, msgType,
+                          MPI_COMM_WORLD, &plan.sendRequest[m]) ;
          }
-         ++pmsg ;
       }
    }
 
-   if (rowMin | rowMax) {
-      /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
-      Index_t opCount = dx * dz ;
-
-      if (rowMin) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dx; ++j) {
-                  (domain.*dest)(i*dx*dy + j) += srcAddr[i*dx + j] ;
-               }
-            }
-            srcAddr += opCount ;
-         }
-         ++pmsg ;
-      }
-      if (rowMax) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dx; ++j) {
-                  (domain.*dest)(dx*(dy - 1) + i*dx*dy + j) += srcAddr[i*dx + j] ;
-               }
-            }
-            srcAddr += opCount ;
-         }
-         ++pmsg ;
-      }
-   }
-   if (colMin | colMax) {
-      /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
-      Index_t opCount = dy * dz ;
-
-      if (colMin) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dy; ++j) {
-                  (domain.*dest)(i*dx*dy + j*dx) += srcAddr[i*dy + j] ;
-               }
-            }
-            srcAddr += opCount ;
-         }
-         ++pmsg ;
-      }
-      if (colMax) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dy; ++j) {
-                  (domain.*dest)(dx - 1 + i*dx*dy + j*dx) += srcAddr[i*dy + j] ;
-               }
-            }
-            srcAddr += opCount ;
-         }
-         ++pmsg ;
-      }
+   if (plan.sendOffset.size() != plan.sendIndex.size()) {
+      MapCommIndices(domain, xferFields, fieldData,
+                     plan.sendIndex, plan.sendOffset) ;
    }
 
-   if (rowMin & colMin) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
+   if (plan.numSend > 0) {
+      Real_t *fields[MAX_FIELDS_PER_MPI_COMM] ;
       for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dz; ++i) {
-            (domain.*dest)(i*dx*dy) += srcAddr[i] ;
-         }
-         srcAddr += dz ;
-      }
-      ++emsg ;
+         fields[fi] = &(domain.*fieldData[fi])(0) ;
+      }
+      CommPack(fields, xferFields, plan.send, plan.numSend,
+               &plan.sendOffset[0], domain.commDataSend,
+               Index_t(plan.sendOffset.size())*xferFields) ;
+   }
+
+   /* post sends, they complete with the unpacking of the exchange */
+   if (plan.neighbor) {
+#if MPI_VERSION >= 4
+      MPI_Start(&plan.collRequest) ;
+#else
+      MPI_Datatype baseType = ((sizeof(Real_t) == 4) ? MPI_FLOAT : MPI_DOUBLE) ;
+      MPI_Ineighbor_alltoallv(domain.commDataSend, plan.sendCounts,
+                              plan.sendDispls, baseType,
+                              domain.commDataRecv, plan.recvCounts,
+                              plan.recvDispls, baseType,
+                              plan.graphComm, &plan.collRequest) ;
+#endif
    }
-
-   if (rowMin & planeMin) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dx; ++i) {
-            (domain.*dest)(i) += srcAddr[i] ;
-         }
-         srcAddr += dx ;
-      }
-      ++emsg ;
+   else {
+      MPI_Startall(plan.numSend, plan.sendRequest) ;
    }
+}
 
-   if (colMin & planeMin) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dy; ++i) {
-            (domain.*dest)(i*dx) += srcAddr[i] ;
-         }
-         srcAddr += dy ;
-      }
-      ++emsg ;
-   }
+/******************************************/
 
-   if (rowMax & colMax) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dz; ++i) {
-            (domain.*dest)(dx*dy - 1 + i*dx*dy) += srcAddr[i] ;
-         }
-         srcAddr += dz ;
-      }
-      ++emsg ;
-   }
+/* Unpacks the messages in the order of the plan, adding them to the
+   fields or overwriting them, and completes the sends so the next
+   exchange can reuse commDataSend */
+static void CommUnpack(Domain& domain, CommPlan& plan,
+                       Domain_member *fieldData, bool sum)
+{
+   Index_t xferFields = plan.xferFields ;
+   Real_t *fields[MAX_FIELDS_PER_MPI_COMM] ;
 
-   if (rowMax & planeMax) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dx; ++i) {
-            (domain.*dest)(dx*(dy-1) + dx*dy*(dz-1) + i) += srcAddr[i] ;
-         }
-         srcAddr += dx ;
+   if (plan.numRecv > 0) {
+      if (plan.recvOffset.size() != plan.recvIndex.size()) {
+         MapCommIndices(domain, xferFields, fieldData,
+                        plan.recvIndex, plan.recvOffset) ;
       }
-      ++emsg ;
-   }
-
-   if (colMax & planeMax) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
       for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dy; ++i) {
-            (domain.*dest)(dx*dy*(dz-1) + dx - 1 + i*dx) += srcAddr[i] ;
-         }
-         srcAddr += dy ;
+         fields[fi] = &(domain.*fieldData[fi])(0) ;
       }
-      ++emsg ;
    }
 
-   if (rowMax & colMin) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dz; ++i) {
-            (domain.*dest)(dx*(dy-1) + i*dx*dy) += srcAddr[i] ;
-         }
-         srcAddr += dz ;
-      }
-      ++emsg ;
+   if (plan.neighbor) {
+      MPI_Wait(&plan.collRequest, MPI_STATUS_IGNORE) ;
    }
 
-   if (rowMin & planeMax) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dx; ++i) {
-            (domain.*dest)(dx*dy*(dz-1) + i) += srcAddr[i] ;
-         }
-         srcAddr += dx ;
+   for (Int_t m=0 ; m<plan.numRecv ; ++m) {
+      if (!plan.neighbor) {
+         MPI_Wait(&plan.recvRequest[m], MPI_STATUS_IGNORE) ;
       }
-      ++emsg ;
+      CommUnpackMsg(fields, xferFields,
+                    &plan.recvOffset[plan.recv[m].first], plan.recv[m].count,
+                    &domain.commDataRecv[plan.recv[m].offset], sum) ;
    }
 
-   if (colMin & planeMax) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dy; ++i) {
-            (domain.*dest)(dx*dy*(dz-1) + i*dx) += srcAddr[i] ;
-         }
-         srcAddr += dy ;
-      }
-      ++emsg ;
+   if (!plan.neighbor && plan.numSend > 0) {
+      MPI_Waitall(plan.numSend, plan.sendRequest, MPI_STATUSES_IGNORE) ;
    }
+}
 
-   if (rowMin & colMax) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dz; ++i) {
-            (domain.*dest)(dx - 1 + i*dx*dy) += srcAddr[i] ;
-         }
-         srcAddr += dz ;
-      }
-      ++emsg ;
-   }
+/******************************************/
 
-   if (rowMax & planeMin) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dx; ++i) {
-            (domain.*dest)(dx*(dy - 1) + i) += srcAddr[i] ;
-         }
-         srcAddr += dx ;
-      }
-      ++emsg ;
-   }
+void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData) {
 
-   if (colMax & planeMin) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dy; ++i) {
-            (domain.*dest)(dx - 1 + i*dx) += srcAddr[i] ;
-         }
-         srcAddr += dy ;
-      }
-      ++emsg ;
-   }
+   if (domain.numRanks() == 1)
+      return ;
 
-   if (rowMin & colMin & planeMin) {
-      /* corner at domain logical coord (0, 0, 0) */
-      Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                             emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(0) += comBuf[fi] ;
-      }
-      ++cmsg ;
-   }
-   if (rowMin & colMin & planeMax) {
-      /* corner at domain logical coord (0, 0, 1) */
-      Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                             emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      Index_t idx = dx*dy*(dz - 1) ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) += comBuf[fi] ;
-      }
-      ++cmsg ;
-   }
-   if (rowMin & colMax & planeMin) {
-      /* corner at domain logical coord (1, 0, 0) */
-      Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                             emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      Index_t idx = dx - 1 ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) += comBuf[fi] ;
-      }
-      ++cmsg ;
-   }
-   if (rowMin & colMax & planeMax) {
-      /* corner at domain logical coord (1, 0, 1) */
-      Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                             emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      Index_t idx = dx*dy*(dz - 1) + (dx - 1) ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) += comBuf[fi] ;
-      }
-      ++cmsg ;
-   }
-   if (rowMax & colMin & planeMin) {
-      /* corner at domain logical coord (0, 1, 0) */
-      Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                             emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      Index_t idx = dx*(dy - 1) ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) += comBuf[fi] ;
-      }
-      ++cmsg ;
-   }
-   if (rowMax & colMin & planeMax) {
-      /* corner at domain logical coord (0, 1, 1) */
-      Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                             emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      Index_t idx = dx*dy*(dz - 1) + dx*(dy - 1) ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) += comBuf[fi] ;
-      }
-      ++cmsg ;
-   }
-   if (rowMax & colMax & planeMin) {
-      /* corner at domain logical coord (1, 1, 0) */
-      Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                             emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      Index_t idx = dx*dy - 1 ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) += comBuf[fi] ;
-      }
-      ++cmsg ;
-   }
-   if (rowMax & colMax & planeMax) {
-      /* corner at domain logical coord (1, 1, 1) */
-      Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                             emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      Index_t idx = dx*dy*dz - 1 ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) += comBuf[fi] ;
-      }
-      ++cmsg ;
-   }
+   /* summation order should be from smallest value to largest */
+   /* or we could try out kahan summation! */
+
+   CommUnpack(domain, FindCommPlan(domain, MSG_COMM_SBN, xferFields),
+              fieldData, true) ;
 }
 
 /******************************************/
@@ -1263,42 +447,8 @@ void CommSyncPosVel(Domain& domain) {
    if (domain.numRanks() == 1)
       return ;
 
-   int myRank ;
-   bool doRecv = false ;
    Index_t xferFields = 6 ; /* x, y, z, xd, yd, zd */
    Domain_member fieldData[6] ;
-   Index_t maxPlaneComm = xferFields * domain.maxPlaneSize() ;
-   Index_t maxEdgeComm  = xferFields * domain.maxEdgeSize() ;
-   Index_t pmsg = 0 ; /* plane comm msg */
-   Index_t emsg = 0 ; /* edge comm msg */
-   Index_t cmsg = 0 ; /* corner comm msg */
-   Index_t dx = domain.sizeX() + 1 ;
-   Index_t dy = domain.sizeY() + 1 ;
-   Index_t dz = domain.sizeZ() + 1 ;
-   MPI_Status status ;
-   Real_t *srcAddr ;
-   bool rowMin, rowMax, colMin, colMax, planeMin, planeMax ;
-
-   /* assume communication to 6 neighbors by default */
-   rowMin = rowMax = colMin = colMax = planeMin = planeMax = true ;
-   if (domain.rowLoc() == 0) {
-      rowMin = false ;
-   }
-   if (domain.rowLoc() == (domain.tp()-1)) {
-      rowMax = false ;
-   }
-   if (domain.colLoc() == 0) {
-      colMin = false ;
-   }
-   if (domain.colLoc() == (domain.tp()-1)) {
-      colMax = false ;
-   }
-   if (domain.planeLoc() == 0) {
-      planeMin = false ;
-   }
-   if (domain.planeLoc() == (domain.tp()-1)) {
-      planeMax = false ;
-   }
 
    fieldData[0] = &Domain::x ;
    fieldData[1] = &Domain::y ;
@@ -1307,376 +457,8 @@ void CommSyncPosVel(Domain& domain) {
    fieldData[4] = &Domain::yd ;
    fieldData[5] = &Domain::zd ;
 
-   MPI_Comm_rank(MPI_COMM_WORLD, &myRank) ;
-
-   if (planeMin | planeMax) {
-      /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
-      Index_t opCount = dx * dy ;
-
-      if (planeMin && doRecv) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(i) = srcAddr[i] ;
-            }
-            srcAddr += opCount ;
-         }
-         ++pmsg ;
-      }
-      if (planeMax) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(dx*dy*(dz - 1) + i) = srcAddr[i] ;
-            }
-            srcAddr += opCount ;
-         }
-         ++pmsg ;
-      }
-   }
-
-   if (rowMin | rowMax) {
-      /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
-      Index_t opCount = dx * dz ;
-
-      if (rowMin && doRecv) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dx; ++j) {
-                  (domain.*dest)(i*dx*dy + j) = srcAddr[i*dx + j] ;
-               }
-            }
-            srcAddr += opCount ;
-         }
-         ++pmsg ;
-      }
-      if (rowMax) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dx; ++j) {
-                  (domain.*dest)(dx*(dy - 1) + i*dx*dy + j) = srcAddr[i*dx + j] ;
-               }
-            }
-            srcAddr += opCount ;
-         }
-         ++pmsg ;
-      }
-   }
-
-   if (colMin | colMax) {
-      /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
-      Index_t opCount = dy * dz ;
-
-      if (colMin && doRecv) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dy; ++j) {
-                  (domain.*dest)(i*dx*dy + j*dx) = srcAddr[i*dy + j] ;
-               }
-            }
-            srcAddr += opCount ;
-         }
-         ++pmsg ;
-      }
-      if (colMax) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<dz; ++i) {
-               for (Index_t j=0; j<dy; ++j) {
-                  (domain.*dest)(dx - 1 + i*dx*dy + j*dx) = srcAddr[i*dy + j] ;
-               }
-            }
-            srcAddr += opCount ;
-         }
-         ++pmsg ;
-      }
-   }
-
-   if (rowMin && colMin && doRecv) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dz; ++i) {
-            (domain.*dest)(i*dx*dy) = srcAddr[i] ;
-         }
-         srcAddr += dz ;
-      }
-      ++emsg ;
-   }
-
-   if (rowMin && planeMin && doRecv) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dx; ++i) {
-            (domain.*dest)(i) = srcAddr[i] ;
-         }
-         srcAddr += dx ;
-      }
-      ++emsg ;
-   }
-
-   if (colMin && planeMin && doRecv) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dy; ++i) {
-            (domain.*dest)(i*dx) = srcAddr[i] ;
-         }
-         srcAddr += dy ;
-      }
-      ++emsg ;
-   }
-
-   if (rowMax && colMax) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dz; ++i) {
-            (domain.*dest)(dx*dy - 1 + i*dx*dy) = srcAddr[i] ;
-         }
-         srcAddr += dz ;
-      }
-      ++emsg ;
-   }
-
-   if (rowMax && planeMax) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dx; ++i) {
-            (domain.*dest)(dx*(dy-1) + dx*dy*(dz-1) + i) = srcAddr[i] ;
-         }
-         srcAddr += dx ;
-      }
-      ++emsg ;
-   }
-
-   if (colMax && planeMax) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dy; ++i) {
-            (domain.*dest)(dx*dy*(dz-1) + dx - 1 + i*dx) = srcAddr[i] ;
-         }
-         srcAddr += dy ;
-      }
-      ++emsg ;
-   }
-
-   if (rowMax && colMin) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dz; ++i) {
-            (domain.*dest)(dx*(dy-1) + i*dx*dy) = srcAddr[i] ;
-         }
-         srcAddr += dz ;
-      }
-      ++emsg ;
-   }
-
-   if (rowMin && planeMax) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dx; ++i) {
-            (domain.*dest)(dx*dy*(dz-1) + i) = srcAddr[i] ;
-         }
-         srcAddr += dx ;
-      }
-      ++emsg ;
-   }
-
-   if (colMin && planeMax) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dy; ++i) {
-            (domain.*dest)(dx*dy*(dz-1) + i*dx) = srcAddr[i] ;
-         }
-         srcAddr += dy ;
-      }
-      ++emsg ;
-   }
-
-   if (rowMin && colMax && doRecv) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dz; ++i) {
-            (domain.*dest)(dx - 1 + i*dx*dy) = srcAddr[i] ;
-         }
-         srcAddr += dz ;
-      }
-      ++emsg ;
-   }
-
-   if (rowMax && planeMin && doRecv) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dx; ++i) {
-            (domain.*dest)(dx*(dy - 1) + i) = srcAddr[i] ;
-         }
-         srcAddr += dx ;
-      }
-      ++emsg ;
-   }
-
-   if (colMax && planeMin && doRecv) {
-      srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                       emsg * maxEdgeComm] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg], &status) ;
-      for (Index_t fi=0 ; fi<xferFields; ++fi) {
-         Domain_member dest = fieldData[fi] ;
-         for (Index_t i=0; i<dy; ++i) {
-            (domain.*dest)(dx - 1 + i*dx) = srcAddr[i] ;
-         }
-         srcAddr += dy ;
-      }
-      ++emsg ;
-   }
-
-
-   if (rowMin && colMin && planeMin && doRecv) {
-      /* corner at domain logical coord (0, 0, 0) */
-      Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                             emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(0) = comBuf[fi] ;
-      }
-      ++cmsg ;
-   }
-   if (rowMin && colMin && planeMax) {
-      /* corner at domain logical coord (0, 0, 1) */
-      Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                             emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      Index_t idx = dx*dy*(dz - 1) ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) = comBuf[fi] ;
-      }
-      ++cmsg ;
-   }
-   if (rowMin && colMax && planeMin && doRecv) {
-      /* corner at domain logical coord (1, 0, 0) */
-      Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                             emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      Index_t idx = dx - 1 ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) = comBuf[fi] ;
-      }
-      ++cmsg ;
-   }
-   if (rowMin && colMax && planeMax) {
-      /* corner at domain logical coord (1, 0, 1) */
-      Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                             emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      Index_t idx = dx*dy*(dz - 1) + (dx - 1) ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) = comBuf[fi] ;
-      }
-      ++cmsg ;
-   }
-   if (rowMax && colMin && planeMin && doRecv) {
-      /* corner at domain logical coord (0, 1, 0) */
-      Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                             emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      Index_t idx = dx*(dy - 1) ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) = comBuf[fi] ;
-      }
-      ++cmsg ;
-   }
-   if (rowMax && colMin && planeMax) {
-      /* corner at domain logical coord (0, 1, 1) */
-      Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                             emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      Index_t idx = dx*dy*(dz - 1) + dx*(dy - 1) ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) = comBuf[fi] ;
-      }
-      ++cmsg ;
-   }
-   if (rowMax && colMax && planeMin && doRecv) {
-      /* corner at domain logical coord (1, 1, 0) */
-      Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                             emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      Index_t idx = dx*dy - 1 ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) = comBuf[fi] ;
-      }
-      ++cmsg ;
-   }
-   if (rowMax && colMax && planeMax) {
-      /* corner at domain logical coord (1, 1, 1) */
-      Real_t *comBuf = &domain.commDataRecv[pmsg * maxPlaneComm +
-                                             emsg * maxEdgeComm +
-                                      cmsg * CACHE_COHERENCE_PAD_REAL] ;
-      Index_t idx = dx*dy*dz - 1 ;
-      MPI_Wait(&domain.recvRequest[pmsg+emsg+cmsg], &status) ;
-      for (Index_t fi=0; fi<xferFields; ++fi) {
-         (domain.*fieldData[fi])(idx) = comBuf[fi] ;
-      }
-      ++cmsg ;
-   }
+   CommUnpack(domain, FindCommPlan(domain, MSG_SYNC_POS_VEL, xferFields),
+              fieldData, false) ;
 }
 
 /******************************************/
@@ -1686,152 +468,44 @@ void CommMonoQ(Domain& domain)
    if (domain.numRanks() == 1)
       return ;
 
-   int myRank ;
    Index_t xferFields = 3 ; /* delv_xi, delv_eta, delv_zeta */
    Domain_member fieldData[3] ;
-   Index_t fieldOffset[3] ;
-   Index_t maxPlaneComm = xferFields * domain.maxPlaneSize() ;
-   Index_t pmsg = 0 ; /* plane comm msg */
-   Index_t dx = domain.sizeX() ;
-   Index_t dy = domain.sizeY() ;
-   Index_t dz = domain.sizeZ() ;
-   MPI_Status status ;
-   Real_t *srcAddr ;
-   bool rowMin, rowMax, colMin, colMax, planeMin, planeMax ;
-   /* assume communication to 6 neighbors by default */
-   rowMin = rowMax = colMin = colMax = planeMin = planeMax = true ;
-   if (domain.rowLoc() == 0) {
-      rowMin = false ;
-   }
-   if (domain.rowLoc() == (domain.tp()-1)) {
-      rowMax = false ;
-   }
-   if (domain.colLoc() == 0) {
-      colMin = false ;
-   }
-   if (domain.colLoc() == (domain.tp()-1)) {
-      colMax = false ;
-   }
-   if (domain.planeLoc() == 0) {
-      planeMin = false ;
-   }
-   if (domain.planeLoc() == (domain.tp()-1)) {
-      planeMax = false ;
-   }
 
-   /* point into ghost data area */
-   // fieldData[0] = &(domain.delv_xi(domain.numElem())) ;
-   // fieldData[1] = &(domain.delv_eta(domain.numElem())) ;
-   // fieldData[2] = &(domain.delv_zeta(domain.numElem())) ;
    fieldData[0] = &Domain::delv_xi ;
    fieldData[1] = &Domain::delv_eta ;
    fieldData[2] = &Domain::delv_zeta ;
-   fieldOffset[0] = domain.numElem() ;
-   fieldOffset[1] = domain.numElem() ;
-   fieldOffset[2] = domain.numElem() ;
-
 
-   MPI_Comm_rank(MPI_COMM_WORLD, &myRank) ;
+   CommUnpack(domain, FindCommPlan(domain, MSG_MONOQ, xferFields),
+              fieldData, false) ;
+}
 
-   if (planeMin | planeMax) {
-      /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
-      Index_t opCount = dx * dy ;
-
-      if (planeMin) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(fieldOffset[fi] + i) = srcAddr[i] ;
-            }
-            srcAddr += opCount ;
-            fieldOffset[fi] += opCount ;
-         }
-         ++pmsg ;
-      }
-      if (planeMax) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(fieldOffset[fi] + i) = srcAddr[i] ;
-            }
-            srcAddr += opCount ;
-            fieldOffset[fi] += opCount ;
-         }
-         ++pmsg ;
-      }
-   }
+/******************************************/
 
-   if (rowMin | rowMax) {
-      /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
-      Index_t opCount = dx * dz ;
-
-      if (rowMin) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(fieldOffset[fi] + i) = srcAddr[i] ;
-            }
-            srcAddr += opCount ;
-            fieldOffset[fi] += opCount ;
+void CommFreePlans(Domain& domain)
+{
+   for (size_t p=0 ; p<domain.commPlans.size() ; ++p) {
+      CommPlan *plan = domain.commPlans[p] ;
+      if (plan->neighbor) {
+#if MPI_VERSION >= 4
+         if (plan->collRequest != MPI_REQUEST_NULL) {
+            MPI_Request_free(&plan->collRequest) ;
          }
-         ++pmsg ;
-      }
-      if (rowMax) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(fieldOffset[fi] + i) = srcAddr[i] ;
-            }
-            srcAddr += opCount ;
-            fieldOffset[fi] += opCount ;
+#endif
+         if (plan->graphComm != MPI_COMM_NULL) {
+            MPI_Comm_free(&plan->graphComm) ;
          }
-         ++pmsg ;
       }
-   }
-   if (colMin | colMax) {
-      /* ASSUMING ONE DOMAIN PER RANK, CONSTANT BLOCK SIZE HERE */
-      Index_t opCount = dy * dz ;
-
-      if (colMin) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(fieldOffset[fi] + i) = srcAddr[i] ;
-            }
-            srcAddr += opCount ;
-            fieldOffset[fi] += opCount ;
+      else {
+         for (Int_t m=0 ; m<plan->numRecv ; ++m) {
+            MPI_Request_free(&plan->recvRequest[m]) ;
          }
-         ++pmsg ;
-      }
-      if (colMax) {
-         /* contiguous memory */
-         srcAddr = &domain.commDataRecv[pmsg * maxPlaneComm] ;
-         MPI_Wait(&domain.recvRequest[pmsg], &status) ;
-         for (Index_t fi=0 ; fi<xferFields; ++fi) {
-            Domain_member dest = fieldData[fi] ;
-            for (Index_t i=0; i<opCount; ++i) {
-               (domain.*dest)(fieldOffset[fi] + i) = srcAddr[i] ;
-            }
-            srcAddr += opCount ;
+         for (Int_t m=0 ; m<plan->numSend ; ++m) {
+            MPI_Request_free(&plan->sendRequest[m]) ;
          }
-         ++pmsg ;
       }
+      delete plan ;
    }
+   domain.commPlans.clear() ;
 }
 
 #endif
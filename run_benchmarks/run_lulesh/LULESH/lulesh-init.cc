@@ -12,10 +12,24 @@
 #include <cstdlib>
 #include "lulesh.h"
 
+/////////////////////////////////////////////////////////////////////
+/* Elements of the domain at loc along an axis of meshEdgeElems elements
+   split over numDoms domains, the first meshEdgeElems % numDoms of them
+   taking one more; *first is its first element along the axis */
+static Index_t
+DomainElems(Index_t meshEdgeElems, Int_t numDoms, Index_t loc, Index_t *first)
+{
+   Index_t base  = meshEdgeElems / numDoms ;
+   Index_t extra = meshEdgeElems % numDoms ;
+   *first = loc*base + ((loc < extra) ? loc : extra) ;
+   return base + ((loc < extra) ? 1 : 0) ;
+}
+
 /////////////////////////////////////////////////////////////////////
 Domain::Domain(Int_t numRanks, Index_t colLoc,
                Index_t rowLoc, Index_t planeLoc,
-               Index_t nx, Int_t tp, Int_t nr, Int_t balance, Int_t cost)
+               Index_t meshEdgeElems, Int_t colDoms, Int_t rowDoms,
+               Int_t planeDoms, Int_t nr, Int_t balance, Int_t cost)
    :
    m_e_cut(Real_t(1.0e-7)),
    m_p_cut(Real_t(1.0e-7)),
@@ -41,6 +55,10 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
 // simplify deallocation.
 //
    m_regNumList(0),
+   m_colorElemList(0),
+   m_partElemList(0),
+   m_partNodeList(0),
+   m_cornerNodeList(0),
    m_nodeElemStart(0),
    m_nodeElemCornerList(0),
    m_regElemSize(0),
@@ -52,12 +70,13 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
 #endif
 {
 
-   Index_t edgeElems = nx ;
-   Index_t edgeNodes = edgeElems+1 ;
+   Index_t firstElem[3] ;
    this->cost() = cost;
 
-   m_tp       = tp ;
-   m_numRanks = numRanks ;
+   m_colDoms   = colDoms ;
+   m_rowDoms   = rowDoms ;
+   m_planeDoms = planeDoms ;
+   m_numRanks  = numRanks ;
 
    ///////////////////////////////
    //   Initialize Sedov Mesh
@@ -69,12 +88,12 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
    m_rowLoc   =   rowLoc ;
    m_planeLoc = planeLoc ;
    
-   m_sizeX = edgeElems ;
-   m_sizeY = edgeElems ;
-   m_sizeZ = edgeElems ;
-   m_numElem = edgeElems*edgeElems*edgeElems ;
+   m_sizeX = DomainElems(meshEdgeElems, colDoms, colLoc, &firstElem[0]) ;
+   m_sizeY = DomainElems(meshEdgeElems, rowDoms, rowLoc, &firstElem[1]) ;
+   m_sizeZ = DomainElems(meshEdgeElems, planeDoms, planeLoc, &firstElem[2]) ;
+   m_numElem = m_sizeX*m_sizeY*m_sizeZ ;
 
-   m_numNode = edgeNodes*edgeNodes*edgeNodes ;
+   m_numNode = (m_sizeX+1)*(m_sizeY+1)*(m_sizeZ+1) ;
 
    m_regNumList = new Index_t[numElem()] ;  // material indexset
 
@@ -84,7 +103,7 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
    // Node-centered 
    AllocateNodePersistent(numNode()) ;
 
-   SetupCommBuffers(edgeNodes);
+   SetupCommBuffers();
 
    // Basic Field Initialization 
    for (Index_t i=0; i<numElem(); ++i) {
@@ -115,25 +134,33 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
       nodalMass(i) = Real_t(0.0) ;
    }
 
-   BuildMesh(nx, edgeNodes, edgeElems);
+   BuildMesh(meshEdgeElems, firstElem);
+
+   SetupElemSets();
+   m_colorScatter = 0 ;
+   m_neighborComm = 0 ;
 
 #if _OPENMP
    SetupThreadSupportStructures();
 #endif
 
+#if LULESH_SCRATCH_ARENA
+   SetupScratchArena();
+#endif
+
    // Setup region index sets. For now, these are constant sized
    // throughout the run, but could be changed every cycle to 
    // simulate effects of ALE on the lagrange solver
    CreateRegionIndexSets(nr, balance);
 
    // Setup symmetry nodesets
-   SetupSymmetryPlanes(edgeNodes);
+   SetupSymmetryPlanes();
 
    // Setup element connectivities
-   SetupElementConnectivities(edgeElems);
+   SetupElementConnectivities();
 
    // Setup symmetry planes and free surface boundary arrays
-   SetupBoundaryConditions(edgeElems);
+   SetupBoundaryConditions();
 
 
    // Setup defaults
@@ -144,7 +171,7 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
    // using the -i flag in 2.x
 
    dtfixed() = Real_t(-1.0e-6) ; // Negative means use courant condition
-   stoptime()  = Real_t(1.0e-2); // *Real_t(edgeElems*tp/45.0) ;
+   stoptime()  = Real_t(1.0e-2); // *Real_t(meshEdgeElems/45.0) ;
 
    // Initial conditions
    deltatimemultlb() = Real_t(1.1) ;
@@ -181,7 +208,7 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
    // An energy of 3.948746e+7 is correct for a problem with
    // 45 zones along a side - we need to scale it
    const Real_t ebase = Real_t(3.948746e+7);
-   Real_t scale = (nx*m_tp)/Real_t(45.0);
+   Real_t scale = meshEdgeElems/Real_t(45.0);
    Real_t einit = ebase*scale*scale*scale;
    if (m_rowLoc + m_colLoc + m_planeLoc == 0) {
       // Dump into the first zone (which we know is in the corner)
@@ -198,8 +225,12 @@ Domain::Domain(Int_t numRanks, Index_t colLoc,
 Domain::~Domain()
 {
    delete [] m_regNumList;
+   delete [] m_partElemList;
+   delete [] m_partNodeList;
+   delete [] m_cornerNodeList;
    delete [] m_nodeElemStart;
    delete [] m_nodeElemCornerList;
+   delete [] m_colorElemList;
    delete [] m_regElemSize;
    for (Index_t i=0 ; i<numReg() ; ++i) {
      delete [] m_regElemlist[i];
@@ -207,6 +238,7 @@ Domain::~Domain()
    delete [] m_regElemlist;
    
 #if USE_MPI
+   CommFreePlans(*this);
    delete [] commDataSend;
    delete [] commDataRecv;
 #endif
@@ -215,58 +247,256 @@ Domain::~Domain()
 
 ////////////////////////////////////////////////////////////////////////////////
 void
-Domain::BuildMesh(Int_t nx, Int_t edgeNodes, Int_t edgeElems)
+Domain::BuildMesh(Index_t meshEdgeElems, const Index_t firstElem[3])
 {
-  Index_t meshEdgeElems = m_tp*nx ;
+  Index_t nodesX = m_sizeX+1 ;
+  Index_t nodesY = m_sizeY+1 ;
+  Index_t nodesZ = m_sizeZ+1 ;
 
   // initialize nodal coordinates 
   Index_t nidx = 0 ;
-  Real_t tz = Real_t(1.125)*Real_t(m_planeLoc*nx)/Real_t(meshEdgeElems) ;
-  for (Index_t plane=0; plane<edgeNodes; ++plane) {
-    Real_t ty = Real_t(1.125)*Real_t(m_rowLoc*nx)/Real_t(meshEdgeElems) ;
-    for (Index_t row=0; row<edgeNodes; ++row) {
-      Real_t tx = Real_t(1.125)*Real_t(m_colLoc*nx)/Real_t(meshEdgeElems) ;
-      for (Index_t col=0; col<edgeNodes; ++col) {
+  Real_t tz = Real_t(1.125)*Real_t(firstElem[2])/Real_t(meshEdgeElems) ;
+  for (Index_t plane=0; plane<nodesZ; ++plane) {
+    Real_t ty = Real_t(1.125)*Real_t(firstElem[1])/Real_t(meshEdgeElems) ;
+    for (Index_t row=0; row<nodesY; ++row) {
+      Real_t tx = Real_t(1.125)*Real_t(firstElem[0])/Real_t(meshEdgeElems) ;
+      for (Index_t col=0; col<nodesX; ++col) {
 	x(nidx) = tx ;
 	y(nidx) = ty ;
 	z(nidx) = tz ;
 	++nidx ;
 	// tx += ds ; // may accumulate roundoff... 
-	tx = Real_t(1.125)*Real_t(m_colLoc*nx+col+1)/Real_t(meshEdgeElems) ;
+	tx = Real_t(1.125)*Real_t(firstElem[0]+col+1)/Real_t(meshEdgeElems) ;
       }
       // ty += ds ;  // may accumulate roundoff... 
-      ty = Real_t(1.125)*Real_t(m_rowLoc*nx+row+1)/Real_t(meshEdgeElems) ;
+      ty = Real_t(1.125)*Real_t(firstElem[1]+row+1)/Real_t(meshEdgeElems) ;
     }
     // tz += ds ;  // may accumulate roundoff... 
-    tz = Real_t(1.125)*Real_t(m_planeLoc*nx+plane+1)/Real_t(meshEdgeElems) ;
+    tz = Real_t(1.125)*Real_t(firstElem[2]+plane+1)/Real_t(meshEdgeElems) ;
   }
 
 
   // embed hexehedral elements in nodal point lattice 
   Index_t zidx = 0 ;
   nidx = 0 ;
-  for (Index_t plane=0; plane<edgeElems; ++plane) {
-    for (Index_t row=0; row<edgeElems; ++row) {
-      for (Index_t col=0; col<edgeElems; ++col) {
+  for (Index_t plane=0; plane<m_sizeZ; ++plane) {
+    for (Index_t row=0; row<m_sizeY; ++row) {
+      for (Index_t col=0; col<m_sizeX; ++col) {
 	Index_t *localNode = nodelist(zidx) ;
-	localNode[0] = nidx                                       ;
-	localNode[1] = nidx                                   + 1 ;
-	localNode[2] = nidx                       + edgeNodes + 1 ;
-	localNode[3] = nidx                       + edgeNodes     ;
-	localNode[4] = nidx + edgeNodes*edgeNodes                 ;
-	localNode[5] = nidx + edgeNodes*edgeNodes             + 1 ;
-	localNode[6] = nidx + edgeNodes*edgeNodes + edgeNodes + 1 ;
-	localNode[7] = nidx + edgeNodes*edgeNodes + edgeNodes     ;
+	localNode[0] = nidx                                ;
+	localNode[1] = nidx                            + 1 ;
+	localNode[2] = nidx                   + nodesX + 1 ;
+	localNode[3] = nidx                   + nodesX     ;
+	localNode[4] = nidx + nodesX*nodesY                ;
+	localNode[5] = nidx + nodesX*nodesY            + 1 ;
+	localNode[6] = nidx + nodesX*nodesY + nodesX + 1 ;
+	localNode[7] = nidx + nodesX*nodesY + nodesX     ;
 	++zidx ;
 	++nidx ;
       }
       ++nidx ;
     }
-    nidx += edgeNodes ;
+    nidx += nodesX ;
   }
 }
 
 
+#if LULESH_SCRATCH_ARENA
+////////////////////////////////////////////////////////////////////////////////
+void
+Domain::SetupScratchArena()
+{
+   // The deepest stack of timestep temporaries is in the force phase:
+   // 4 stress arrays, then 6 gradient and 3 hourglass force arrays of
+   // 8*numElem, or only the 3 corner force arrays when it is fused.
+   // The EOS phase needs at most 16*numElem in 16 allocations, each of
+   // which may be padded to the coherence size.
+   size_t elems = numElem() ;
+#if LULESH_FUSED_FORCES
+   m_scratch.Reserve(24*elems + 16*CACHE_COHERENCE_PAD_REAL) ;
+#else
+   m_scratch.Reserve(76*elems + 16*CACHE_COHERENCE_PAD_REAL) ;
+#endif
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+void
+ScratchArena::Reserve(size_t size)
+{
+   void *base = NULL ;
+   if (posix_memalign(&base, 128, sizeof(Real_t)*size) != 0) {
+      fprintf(stderr, "Cannot reserve a scratch arena of %zu bytes\n",
+              sizeof(Real_t)*size) ;
+#if USE_MPI
+      MPI_Abort(MPI_COMM_WORLD, ScratchError) ;
+#else
+      exit(ScratchError) ;
+#endif
+   }
+   free(m_base) ;
+   m_base = static_cast<Real_t *>(base) ;
+   m_capacity = size ;
+   m_top = 0 ;
+   m_slices.clear() ;
+
+   // First touch from the threads that will use the pages
+#pragma omp parallel for firstprivate(size)
+   for (size_t i=0; i<size; ++i) {
+      m_base[i] = Real_t(0.0) ;
+   }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+void
+ScratchArena::Overflow(size_t slice)
+{
+   fprintf(stderr, "Scratch arena overflow: %zu of %zu reals used, %zu requested\n",
+           m_top, m_capacity, slice) ;
+#if USE_MPI
+   MPI_Abort(MPI_COMM_WORLD, ScratchError) ;
+#else
+   exit(ScratchError) ;
+#endif
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+void
+ScratchArena::Misrelease(size_t start)
+{
+   fprintf(stderr, "Scratch arena released out of order: slice at %zu, last live slice at %zd\n",
+           start, m_slices.empty() ? ssize_t(-1) : ssize_t(m_slices.back())) ;
+#if USE_MPI
+   MPI_Abort(MPI_COMM_WORLD, ScratchError) ;
+#else
+   exit(ScratchError) ;
+#endif
+}
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+/* Part of the element or node at (col, row, plane) in a block of
+   edge[0] x edge[1] x edge[2] elements or nodes: 0 on a face shared with
+   a neighbor domain, else 1 */
+static inline Int_t
+FacePart(Index_t col, Index_t row, Index_t plane, const Index_t edge[3],
+         const bool minFace[3], const bool maxFace[3])
+{
+   if ((minFace[0] && col == 0)   || (maxFace[0] && col == edge[0]-1) ||
+       (minFace[1] && row == 0)   || (maxFace[1] && row == edge[1]-1) ||
+       (minFace[2] && plane == 0) || (maxFace[2] && plane == edge[2]-1)) {
+      return 0 ;
+   }
+   return 1 ;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+void
+Domain::SetupElemSets()
+{
+   Index_t edgeElems[3] = { m_sizeX, m_sizeY, m_sizeZ } ;
+   Index_t edgeNodes[3] = { m_sizeX+1, m_sizeY+1, m_sizeZ+1 } ;
+
+   // The faces shared with a neighbor domain
+   bool minFace[3], maxFace[3] ;
+   minFace[0] = (m_colLoc > 0) ;   maxFace[0] = (m_colLoc < m_colDoms-1) ;
+   minFace[1] = (m_rowLoc > 0) ;   maxFace[1] = (m_rowLoc < m_rowDoms-1) ;
+   minFace[2] = (m_planeLoc > 0) ; maxFace[2] = (m_planeLoc < m_planeDoms-1) ;
+
+#if LULESH_COMM_OVERLAP
+   m_numParts = 2 ;
+#else
+   m_numParts = 1 ;
+   minFace[0] = minFace[1] = minFace[2] = false ;
+   maxFace[0] = maxFace[1] = maxFace[2] = false ;
+#endif
+
+   // Elements and nodes of each part, in mesh order
+   Index_t elemPart[2], nodePart[2] ;
+   Index_t colorElemCount[16] ;
+
+   for (Int_t p=0; p < 2; ++p) {
+      elemPart[p] = nodePart[p] = 0 ;
+   }
+   for (Int_t s=0; s < 2*numColors(); ++s) {
+      colorElemCount[s] = 0 ;
+   }
+
+   // The color of an element is the parity of its column, row and
+   // plane.  Elements sharing a node are at most one apart in each
+   // direction, so two elements of the same color never share one.
+   for (Index_t plane=0; plane<edgeElems[2]; ++plane) {
+      for (Index_t row=0; row<edgeElems[1]; ++row) {
+         for (Index_t col=0; col<edgeElems[0]; ++col) {
+            Int_t p = FacePart(col, row, plane, edgeElems, minFace, maxFace) ;
+            ++elemPart[p] ;
+            ++colorElemCount[p*8 + (col & 1) + 2*(row & 1) + 4*(plane & 1)] ;
+         }
+      }
+   }
+   for (Index_t plane=0; plane<edgeNodes[2]; ++plane) {
+      for (Index_t row=0; row<edgeNodes[1]; ++row) {
+         for (Index_t col=0; col<edgeNodes[0]; ++col) {
+            ++nodePart[FacePart(col, row, plane, edgeNodes, minFace, maxFace)] ;
+         }
+      }
+   }
+
+   // Without overlap, everything is in part 1 so far
+   Int_t first = (m_numParts == 1) ? 1 : 0 ;
+
+   m_partElemStart[0] = m_partNodeStart[0] = 0 ;
+   for (Int_t p=0; p < m_numParts; ++p) {
+      m_partElemStart[p+1] = m_partElemStart[p] + elemPart[first+p] ;
+      m_partNodeStart[p+1] = m_partNodeStart[p] + nodePart[first+p] ;
+      elemPart[first+p] = m_partElemStart[p] ;
+      nodePart[first+p] = m_partNodeStart[p] ;
+   }
+
+   m_colorElemStart[0] = 0 ;
+   for (Int_t s=0; s < m_numParts*numColors(); ++s) {
+      m_colorElemStart[s+1] = m_colorElemStart[s] + colorElemCount[first*8+s] ;
+      colorElemCount[first*8+s] = m_colorElemStart[s] ;
+   }
+
+   if (m_numParts > 1) {
+      m_partElemList = new Index_t[numElem()] ;
+      m_partNodeList = new Index_t[numNode()] ;
+   }
+   m_colorElemList = new Index_t[numElem()] ;
+
+   Index_t zidx = 0 ;
+   for (Index_t plane=0; plane<edgeElems[2]; ++plane) {
+      for (Index_t row=0; row<edgeElems[1]; ++row) {
+         for (Index_t col=0; col<edgeElems[0]; ++col) {
+            Int_t p = FacePart(col, row, plane, edgeElems, minFace, maxFace) ;
+            Int_t s = p*8 + (col & 1) + 2*(row & 1) + 4*(plane & 1) ;
+            if (m_partElemList) {
+               m_partElemList[elemPart[p]++] = zidx ;
+            }
+            m_colorElemList[colorElemCount[s]++] = zidx ;
+            ++zidx ;
+         }
+      }
+   }
+
+   if (m_partNodeList) {
+      Index_t nidx = 0 ;
+      for (Index_t plane=0; plane<edgeNodes[2]; ++plane) {
+         for (Index_t row=0; row<edgeNodes[1]; ++row) {
+            for (Index_t col=0; col<edgeNodes[0]; ++col) {
+               Int_t p = FacePart(col, row, plane, edgeNodes, minFace, maxFace) ;
+               m_partNodeList[nodePart[p]++] = nidx ;
+               ++nidx ;
+            }
+         }
+      }
+   }
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 void
 Domain::SetupThreadSupportStructures()
@@ -278,47 +508,64 @@ Domain::SetupThreadSupportStructures()
 #endif
 
   if (numthreads > 1) {
-    // set up node-centered indexing of elements 
+    // set up node-centered indexing of elements, part by part: the
+    // corners of the elements of a part at each node they touch
     Index_t *nodeElemCount = new Index_t[numNode()] ;
+    Index_t *nodeEntry = new Index_t[numNode()] ;
 
-    for (Index_t i=0; i<numNode(); ++i) {
-      nodeElemCount[i] = 0 ;
-    }
-
-    for (Index_t i=0; i<numElem(); ++i) {
-      Index_t *nl = nodelist(i) ;
-      for (Index_t j=0; j < 8; ++j) {
-	++(nodeElemCount[nl[j]] );
-      }
+    // at most one entry per node and part
+    m_nodeElemStart = new Index_t[numParts()*numNode()+1] ;
+    m_nodeElemCornerList = new Index_t[numElem()*8] ;
+    if (numParts() > 1) {
+      m_cornerNodeList = new Index_t[numParts()*numNode()] ;
     }
 
-    m_nodeElemStart = new Index_t[numNode()+1] ;
-
     m_nodeElemStart[0] = 0;
+    m_cornerNodeStart[0] = 0 ;
 
-    for (Index_t i=1; i <= numNode(); ++i) {
-      m_nodeElemStart[i] =
-	m_nodeElemStart[i-1] + nodeElemCount[i-1] ;
-    }
-       
-    m_nodeElemCornerList = new Index_t[m_nodeElemStart[numNode()]];
+    Index_t entry = 0 ;
+    for (Int_t p=0; p < numParts(); ++p) {
+      Index_t *elemList = partElemList(p) ;
 
-    for (Index_t i=0; i < numNode(); ++i) {
-      nodeElemCount[i] = 0;
-    }
+      for (Index_t i=0; i<numNode(); ++i) {
+        nodeElemCount[i] = 0 ;
+      }
+      for (Index_t e=0; e<partElemSize(p); ++e) {
+        Index_t *nl = nodelist(elemList ? elemList[e] : e) ;
+        for (Index_t j=0; j < 8; ++j) {
+          ++(nodeElemCount[nl[j]] );
+        }
+      }
 
-    for (Index_t i=0; i < numElem(); ++i) {
-      Index_t *nl = nodelist(i) ;
-      for (Index_t j=0; j < 8; ++j) {
-	Index_t m = nl[j];
-	Index_t k = i*8 + j ;
-	Index_t offset = m_nodeElemStart[m] + nodeElemCount[m] ;
-	m_nodeElemCornerList[offset] = k;
-	++(nodeElemCount[m]) ;
+      // one entry per node touched, then the corners of the part's
+      // elements in element order
+      for (Index_t i=0; i<numNode(); ++i) {
+        if ((nodeElemCount[i] > 0) || (numParts() == 1)) {
+          if (m_cornerNodeList) {
+            m_cornerNodeList[entry] = i ;
+          }
+          m_nodeElemStart[entry+1] = m_nodeElemStart[entry] + nodeElemCount[i] ;
+          nodeEntry[i] = entry ;
+          ++entry ;
+        }
+        nodeElemCount[i] = 0 ;
+      }
+      m_cornerNodeStart[p+1] = entry ;
+
+      for (Index_t e=0; e<partElemSize(p); ++e) {
+        Index_t elem = elemList ? elemList[e] : e ;
+        Index_t *nl = nodelist(elem) ;
+        for (Index_t j=0; j < 8; ++j) {
+          Index_t m = nl[j];
+          Index_t k = elem*8 + j ;
+          Index_t offset = m_nodeElemStart[nodeEntry[m]] + nodeElemCount[m] ;
+          m_nodeElemCornerList[offset] = k;
+          ++(nodeElemCount[m]) ;
+        }
       }
     }
 
-    Index_t clSize = m_nodeElemStart[numNode()] ;
+    Index_t clSize = m_nodeElemStart[entry] ;
     for (Index_t i=0; i < clSize; ++i) {
       Index_t clv = m_nodeElemCornerList[i] ;
       if ((clv < 0) || (clv > numElem()*8)) {
@@ -332,6 +579,7 @@ Domain::SetupThreadSupportStructures()
       }
     }
 
+    delete [] nodeEntry ;
     delete [] nodeElemCount ;
   }
 }
@@ -339,7 +587,7 @@ Domain::SetupThreadSupportStructures()
 
 ////////////////////////////////////////////////////////////////////////////////
 void
-Domain::SetupCommBuffers(Int_t edgeNodes)
+Domain::SetupCommBuffers()
 {
   // allocate a buffer large enough for nodal ghost data 
   Index_t maxEdgeSize = MAX(this->sizeX(), MAX(this->sizeY(), this->sizeZ()))+1 ;
@@ -348,11 +596,11 @@ Domain::SetupCommBuffers(Int_t edgeNodes)
 
   // assume communication to 6 neighbors by default 
   m_rowMin = (m_rowLoc == 0)        ? 0 : 1;
-  m_rowMax = (m_rowLoc == m_tp-1)     ? 0 : 1;
+  m_rowMax = (m_rowLoc == m_rowDoms-1)     ? 0 : 1;
   m_colMin = (m_colLoc == 0)        ? 0 : 1;
-  m_colMax = (m_colLoc == m_tp-1)     ? 0 : 1;
+  m_colMax = (m_colLoc == m_colDoms-1)     ? 0 : 1;
   m_planeMin = (m_planeLoc == 0)    ? 0 : 1;
-  m_planeMax = (m_planeLoc == m_tp-1) ? 0 : 1;
+  m_planeMax = (m_planeLoc == m_planeDoms-1) ? 0 : 1;
 
 #if USE_MPI   
   // account for face communication 
@@ -388,11 +636,11 @@ Domain::SetupCommBuffers(Int_t edgeNodes)
 
   // Boundary nodesets
   if (m_colLoc == 0)
-    m_symmX.resize(edgeNodes*edgeNodes);
+    m_symmX.resize((m_sizeY+1)*(m_sizeZ+1));
   if (m_rowLoc == 0)
-    m_symmY.resize(edgeNodes*edgeNodes);
+    m_symmY.resize((m_sizeX+1)*(m_sizeZ+1));
   if (m_planeLoc == 0)
-    m_symmZ.resize(edgeNodes*edgeNodes);
+    m_symmZ.resize((m_sizeX+1)*(m_sizeY+1));
 }
 
 
@@ -511,23 +759,34 @@ Domain::CreateRegionIndexSets(Int_t nr, Int_t balance)
 
 /////////////////////////////////////////////////////////////
 void 
-Domain::SetupSymmetryPlanes(Int_t edgeNodes)
+Domain::SetupSymmetryPlanes()
 {
-  Index_t nidx = 0 ;
-  for (Index_t i=0; i<edgeNodes; ++i) {
-    Index_t planeInc = i*edgeNodes*edgeNodes ;
-    Index_t rowInc   = i*edgeNodes ;
-    for (Index_t j=0; j<edgeNodes; ++j) {
-      if (m_planeLoc == 0) {
-	m_symmZ[nidx] = rowInc   + j ;
+  Index_t nodesX = m_sizeX+1 ;
+  Index_t nodesY = m_sizeY+1 ;
+  Index_t nodesZ = m_sizeZ+1 ;
+  Index_t nidx ;
+  if (m_planeLoc == 0) {
+    nidx = 0 ;
+    for (Index_t i=0; i<nodesY; ++i) {
+      for (Index_t j=0; j<nodesX; ++j) {
+	m_symmZ[nidx++] = i*nodesX + j ;
       }
-      if (m_rowLoc == 0) {
-	m_symmY[nidx] = planeInc + j ;
+    }
+  }
+  if (m_rowLoc == 0) {
+    nidx = 0 ;
+    for (Index_t i=0; i<nodesZ; ++i) {
+      for (Index_t j=0; j<nodesX; ++j) {
+	m_symmY[nidx++] = i*nodesX*nodesY + j ;
       }
-      if (m_colLoc == 0) {
-	m_symmX[nidx] = planeInc + j*edgeNodes ;
+    }
+  }
+  if (m_colLoc == 0) {
+    nidx = 0 ;
+    for (Index_t i=0; i<nodesZ; ++i) {
+      for (Index_t j=0; j<nodesY; ++j) {
+	m_symmX[nidx++] = i*nodesX*nodesY + j*nodesX ;
       }
-      ++nidx ;
     }
   }
 }
@@ -536,8 +795,11 @@ Domain::SetupSymmetryPlanes(Int_t edgeNodes)
 
 /////////////////////////////////////////////////////////////
 void
-Domain::SetupElementConnectivities(Int_t edgeElems)
+Domain::SetupElementConnectivities()
 {
+   Index_t rowElems = sizeX() ;
+   Index_t planeElems = sizeX()*sizeY() ;
+
    lxim(0) = 0 ;
    for (Index_t i=1; i<numElem(); ++i) {
       lxim(i)   = i-1 ;
@@ -545,28 +807,28 @@ Domain::SetupElementConnectivities(Int_t edgeElems)
    }
    lxip(numElem()-1) = numElem()-1 ;
 
-   for (Index_t i=0; i<edgeElems; ++i) {
+   for (Index_t i=0; i<rowElems; ++i) {
       letam(i) = i ; 
-      letap(numElem()-edgeElems+i) = numElem()-edgeElems+i ;
+      letap(numElem()-rowElems+i) = numElem()-rowElems+i ;
    }
-   for (Index_t i=edgeElems; i<numElem(); ++i) {
-      letam(i) = i-edgeElems ;
-      letap(i-edgeElems) = i ;
+   for (Index_t i=rowElems; i<numElem(); ++i) {
+      letam(i) = i-rowElems ;
+      letap(i-rowElems) = i ;
    }
 
-   for (Index_t i=0; i<edgeElems*edgeElems; ++i) {
+   for (Index_t i=0; i<planeElems; ++i) {
       lzetam(i) = i ;
-      lzetap(numElem()-edgeElems*edgeElems+i) = numElem()-edgeElems*edgeElems+i ;
+      lzetap(numElem()-planeElems+i) = numElem()-planeElems+i ;
    }
-   for (Index_t i=edgeElems*edgeElems; i<numElem(); ++i) {
-      lzetam(i) = i - edgeElems*edgeElems ;
-      lzetap(i-edgeElems*edgeElems) = i ;
+   for (Index_t i=planeElems; i<numElem(); ++i) {
+      lzetam(i) = i - planeElems ;
+      lzetap(i-planeElems) = i ;
    }
 }
 
 /////////////////////////////////////////////////////////////
 void
-Domain::SetupBoundaryConditions(Int_t edgeElems) 
+Domain::SetupBoundaryConditions() 
 {
   Index_t ghostIdx[6] ;  // offsets to ghost locations
 
@@ -609,11 +871,16 @@ Domain::SetupBoundaryConditions(Int_t edgeElems)
     ghostIdx[5] = pidx ;
   }
 
-  // symmetry plane or free surface BCs 
-  for (Index_t i=0; i<edgeElems; ++i) {
-    Index_t planeInc = i*edgeElems*edgeElems ;
-    Index_t rowInc   = i*edgeElems ;
-    for (Index_t j=0; j<edgeElems; ++j) {
+  Index_t rowElems = sizeX() ;
+  Index_t planeElems = sizeX()*sizeY() ;
+
+  // symmetry plane or free surface BCs, the ghosts of each face are
+  // in the order of its elements
+
+  // faces of constant plane
+  for (Index_t i=0; i<sizeY(); ++i) {
+    Index_t rowInc   = i*rowElems ;
+    for (Index_t j=0; j<sizeX(); ++j) {
       if (m_planeLoc == 0) {
 	elemBC(rowInc+j) |= ZETA_M_SYMM ;
       }
@@ -622,51 +889,65 @@ Domain::SetupBoundaryConditions(Int_t edgeElems)
 	lzetam(rowInc+j) = ghostIdx[0] + rowInc + j ;
       }
 
-      if (m_planeLoc == m_tp-1) {
-	elemBC(rowInc+j+numElem()-edgeElems*edgeElems) |=
+      if (m_planeLoc == m_planeDoms-1) {
+	elemBC(rowInc+j+numElem()-planeElems) |=
 	  ZETA_P_FREE;
       }
       else {
-	elemBC(rowInc+j+numElem()-edgeElems*edgeElems) |=
+	elemBC(rowInc+j+numElem()-planeElems) |=
 	  ZETA_P_COMM ;
-	lzetap(rowInc+j+numElem()-edgeElems*edgeElems) =
+	lzetap(rowInc+j+numElem()-planeElems) =
 	  ghostIdx[1] + rowInc + j ;
       }
+    }
+  }
 
+  // faces of constant row
+  for (Index_t i=0; i<sizeZ(); ++i) {
+    Index_t planeInc = i*planeElems ;
+    Index_t faceInc  = i*rowElems ;
+    for (Index_t j=0; j<sizeX(); ++j) {
       if (m_rowLoc == 0) {
 	elemBC(planeInc+j) |= ETA_M_SYMM ;
       }
       else {
 	elemBC(planeInc+j) |= ETA_M_COMM ;
-	letam(planeInc+j) = ghostIdx[2] + rowInc + j ;
+	letam(planeInc+j) = ghostIdx[2] + faceInc + j ;
       }
 
-      if (m_rowLoc == m_tp-1) {
-	elemBC(planeInc+j+edgeElems*edgeElems-edgeElems) |= 
+      if (m_rowLoc == m_rowDoms-1) {
+	elemBC(planeInc+j+planeElems-rowElems) |= 
 	  ETA_P_FREE ;
       }
       else {
-	elemBC(planeInc+j+edgeElems*edgeElems-edgeElems) |= 
+	elemBC(planeInc+j+planeElems-rowElems) |= 
 	  ETA_P_COMM ;
-	letap(planeInc+j+edgeElems*edgeElems-edgeElems) =
-	  ghostIdx[3] +  rowInc + j ;
+	letap(planeInc+j+planeElems-rowElems) =
+	  ghostIdx[3] + faceInc + j ;
       }
+    }
+  }
 
+  // faces of constant column
+  for (Index_t i=0; i<sizeZ(); ++i) {
+    Index_t planeInc = i*planeElems ;
+    Index_t faceInc  = i*sizeY() ;
+    for (Index_t j=0; j<sizeY(); ++j) {
       if (m_colLoc == 0) {
-	elemBC(planeInc+j*edgeElems) |= XI_M_SYMM ;
+	elemBC(planeInc+j*rowElems) |= XI_M_SYMM ;
       }
       else {
-	elemBC(planeInc+j*edgeElems) |= XI_M_COMM ;
-	lxim(planeInc+j*edgeElems) = ghostIdx[4] + rowInc + j ;
+	elemBC(planeInc+j*rowElems) |= XI_M_COMM ;
+	lxim(planeInc+j*rowElems) = ghostIdx[4] + faceInc + j ;
       }
 
-      if (m_colLoc == m_tp-1) {
-	elemBC(planeInc+j*edgeElems+edgeElems-1) |= XI_P_FREE ;
+      if (m_colLoc == m_colDoms-1) {
+	elemBC(planeInc+j*rowElems+rowElems-1) |= XI_P_FREE ;
       }
       else {
-	elemBC(planeInc+j*edgeElems+edgeElems-1) |= XI_P_COMM ;
-	lxip(planeInc+j*edgeElems+edgeElems-1) =
-	  ghostIdx[5] + rowInc + j ;
+	elemBC(planeInc+j*rowElems+rowElems-1) |= XI_P_COMM ;
+	lxip(planeInc+j*rowElems+rowElems-1) =
+	  ghostIdx[5] + faceInc + j ;
       }
     }
   }
@@ -674,22 +955,12 @@ Domain::SetupBoundaryConditions(Int_t edgeElems)
 
 ///////////////////////////////////////////////////////////////////////////
 void InitMeshDecomp(Int_t numRanks, Int_t myRank,
-                    Int_t *col, Int_t *row, Int_t *plane, Int_t *side)
+                    Int_t *col, Int_t *row, Int_t *plane,
+                    Int_t *colDoms, Int_t *rowDoms, Int_t *planeDoms)
 {
-   Int_t testProcs;
    Int_t dx, dy, dz;
    Int_t myDom;
    
-   // Assume cube processor layout for now 
-   testProcs = Int_t(cbrt(Real_t(numRanks))+0.5) ;
-   if (testProcs*testProcs*testProcs != numRanks) {
-      printf("Num processors must be a cube of an integer (1, 8, 27, ...)\n") ;
-#if USE_MPI      
-      MPI_Abort(MPI_COMM_WORLD, -1) ;
-#else
-      exit(-1);
-#endif
-   }
    if (sizeof(Real_t) != 4 && sizeof(Real_t) != 8) {
       printf("MPI operations only support float and double right now...\n");
 #if USE_MPI      
@@ -707,33 +978,36 @@ void InitMeshDecomp(Int_t numRanks, Int_t myRank,
 #endif
    }
 
-   dx = testProcs ;
-   dy = testProcs ;
-   dz = testProcs ;
-
-   // temporary test
-   if (dx*dy*dz != numRanks) {
-      printf("error -- must have as many domains as procs\n") ;
-#if USE_MPI      
-      MPI_Abort(MPI_COMM_WORLD, -1) ;
-#else
-      exit(-1);
-#endif
-   }
-   Int_t remainder = dx*dy*dz % numRanks ;
-   if (myRank < remainder) {
-      myDom = myRank*( 1+ (dx*dy*dz / numRanks)) ;
-   }
-   else {
-      myDom = remainder*( 1+ (dx*dy*dz / numRanks)) +
-         (myRank - remainder)*(dx*dy*dz/numRanks) ;
+   // The dx*dy*dz = numRanks processor layout with the least surface
+   // between the domains (dx+dy+dz), dx >= dy >= dz: the cube for a
+   // cube of ranks, 4x4x3 for 48, 6x4x4 for 96.  A rank count without a
+   // balanced factorization gets lopsided domains, down to numRanks x 1 x 1
+   // slabs for a prime, which main warns about
+   dx = numRanks ;
+   dy = 1 ;
+   dz = 1 ;
+   for (Int_t pz=1; pz*pz*pz <= numRanks; ++pz) {
+      if (numRanks % pz != 0) {
+         continue ;
+      }
+      for (Int_t py=pz; py*py <= numRanks/pz; ++py) {
+         Int_t px = numRanks/pz/py ;
+         if ((numRanks/pz) % py == 0 && px+py+pz < dx+dy+dz) {
+            dx = px ;
+            dy = py ;
+            dz = pz ;
+         }
+      }
    }
 
+   myDom = myRank ;
+
    *col = myDom % dx ;
    *row = (myDom / dx) % dy ;
    *plane = myDom / (dx*dy) ;
-   *side = testProcs;
+   *colDoms = dx ;
+   *rowDoms = dy ;
+   *planeDoms = dz ;
 
    return;
 }
-
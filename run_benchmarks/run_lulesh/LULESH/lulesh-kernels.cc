@@ -0,0 +1,260 @@
+/*
+ * Microbenchmark of the element kernels of lulesh_kernels.h, one element
+ * at a time and by batches of 4 and 8 elements.
+ *
+ *    lulesh2.0-kernels [-n elements] [-r repetitions]
+ *
+ * The elements are perturbed unit hexahedra, stored as lulesh.cc sees
+ * them: 8 nodes per element for the scalar kernels, transposed by
+ * batches for the batched ones (the elements left over by the last
+ * batch go through the scalar kernel).  For each kernel and width, the
+ * best of the repetitions is printed as elements per second, with the
+ * largest difference to the scalar results, relative to the largest
+ * output of the element:
+ *
+ *    kernel,width,elements,elements_per_s,max_rel_diff
+ *
+ * Width 1 is the scalar kernel.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <unistd.h>
+
+#include "lulesh.h"
+#include "lulesh_kernels.h"
+
+namespace {
+
+/* Inputs of one element: coordinates, velocities, hourglass modes and
+   hourglass coefficient */
+const Index_t X = 0, Y = 8, Z = 16 ;
+const Index_t XD = 24, YD = 32, ZD = 40 ;
+const Index_t HOURGAM = 48 ;
+const Index_t COEF = 80 ;
+const Index_t NUM_INPUTS = 81 ;
+
+/* Outputs of the largest kernel */
+const Index_t NUM_OUTPUTS = 25 ;
+
+/******************************************/
+
+struct ShapeFunctionDerivatives
+{
+   static const char *name() { return "shape_function_derivatives" ; }
+
+   template <typename T>
+   static void Run(const T *in, T *out)
+   {
+      CalcElemShapeFunctionDerivatives(&in[X], &in[Y], &in[Z],
+                                       reinterpret_cast<T (*)[8]>(out),
+                                       &out[24]) ;
+   }
+} ;
+
+struct NodeNormals
+{
+   static const char *name() { return "node_normals" ; }
+
+   template <typename T>
+   static void Run(const T *in, T *out)
+   {
+      CalcElemNodeNormals(&out[0], &out[8], &out[16],
+                          &in[X], &in[Y], &in[Z]) ;
+   }
+} ;
+
+struct VolumeDerivative
+{
+   static const char *name() { return "volume_derivative" ; }
+
+   template <typename T>
+   static void Run(const T *in, T *out)
+   {
+      CalcElemVolumeDerivative(&out[0], &out[8], &out[16],
+                               &in[X], &in[Y], &in[Z]) ;
+   }
+} ;
+
+struct FBHourglassForce
+{
+   static const char *name() { return "fb_hourglass_force" ; }
+
+   template <typename T>
+   static void Run(const T *in, T *out)
+   {
+      CalcElemFBHourglassForce(&in[XD], &in[YD], &in[ZD],
+                               reinterpret_cast<const T (*)[4]>(&in[HOURGAM]),
+                               in[COEF], &out[0], &out[8], &out[16]) ;
+   }
+} ;
+
+/******************************************/
+
+Real_t Random(Real_t low, Real_t high)
+{
+   return low + (high - low) * (Real_t(rand()) / Real_t(RAND_MAX)) ;
+}
+
+void MakeElements(Index_t numElem, std::vector<Real_t>& in)
+{
+   static const Real_t corner[8][3] = {
+      {0, 0, 0}, {1, 0, 0}, {1, 1, 0}, {0, 1, 0},
+      {0, 0, 1}, {1, 0, 1}, {1, 1, 1}, {0, 1, 1}
+   } ;
+
+   srand(12345) ;
+   in.resize(size_t(numElem) * NUM_INPUTS) ;
+   for (Index_t e = 0 ; e < numElem ; ++e) {
+      Real_t *elem = &in[size_t(e) * NUM_INPUTS] ;
+      for (Index_t n = 0 ; n < 8 ; ++n) {
+         elem[X + n] = corner[n][0] + Random(-0.1, 0.1) ;
+         elem[Y + n] = corner[n][1] + Random(-0.1, 0.1) ;
+         elem[Z + n] = corner[n][2] + Random(-0.1, 0.1) ;
+         elem[XD + n] = Random(-1.0, 1.0) ;
+         elem[YD + n] = Random(-1.0, 1.0) ;
+         elem[ZD + n] = Random(-1.0, 1.0) ;
+      }
+      for (Index_t i = 0 ; i < 32 ; ++i) {
+         elem[HOURGAM + i] = Random(-1.0, 1.0) ;
+      }
+      elem[COEF] = Random(-1.0, 0.0) ;
+   }
+}
+
+/******************************************/
+
+template <typename Fn>
+double BestSeconds(Index_t reps, Fn fn)
+{
+   double best = 0.0 ;
+   for (Index_t r = 0 ; r < reps ; ++r) {
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now() ;
+      fn() ;
+      double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() ;
+      if (r == 0 || seconds < best) {
+         best = seconds ;
+      }
+   }
+   return best ;
+}
+
+void Report(const char *kernel, Index_t width, Index_t numElem,
+            double seconds, double maxDiff)
+{
+   printf("%s,%d,%d,%.6e,%.3e\n", kernel, int(width), int(numElem),
+          seconds > 0 ? numElem / seconds : 0.0, maxDiff) ;
+}
+
+/******************************************/
+
+template <typename Kernel>
+void BenchScalar(const std::vector<Real_t>& in, Index_t numElem, Index_t reps,
+                 std::vector<Real_t>& out)
+{
+   out.assign(size_t(numElem) * NUM_OUTPUTS, Real_t(0.0)) ;
+   double seconds = BestSeconds(reps, [&]() {
+      for (Index_t e = 0 ; e < numElem ; ++e) {
+         Kernel::Run(&in[size_t(e) * NUM_INPUTS], &out[size_t(e) * NUM_OUTPUTS]) ;
+      }
+   }) ;
+   Report(Kernel::name(), 1, numElem, seconds, 0.0) ;
+}
+
+template <typename Kernel, Index_t W>
+void BenchBatched(const std::vector<Real_t>& in, Index_t numElem, Index_t reps,
+                  const std::vector<Real_t>& reference)
+{
+   typedef RealBatch<W> Batch ;
+   Index_t numBatch = numElem / W ;
+   Index_t tail = numBatch * W ;
+
+   std::vector<Batch> batchIn(size_t(numBatch) * NUM_INPUTS) ;
+   for (Index_t b = 0 ; b < numBatch ; ++b) {
+      for (Index_t l = 0 ; l < W ; ++l) {
+         const Real_t *elem = &in[size_t(b * W + l) * NUM_INPUTS] ;
+         for (Index_t i = 0 ; i < NUM_INPUTS ; ++i) {
+            batchIn[size_t(b) * NUM_INPUTS + i].v[l] = elem[i] ;
+         }
+      }
+   }
+   std::vector<Batch> batchOut(size_t(numBatch) * NUM_OUTPUTS, Batch(Real_t(0.0))) ;
+   std::vector<Real_t> tailOut(size_t(numElem - tail) * NUM_OUTPUTS, Real_t(0.0)) ;
+
+   double seconds = BestSeconds(reps, [&]() {
+      for (Index_t b = 0 ; b < numBatch ; ++b) {
+         Kernel::Run(&batchIn[size_t(b) * NUM_INPUTS], &batchOut[size_t(b) * NUM_OUTPUTS]) ;
+      }
+      for (Index_t e = tail ; e < numElem ; ++e) {
+         Kernel::Run(&in[size_t(e) * NUM_INPUTS], &tailOut[size_t(e - tail) * NUM_OUTPUTS]) ;
+      }
+   }) ;
+
+   // Differences relative to the largest output of the element, the
+   // outputs that cancel out to almost 0 would dominate otherwise
+   double maxDiff = 0.0 ;
+   for (Index_t e = 0 ; e < numElem ; ++e) {
+      const Real_t *expected = &reference[size_t(e) * NUM_OUTPUTS] ;
+      Real_t scale = Real_t(1.0e-300) ;
+      for (Index_t o = 0 ; o < NUM_OUTPUTS ; ++o) {
+         scale = std::max(scale, FABS(expected[o])) ;
+      }
+      for (Index_t o = 0 ; o < NUM_OUTPUTS ; ++o) {
+         Real_t value = e < tail
+            ? batchOut[size_t(e / W) * NUM_OUTPUTS + o].v[e % W]
+            : tailOut[size_t(e - tail) * NUM_OUTPUTS + o] ;
+         maxDiff = std::max(maxDiff, double(FABS(value - expected[o]) / scale)) ;
+      }
+   }
+   Report(Kernel::name(), W, numElem, seconds, maxDiff) ;
+}
+
+template <typename Kernel>
+void Bench(const std::vector<Real_t>& in, Index_t numElem, Index_t reps)
+{
+   std::vector<Real_t> reference ;
+   BenchScalar<Kernel>(in, numElem, reps, reference) ;
+   BenchBatched<Kernel, 4>(in, numElem, reps, reference) ;
+   BenchBatched<Kernel, 8>(in, numElem, reps, reference) ;
+}
+
+void Usage(const char *prog)
+{
+   fprintf(stderr, "Usage: %s [-n elements] [-r repetitions]\n", prog) ;
+   exit(1) ;
+}
+
+} // namespace
+
+/******************************************/
+
+int main(int argc, char *argv[])
+{
+   Index_t numElem = 100003 ;
+   Index_t reps = 20 ;
+   int opt ;
+   while ((opt = getopt(argc, argv, "n:r:h")) != -1) {
+      switch (opt) {
+         case 'n': numElem = atoi(optarg) ; break ;
+         case 'r': reps = atoi(optarg) ; break ;
+         default: Usage(argv[0]) ;
+      }
+   }
+   if (optind != argc || numElem < 1 || reps < 1) {
+      Usage(argv[0]) ;
+   }
+
+   std::vector<Real_t> in ;
+   MakeElements(numElem, in) ;
+
+   printf("kernel,width,elements,elements_per_s,max_rel_diff\n") ;
+   Bench<ShapeFunctionDerivatives>(in, numElem, reps) ;
+   Bench<NodeNormals>(in, numElem, reps) ;
+   Bench<VolumeDerivative>(in, numElem, reps) ;
+   Bench<FBHourglassForce>(in, numElem, reps) ;
+   return 0 ;
+}
@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 #if USE_MPI
 #include <mpi.h>
 #endif
@@ -37,11 +38,15 @@ static void PrintCommandLineOptions(char *execname, int myRank)
       printf(" -q              : quiet mode - suppress all stdout\n");
       printf(" -i <iterations> : number of cycles to run\n");
       printf(" -s <size>       : length of cube mesh along side\n");
+      printf(" -S <size>       : length of the whole mesh along side (def: size*cbrt(np))\n");
+      printf("                   any np works, a prime np splits the mesh in np slabs\n");
       printf(" -r <numregions> : Number of distinct regions (def: 11)\n");
       printf(" -b <balance>    : Load balance between regions of a domain (def: 1)\n");
       printf(" -c <cost>       : Extra cost of more expensive regions (def: 1)\n");
       printf(" -f <numfiles>   : Number of files to split viz dump into (def: (np+10)/9)\n");
       printf(" -p              : Print out progress\n");
+      printf(" -g              : Scatter element forces color by color (8-color mesh)\n");
+      printf(" -n              : Halo exchanges with MPI neighborhood collectives\n");
       printf(" -v              : Output viz file (requires compiling with -DVIZ_MESH\n");
       printf(" -h              : This message\n");
       printf("\n\n");
@@ -90,6 +95,17 @@ void ParseCommandLineOptions(int argc, char *argv[],
             }
             i+=2;
          }
+         /* -S <size, sidelength of the whole mesh> */
+         else if(strcmp(argv[i], "-S") == 0) {
+            if (i+1 >= argc) {
+               ParseError("Missing integer argument to -S\n", myRank);
+            }
+            ok = StrToInt(argv[i+1], &(opts->meshSize));
+            if(!ok) {
+               ParseError("Parse Error on option -S integer value required after argument\n", myRank);
+            }
+            i+=2;
+         }
 	 /* -r <numregions> */
          else if (strcmp(argv[i], "-r") == 0) {
             if (i+1 >= argc) {
@@ -117,6 +133,16 @@ void ParseCommandLineOptions(int argc, char *argv[],
             opts->showProg = 1;
             i++;
          }
+         /* -g */
+         else if (strcmp(argv[i], "-g") == 0) {
+            opts->colorScatter = 1;
+            i++;
+         }
+         /* -n */
+         else if (strcmp(argv[i], "-n") == 0) {
+            opts->neighborComm = 1;
+            i++;
+         }
          /* -q */
          else if (strcmp(argv[i], "-q") == 0) {
             opts->quiet = 1;
@@ -174,20 +200,22 @@ void ParseCommandLineOptions(int argc, char *argv[],
 
 void VerifyAndWriteFinalOutput(Real_t elapsed_time,
                                Domain& locDom,
-                               Int_t nx,
+                               Int_t meshSize,
                                Int_t numRanks)
 {
    // GrindTime1 only takes a single domain into account, and is thus a good way to measure
    // processor speed indepdendent of MPI parallelism.
    // GrindTime2 takes into account speedups from MPI parallelism.
    // Cast to 64-bit integer to avoid overflows.
-   Int8_t nx8 = nx;
-   Real_t grindTime1 = ((elapsed_time*1e6)/locDom.cycle())/(nx8*nx8*nx8);
-   Real_t grindTime2 = ((elapsed_time*1e6)/locDom.cycle())/(nx8*nx8*nx8*numRanks);
+   Int8_t mesh8 = meshSize;
+   Real_t grindTime1 = ((elapsed_time*1e6)/locDom.cycle())/(Int8_t(locDom.numElem()));
+   Real_t grindTime2 = ((elapsed_time*1e6)/locDom.cycle())/(mesh8*mesh8*mesh8);
 
    Index_t ElemId = 0;
    std::cout << "Run completed:\n";
-   std::cout << "   Problem size        =  " << nx       << "\n";
+   std::cout << "   Problem size        =  " << meshSize << "\n";
+   std::cout << "   Domain size         =  " << locDom.sizeX() << "x" << locDom.sizeY()
+             << "x" << locDom.sizeZ() << "\n";
    std::cout << "   MPI tasks           =  " << numRanks << "\n";
    std::cout << "   Iteration count     =  " << locDom.cycle() << "\n";
    std::cout << "   Final Origin Energy =  ";
@@ -198,14 +226,18 @@ void VerifyAndWriteFinalOutput(Real_t elapsed_time,
    Real_t TotalAbsDiff = Real_t(0.0);
    Real_t   MaxRelDiff = Real_t(0.0);
 
-   for (Index_t j=0; j<nx; ++j) {
-      for (Index_t k=j+1; k<nx; ++k) {
-         Real_t AbsDiff = FABS(locDom.e(j*nx+k)-locDom.e(k*nx+j));
+   // The x/y symmetry of the mesh, over the square corner of plane 0
+   // that rank 0 holds
+   Index_t rowElems = locDom.sizeX();
+   Index_t side = std::min(locDom.sizeX(), locDom.sizeY());
+   for (Index_t j=0; j<side; ++j) {
+      for (Index_t k=j+1; k<side; ++k) {
+         Real_t AbsDiff = FABS(locDom.e(j*rowElems+k)-locDom.e(k*rowElems+j));
          TotalAbsDiff  += AbsDiff;
 
          if (MaxAbsDiff <AbsDiff) MaxAbsDiff = AbsDiff;
 
-         Real_t RelDiff = AbsDiff / locDom.e(k*nx+j);
+         Real_t RelDiff = AbsDiff / locDom.e(k*rowElems+j);
 
          if (MaxRelDiff <RelDiff)  MaxRelDiff = RelDiff;
       }
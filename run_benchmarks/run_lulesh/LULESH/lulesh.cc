@@ -23,6 +23,8 @@ DIFFERENCES BETWEEN THIS VERSION (2.x) AND EARLIER VERSIONS:
  -q              : quiet mode - suppress stdout
  -i <iterations> : number of cycles to run
  -s <size>       : length of cube mesh along side
+ -S <size>       : length of the whole mesh along side (def: size*cbrt(np))
+                   any np works, a prime np splits the mesh in np slabs
  -r <numregions> : Number of distinct regions (def: 11)
  -b <balance>    : Load balance between regions of a domain (def: 1)
  -c <cost>       : Extra cost of more expensive regions (def: 1)
@@ -160,6 +162,7 @@ Additional BSD Notice
 #endif
 
 #include "lulesh.h"
+#include "lulesh_kernels.h"
 
 /* Work Routines */
 
@@ -270,231 +273,90 @@ void CollectDomainNodesToElemNodes(Domain &domain,
 
 /******************************************/
 
-static inline
-void InitStressTermsForElems(Domain &domain,
-                             Real_t *sigxx, Real_t *sigyy, Real_t *sigzz,
-                             Index_t numElem)
-{
-   //
-   // pull in the stresses appropriate to the hydro integration
-   //
-
-#pragma omp parallel for firstprivate(numElem)
-   for (Index_t i = 0 ; i < numElem ; ++i){
-      sigxx[i] = sigyy[i] = sigzz[i] =  - domain.p(i) - domain.q(i) ;
-   }
-}
+#if LULESH_BATCHED
 
-/******************************************/
+typedef RealBatch<LULESH_BATCH_WIDTH> ElemBatch ;
 
+/* Gathers the nodes of elements elems[0] to elems[width - 1], one
+   element per lane */
 static inline
-void CalcElemShapeFunctionDerivatives( Real_t const x[],
-                                       Real_t const y[],
-                                       Real_t const z[],
-                                       Real_t b[][8],
-                                       Real_t* const volume )
+void CollectDomainNodesToElemNodes(Domain &domain,
+                                   const Index_t elems[],
+                                   ElemBatch elemX[8],
+                                   ElemBatch elemY[8],
+                                   ElemBatch elemZ[8])
 {
-  const Real_t x0 = x[0] ;   const Real_t x1 = x[1] ;
-  const Real_t x2 = x[2] ;   const Real_t x3 = x[3] ;
-  const Real_t x4 = x[4] ;   const Real_t x5 = x[5] ;
-  const Real_t x6 = x[6] ;   const Real_t x7 = x[7] ;
-
-  const Real_t y0 = y[0] ;   const Real_t y1 = y[1] ;
-  const Real_t y2 = y[2] ;   const Real_t y3 = y[3] ;
-  const Real_t y4 = y[4] ;   const Real_t y5 = y[5] ;
-  const Real_t y6 = y[6] ;   const Real_t y7 = y[7] ;
-
-  const Real_t z0 = z[0] ;   const Real_t z1 = z[1] ;
-  const Real_t z2 = z[2] ;   const Real_t z3 = z[3] ;
-  const Real_t z4 = z[4] ;   const Real_t z5 = z[5] ;
-  const Real_t z6 = z[6] ;   const Real_t z7 = z[7] ;
-
-  Real_t fjxxi, fjxet, fjxze;
-  Real_t fjyxi, fjyet, fjyze;
-  Real_t fjzxi, fjzet, fjzze;
-  Real_t cjxxi, cjxet, cjxze;
-  Real_t cjyxi, cjyet, cjyze;
-  Real_t cjzxi, cjzet, cjzze;
-
-  fjxxi = Real_t(.125) * ( (x6-x0) + (x5-x3) - (x7-x1) - (x4-x2) );
-  fjxet = Real_t(.125) * ( (x6-x0) - (x5-x3) + (x7-x1) - (x4-x2) );
-  fjxze = Real_t(.125) * ( (x6-x0) + (x5-x3) + (x7-x1) + (x4-x2) );
-
-  fjyxi = Real_t(.125) * ( (y6-y0) + (y5-y3) - (y7-y1) - (y4-y2) );
-  fjyet = Real_t(.125) * ( (y6-y0) - (y5-y3) + (y7-y1) - (y4-y2) );
-  fjyze = Real_t(.125) * ( (y6-y0) + (y5-y3) + (y7-y1) + (y4-y2) );
-
-  fjzxi = Real_t(.125) * ( (z6-z0) + (z5-z3) - (z7-z1) - (z4-z2) );
-  fjzet = Real_t(.125) * ( (z6-z0) - (z5-z3) + (z7-z1) - (z4-z2) );
-  fjzze = Real_t(.125) * ( (z6-z0) + (z5-z3) + (z7-z1) + (z4-z2) );
-
-  /* compute cofactors */
-  cjxxi =    (fjyet * fjzze) - (fjzet * fjyze);
-  cjxet =  - (fjyxi * fjzze) + (fjzxi * fjyze);
-  cjxze =    (fjyxi * fjzet) - (fjzxi * fjyet);
-
-  cjyxi =  - (fjxet * fjzze) + (fjzet * fjxze);
-  cjyet =    (fjxxi * fjzze) - (fjzxi * fjxze);
-  cjyze =  - (fjxxi * fjzet) + (fjzxi * fjxet);
-
-  cjzxi =    (fjxet * fjyze) - (fjyet * fjxze);
-  cjzet =  - (fjxxi * fjyze) + (fjyxi * fjxze);
-  cjzze =    (fjxxi * fjyet) - (fjyxi * fjxet);
-
-  /* calculate partials :
-     this need only be done for l = 0,1,2,3   since , by symmetry ,
-     (6,7,4,5) = - (0,1,2,3) .
-  */
-  b[0][0] =   -  cjxxi  -  cjxet  -  cjxze;
-  b[0][1] =      cjxxi  -  cjxet  -  cjxze;
-  b[0][2] =      cjxxi  +  cjxet  -  cjxze;
-  b[0][3] =   -  cjxxi  +  cjxet  -  cjxze;
-  b[0][4] = -b[0][2];
-  b[0][5] = -b[0][3];
-  b[0][6] = -b[0][0];
-  b[0][7] = -b[0][1];
-
-  b[1][0] =   -  cjyxi  -  cjyet  -  cjyze;
-  b[1][1] =      cjyxi  -  cjyet  -  cjyze;
-  b[1][2] =      cjyxi  +  cjyet  -  cjyze;
-  b[1][3] =   -  cjyxi  +  cjyet  -  cjyze;
-  b[1][4] = -b[1][2];
-  b[1][5] = -b[1][3];
-  b[1][6] = -b[1][0];
-  b[1][7] = -b[1][1];
-
-  b[2][0] =   -  cjzxi  -  cjzet  -  cjzze;
-  b[2][1] =      cjzxi  -  cjzet  -  cjzze;
-  b[2][2] =      cjzxi  +  cjzet  -  cjzze;
-  b[2][3] =   -  cjzxi  +  cjzet  -  cjzze;
-  b[2][4] = -b[2][2];
-  b[2][5] = -b[2][3];
-  b[2][6] = -b[2][0];
-  b[2][7] = -b[2][1];
-
-  /* calculate jacobian determinant (volume) */
-  *volume = Real_t(8.) * ( fjxet * cjxet + fjyet * cjyet + fjzet * cjzet);
+   for (Index_t l = 0 ; l < ElemBatch::width ; ++l) {
+      const Index_t* elemToNode = domain.nodelist(elems[l]) ;
+      for (Index_t n = 0 ; n < 8 ; ++n) {
+         elemX[n].v[l] = domain.x(elemToNode[n]) ;
+         elemY[n].v[l] = domain.y(elemToNode[n]) ;
+         elemZ[n].v[l] = domain.z(elemToNode[n]) ;
+      }
+   }
 }
 
 /******************************************/
 
-static inline
-void SumElemFaceNormal(Real_t *normalX0, Real_t *normalY0, Real_t *normalZ0,
-                       Real_t *normalX1, Real_t *normalY1, Real_t *normalZ1,
-                       Real_t *normalX2, Real_t *normalY2, Real_t *normalZ2,
-                       Real_t *normalX3, Real_t *normalY3, Real_t *normalZ3,
-                       const Real_t x0, const Real_t y0, const Real_t z0,
-                       const Real_t x1, const Real_t y1, const Real_t z1,
-                       const Real_t x2, const Real_t y2, const Real_t z2,
-                       const Real_t x3, const Real_t y3, const Real_t z3)
-{
-   Real_t bisectX0 = Real_t(0.5) * (x3 + x2 - x1 - x0);
-   Real_t bisectY0 = Real_t(0.5) * (y3 + y2 - y1 - y0);
-   Real_t bisectZ0 = Real_t(0.5) * (z3 + z2 - z1 - z0);
-   Real_t bisectX1 = Real_t(0.5) * (x2 + x1 - x3 - x0);
-   Real_t bisectY1 = Real_t(0.5) * (y2 + y1 - y3 - y0);
-   Real_t bisectZ1 = Real_t(0.5) * (z2 + z1 - z3 - z0);
-   Real_t areaX = Real_t(0.25) * (bisectY0 * bisectZ1 - bisectZ0 * bisectY1);
-   Real_t areaY = Real_t(0.25) * (bisectZ0 * bisectX1 - bisectX0 * bisectZ1);
-   Real_t areaZ = Real_t(0.25) * (bisectX0 * bisectY1 - bisectY0 * bisectX1);
-
-   *normalX0 += areaX;
-   *normalX1 += areaX;
-   *normalX2 += areaX;
-   *normalX3 += areaX;
-
-   *normalY0 += areaY;
-   *normalY1 += areaY;
-   *normalY2 += areaY;
-   *normalY3 += areaY;
-
-   *normalZ0 += areaZ;
-   *normalZ1 += areaZ;
-   *normalZ2 += areaZ;
-   *normalZ3 += areaZ;
-}
-
-/******************************************/
+#endif
 
+/* Adds the forces at the corners of the elements of one part, given by
+   element in fx_elem, fy_elem and fz_elem, to the nodes they touch */
 static inline
-void CalcElemNodeNormals(Real_t pfx[8],
-                         Real_t pfy[8],
-                         Real_t pfz[8],
-                         const Real_t x[8],
-                         const Real_t y[8],
-                         const Real_t z[8])
+void GatherCornerForcesForNodes(Domain &domain, Int_t part,
+                                const Real_t *fx_elem, const Real_t *fy_elem,
+                                const Real_t *fz_elem)
 {
-   for (Index_t i = 0 ; i < 8 ; ++i) {
-      pfx[i] = Real_t(0.0);
-      pfy[i] = Real_t(0.0);
-      pfz[i] = Real_t(0.0);
+   Index_t first = domain.cornerNodeBegin(part) ;
+   Index_t last = domain.cornerNodeEnd(part) ;
+
+#pragma omp parallel for firstprivate(first, last)
+   for( Index_t i=first ; i<last ; ++i )
+   {
+      Index_t gnode = domain.cornerNode(i) ;
+      Index_t count = domain.nodeElemCount(i) ;
+      Index_t *cornerList = domain.nodeElemCornerList(i) ;
+      Real_t fx_tmp = Real_t(0.0) ;
+      Real_t fy_tmp = Real_t(0.0) ;
+      Real_t fz_tmp = Real_t(0.0) ;
+      for (Index_t j=0 ; j < count ; ++j) {
+         Index_t ielem = cornerList[j] ;
+         fx_tmp += fx_elem[ielem] ;
+         fy_tmp += fy_elem[ielem] ;
+         fz_tmp += fz_elem[ielem] ;
+      }
+      domain.fx(gnode) += fx_tmp ;
+      domain.fy(gnode) += fy_tmp ;
+      domain.fz(gnode) += fz_tmp ;
    }
-   /* evaluate face one: nodes 0, 1, 2, 3 */
-   SumElemFaceNormal(&pfx[0], &pfy[0], &pfz[0],
-                  &pfx[1], &pfy[1], &pfz[1],
-                  &pfx[2], &pfy[2], &pfz[2],
-                  &pfx[3], &pfy[3], &pfz[3],
-                  x[0], y[0], z[0], x[1], y[1], z[1],
-                  x[2], y[2], z[2], x[3], y[3], z[3]);
-   /* evaluate face two: nodes 0, 4, 5, 1 */
-   SumElemFaceNormal(&pfx[0], &pfy[0], &pfz[0],
-                  &pfx[4], &pfy[4], &pfz[4],
-                  &pfx[5], &pfy[5], &pfz[5],
-                  &pfx[1], &pfy[1], &pfz[1],
-                  x[0], y[0], z[0], x[4], y[4], z[4],
-                  x[5], y[5], z[5], x[1], y[1], z[1]);
-   /* evaluate face three: nodes 1, 5, 6, 2 */
-   SumElemFaceNormal(&pfx[1], &pfy[1], &pfz[1],
-                  &pfx[5], &pfy[5], &pfz[5],
-                  &pfx[6], &pfy[6], &pfz[6],
-                  &pfx[2], &pfy[2], &pfz[2],
-                  x[1], y[1], z[1], x[5], y[5], z[5],
-                  x[6], y[6], z[6], x[2], y[2], z[2]);
-   /* evaluate face four: nodes 2, 6, 7, 3 */
-   SumElemFaceNormal(&pfx[2], &pfy[2], &pfz[2],
-                  &pfx[6], &pfy[6], &pfz[6],
-                  &pfx[7], &pfy[7], &pfz[7],
-                  &pfx[3], &pfy[3], &pfz[3],
-                  x[2], y[2], z[2], x[6], y[6], z[6],
-                  x[7], y[7], z[7], x[3], y[3], z[3]);
-   /* evaluate face five: nodes 3, 7, 4, 0 */
-   SumElemFaceNormal(&pfx[3], &pfy[3], &pfz[3],
-                  &pfx[7], &pfy[7], &pfz[7],
-                  &pfx[4], &pfy[4], &pfz[4],
-                  &pfx[0], &pfy[0], &pfz[0],
-                  x[3], y[3], z[3], x[7], y[7], z[7],
-                  x[4], y[4], z[4], x[0], y[0], z[0]);
-   /* evaluate face six: nodes 4, 7, 6, 5 */
-   SumElemFaceNormal(&pfx[4], &pfy[4], &pfz[4],
-                  &pfx[7], &pfy[7], &pfz[7],
-                  &pfx[6], &pfy[6], &pfz[6],
-                  &pfx[5], &pfy[5], &pfz[5],
-                  x[4], y[4], z[4], x[7], y[7], z[7],
-                  x[6], y[6], z[6], x[5], y[5], z[5]);
 }
 
 /******************************************/
 
 static inline
-void SumElemStressesToNodeForces( const Real_t B[][8],
-                                  const Real_t stress_xx,
-                                  const Real_t stress_yy,
-                                  const Real_t stress_zz,
-                                  Real_t fx[], Real_t fy[], Real_t fz[] )
+void InitStressTermsForElems(Domain &domain, Int_t part,
+                             Real_t *sigxx, Real_t *sigyy, Real_t *sigzz)
 {
-   for(Index_t i = 0; i < 8; i++) {
-      fx[i] = -( stress_xx * B[0][i] );
-      fy[i] = -( stress_yy * B[1][i]  );
-      fz[i] = -( stress_zz * B[2][i] );
+   const Index_t *elemList = domain.partElemList(part) ;
+   Index_t numPartElem = domain.partElemSize(part) ;
+
+   //
+   // pull in the stresses appropriate to the hydro integration
+   //
+
+#pragma omp parallel for firstprivate(numPartElem)
+   for (Index_t j = 0 ; j < numPartElem ; ++j){
+      Index_t i = elemList ? elemList[j] : j ;
+      sigxx[i] = sigyy[i] = sigzz[i] =  - domain.p(i) - domain.q(i) ;
    }
 }
 
 /******************************************/
 
 static inline
-void IntegrateStressForElems( Domain &domain,
+void IntegrateStressForElems( Domain &domain, Int_t part,
                               Real_t *sigxx, Real_t *sigyy, Real_t *sigzz,
-                              Real_t *determ, Index_t numElem, Index_t numNode)
+                              Real_t *determ, Index_t numElem)
 {
 #if _OPENMP
    Index_t numthreads = omp_get_max_threads();
@@ -502,6 +364,13 @@ void IntegrateStressForElems( Domain &domain,
    Index_t numthreads = 1;
 #endif
 
+   // With colorScatter, the elements go color by color and add their
+   // forces to the nodes directly, the elements of a color share none.
+   // Otherwise, with threads, each element writes to its own corners.
+   bool colored = domain.colorScatter() ;
+   bool toCorners = (numthreads > 1) && !colored ;
+   Int_t numSets = colored ? domain.numColors() : 1 ;
+
    Index_t numElem8 = numElem * 8 ;
    Real_t *fx_elem;
    Real_t *fy_elem;
@@ -511,209 +380,138 @@ void IntegrateStressForElems( Domain &domain,
    Real_t fz_local[8] ;
 
 
-  if (numthreads > 1) {
-     fx_elem = Allocate<Real_t>(numElem8) ;
-     fy_elem = Allocate<Real_t>(numElem8) ;
-     fz_elem = Allocate<Real_t>(numElem8) ;
+  if (toCorners) {
+     fx_elem = domain.AllocateScratch<Real_t>(numElem8) ;
+     fy_elem = domain.AllocateScratch<Real_t>(numElem8) ;
+     fz_elem = domain.AllocateScratch<Real_t>(numElem8) ;
   }
-  // loop over all elements
 
-#pragma omp parallel for firstprivate(numElem)
-  for( Index_t k=0 ; k<numElem ; ++k )
-  {
-    const Index_t* const elemToNode = domain.nodelist(k);
-    Real_t B[3][8] ;// shape function derivatives
-    Real_t x_local[8] ;
-    Real_t y_local[8] ;
-    Real_t z_local[8] ;
+  for (Int_t c=0 ; c<numSets ; ++c) {
+    const Index_t *elemList = colored ? domain.colorElemList(part, c)
+                                      : domain.partElemList(part) ;
+    Index_t numSetElem = colored ? domain.colorElemSize(part, c)
+                                 : domain.partElemSize(part) ;
 
-    // get nodal coordinates from global arrays and copy into local arrays.
-    CollectDomainNodesToElemNodes(domain, elemToNode, x_local, y_local, z_local);
+    // elements before jTail go by batches, the others one by one
+    Index_t jTail = 0 ;
+
+#if LULESH_BATCHED
+    const Index_t W = ElemBatch::width ;
+    jTail = numSetElem - numSetElem % W ;
+
+#pragma omp parallel for firstprivate(jTail)
+    for( Index_t j0=0 ; j0<jTail ; j0+=W )
+    {
+      Index_t elems[ElemBatch::width] ;
+      ElemBatch B[3][8] ;// shape function derivatives
+      ElemBatch x_local[8], y_local[8], z_local[8] ;
+      ElemBatch fx_batch[8], fy_batch[8], fz_batch[8] ;
+      ElemBatch sxx, syy, szz, volume ;
+
+      for (Index_t l=0 ; l<W ; ++l) {
+         elems[l] = elemList ? elemList[j0+l] : j0+l ;
+      }
+
+      CollectDomainNodesToElemNodes(domain, elems, x_local, y_local, z_local);
 
-    // Volume calculation involves extra work for numerical consistency
-    CalcElemShapeFunctionDerivatives(x_local, y_local, z_local,
-                                         B, &determ[k]);
+      CalcElemShapeFunctionDerivatives(x_local, y_local, z_local,
+                                       B, &volume);
 
-    CalcElemNodeNormals( B[0] , B[1], B[2],
-                          x_local, y_local, z_local );
+      CalcElemNodeNormals( B[0] , B[1], B[2],
+                            x_local, y_local, z_local );
 
-    if (numthreads > 1) {
-       // Eliminate thread writing conflicts at the nodes by giving
-       // each element its own copy to write to
-       SumElemStressesToNodeForces( B, sigxx[k], sigyy[k], sigzz[k],
-                                    &fx_elem[k*8],
-                                    &fy_elem[k*8],
-                                    &fz_elem[k*8] ) ;
+      for (Index_t l=0 ; l<W ; ++l) {
+         sxx.v[l] = sigxx[elems[l]] ;
+         syy.v[l] = sigyy[elems[l]] ;
+         szz.v[l] = sigzz[elems[l]] ;
+      }
+      SumElemStressesToNodeForces( B, sxx, syy, szz,
+                                   fx_batch, fy_batch, fz_batch ) ;
+
+      for (Index_t l=0 ; l<W ; ++l) {
+         Index_t k = elems[l] ;
+         const Index_t* const elemToNode = domain.nodelist(k);
+         determ[k] = volume.v[l] ;
+         for( Index_t lnode=0 ; lnode<8 ; ++lnode ) {
+            if (toCorners) {
+               fx_elem[k*8+lnode] = fx_batch[lnode].v[l] ;
+               fy_elem[k*8+lnode] = fy_batch[lnode].v[l] ;
+               fz_elem[k*8+lnode] = fz_batch[lnode].v[l] ;
+            }
+            else {
+               Index_t gnode = elemToNode[lnode];
+               domain.fx(gnode) += fx_batch[lnode].v[l];
+               domain.fy(gnode) += fy_batch[lnode].v[l];
+               domain.fz(gnode) += fz_batch[lnode].v[l];
+            }
+         }
+      }
     }
-    else {
-       SumElemStressesToNodeForces( B, sigxx[k], sigyy[k], sigzz[k],
-                                    fx_local, fy_local, fz_local ) ;
-
-       // copy nodal force contributions to global force arrray.
-       for( Index_t lnode=0 ; lnode<8 ; ++lnode ) {
-          Index_t gnode = elemToNode[lnode];
-          domain.fx(gnode) += fx_local[lnode];
-          domain.fy(gnode) += fy_local[lnode];
-          domain.fz(gnode) += fz_local[lnode];
-       }
+#endif
+
+    // loop over all elements
+
+#pragma omp parallel for firstprivate(numSetElem) private(fx_local, fy_local, fz_local)
+    for( Index_t j=jTail ; j<numSetElem ; ++j )
+    {
+      Index_t k = elemList ? elemList[j] : j ;
+      const Index_t* const elemToNode = domain.nodelist(k);
+      Real_t B[3][8] ;// shape function derivatives
+      Real_t x_local[8] ;
+      Real_t y_local[8] ;
+      Real_t z_local[8] ;
+
+      // get nodal coordinates from global arrays and copy into local arrays.
+      CollectDomainNodesToElemNodes(domain, elemToNode, x_local, y_local, z_local);
+
+      // Volume calculation involves extra work for numerical consistency
+      CalcElemShapeFunctionDerivatives(x_local, y_local, z_local,
+                                           B, &determ[k]);
+
+      CalcElemNodeNormals( B[0] , B[1], B[2],
+                            x_local, y_local, z_local );
+
+      if (toCorners) {
+         // Eliminate thread writing conflicts at the nodes by giving
+         // each element its own copy to write to
+         SumElemStressesToNodeForces( B, sigxx[k], sigyy[k], sigzz[k],
+                                      &fx_elem[k*8],
+                                      &fy_elem[k*8],
+                                      &fz_elem[k*8] ) ;
+      }
+      else {
+         SumElemStressesToNodeForces( B, sigxx[k], sigyy[k], sigzz[k],
+                                      fx_local, fy_local, fz_local ) ;
+
+         // copy nodal force contributions to global force arrray.
+         for( Index_t lnode=0 ; lnode<8 ; ++lnode ) {
+            Index_t gnode = elemToNode[lnode];
+            domain.fx(gnode) += fx_local[lnode];
+            domain.fy(gnode) += fy_local[lnode];
+            domain.fz(gnode) += fz_local[lnode];
+         }
+      }
     }
   }
 
-  if (numthreads > 1) {
+  if (toCorners) {
      // If threaded, then we need to copy the data out of the temporary
      // arrays used above into the final forces field
-#pragma omp parallel for firstprivate(numNode)
-     for( Index_t gnode=0 ; gnode<numNode ; ++gnode )
-     {
-        Index_t count = domain.nodeElemCount(gnode) ;
-        Index_t *cornerList = domain.nodeElemCornerList(gnode) ;
-        Real_t fx_tmp = Real_t(0.0) ;
-        Real_t fy_tmp = Real_t(0.0) ;
-        Real_t fz_tmp = Real_t(0.0) ;
-        for (Index_t i=0 ; i < count ; ++i) {
-           Index_t ielem = cornerList[i] ;
-           fx_tmp += fx_elem[ielem] ;
-           fy_tmp += fy_elem[ielem] ;
-           fz_tmp += fz_elem[ielem] ;
-        }
-        domain.fx(gnode) = fx_tmp ;
-        domain.fy(gnode) = fy_tmp ;
-        domain.fz(gnode) = fz_tmp ;
-     }
-     Release(&fz_elem) ;
-     Release(&fy_elem) ;
-     Release(&fx_elem) ;
+     GatherCornerForcesForNodes(domain, part, fx_elem, fy_elem, fz_elem) ;
+     domain.ReleaseScratch(&fz_elem) ;
+     domain.ReleaseScratch(&fy_elem) ;
+     domain.ReleaseScratch(&fx_elem) ;
   }
 }
 
 /******************************************/
 
 static inline
-void VoluDer(const Real_t x0, const Real_t x1, const Real_t x2,
-             const Real_t x3, const Real_t x4, const Real_t x5,
-             const Real_t y0, const Real_t y1, const Real_t y2,
-             const Real_t y3, const Real_t y4, const Real_t y5,
-             const Real_t z0, const Real_t z1, const Real_t z2,
-             const Real_t z3, const Real_t z4, const Real_t z5,
-             Real_t* dvdx, Real_t* dvdy, Real_t* dvdz)
-{
-   const Real_t twelfth = Real_t(1.0) / Real_t(12.0) ;
-
-   *dvdx =
-      (y1 + y2) * (z0 + z1) - (y0 + y1) * (z1 + z2) +
-      (y0 + y4) * (z3 + z4) - (y3 + y4) * (z0 + z4) -
-      (y2 + y5) * (z3 + z5) + (y3 + y5) * (z2 + z5);
-   *dvdy =
-      - (x1 + x2) * (z0 + z1) + (x0 + x1) * (z1 + z2) -
-      (x0 + x4) * (z3 + z4) + (x3 + x4) * (z0 + z4) +
-      (x2 + x5) * (z3 + z5) - (x3 + x5) * (z2 + z5);
-
-   *dvdz =
-      - (y1 + y2) * (x0 + x1) + (y0 + y1) * (x1 + x2) -
-      (y0 + y4) * (x3 + x4) + (y3 + y4) * (x0 + x4) +
-      (y2 + y5) * (x3 + x5) - (y3 + y5) * (x2 + x5);
-
-   *dvdx *= twelfth;
-   *dvdy *= twelfth;
-   *dvdz *= twelfth;
-}
-
-/******************************************/
-
-static inline
-void CalcElemVolumeDerivative(Real_t dvdx[8],
-                              Real_t dvdy[8],
-                              Real_t dvdz[8],
-                              const Real_t x[8],
-                              const Real_t y[8],
-                              const Real_t z[8])
-{
-   VoluDer(x[1], x[2], x[3], x[4], x[5], x[7],
-           y[1], y[2], y[3], y[4], y[5], y[7],
-           z[1], z[2], z[3], z[4], z[5], z[7],
-           &dvdx[0], &dvdy[0], &dvdz[0]);
-   VoluDer(x[0], x[1], x[2], x[7], x[4], x[6],
-           y[0], y[1], y[2], y[7], y[4], y[6],
-           z[0], z[1], z[2], z[7], z[4], z[6],
-           &dvdx[3], &dvdy[3], &dvdz[3]);
-   VoluDer(x[3], x[0], x[1], x[6], x[7], x[5],
-           y[3], y[0], y[1], y[6], y[7], y[5],
-           z[3], z[0], z[1], z[6], z[7], z[5],
-           &dvdx[2], &dvdy[2], &dvdz[2]);
-   VoluDer(x[2], x[3], x[0], x[5], x[6], x[4],
-           y[2], y[3], y[0], y[5], y[6], y[4],
-           z[2], z[3], z[0], z[5], z[6], z[4],
-           &dvdx[1], &dvdy[1], &dvdz[1]);
-   VoluDer(x[7], x[6], x[5], x[0], x[3], x[1],
-           y[7], y[6], y[5], y[0], y[3], y[1],
-           z[7], z[6], z[5], z[0], z[3], z[1],
-           &dvdx[4], &dvdy[4], &dvdz[4]);
-   VoluDer(x[4], x[7], x[6], x[1], x[0], x[2],
-           y[4], y[7], y[6], y[1], y[0], y[2],
-           z[4], z[7], z[6], z[1], z[0], z[2],
-           &dvdx[5], &dvdy[5], &dvdz[5]);
-   VoluDer(x[5], x[4], x[7], x[2], x[1], x[3],
-           y[5], y[4], y[7], y[2], y[1], y[3],
-           z[5], z[4], z[7], z[2], z[1], z[3],
-           &dvdx[6], &dvdy[6], &dvdz[6]);
-   VoluDer(x[6], x[5], x[4], x[3], x[2], x[0],
-           y[6], y[5], y[4], y[3], y[2], y[0],
-           z[6], z[5], z[4], z[3], z[2], z[0],
-           &dvdx[7], &dvdy[7], &dvdz[7]);
-}
-
-/******************************************/
-
-static inline
-void CalcElemFBHourglassForce(Real_t *xd, Real_t *yd, Real_t *zd,  Real_t hourgam[][4],
-                              Real_t coefficient,
-                              Real_t *hgfx, Real_t *hgfy, Real_t *hgfz )
-{
-   Real_t hxx[4];
-   for(Index_t i = 0; i < 4; i++) {
-      hxx[i] = hourgam[0][i] * xd[0] + hourgam[1][i] * xd[1] +
-               hourgam[2][i] * xd[2] + hourgam[3][i] * xd[3] +
-               hourgam[4][i] * xd[4] + hourgam[5][i] * xd[5] +
-               hourgam[6][i] * xd[6] + hourgam[7][i] * xd[7];
-   }
-   for(Index_t i = 0; i < 8; i++) {
-      hgfx[i] = coefficient *
-                (hourgam[i][0] * hxx[0] + hourgam[i][1] * hxx[1] +
-                 hourgam[i][2] * hxx[2] + hourgam[i][3] * hxx[3]);
-   }
-   for(Index_t i = 0; i < 4; i++) {
-      hxx[i] = hourgam[0][i] * yd[0] + hourgam[1][i] * yd[1] +
-               hourgam[2][i] * yd[2] + hourgam[3][i] * yd[3] +
-               hourgam[4][i] * yd[4] + hourgam[5][i] * yd[5] +
-               hourgam[6][i] * yd[6] + hourgam[7][i] * yd[7];
-   }
-   for(Index_t i = 0; i < 8; i++) {
-      hgfy[i] = coefficient *
-                (hourgam[i][0] * hxx[0] + hourgam[i][1] * hxx[1] +
-                 hourgam[i][2] * hxx[2] + hourgam[i][3] * hxx[3]);
-   }
-   for(Index_t i = 0; i < 4; i++) {
-      hxx[i] = hourgam[0][i] * zd[0] + hourgam[1][i] * zd[1] +
-               hourgam[2][i] * zd[2] + hourgam[3][i] * zd[3] +
-               hourgam[4][i] * zd[4] + hourgam[5][i] * zd[5] +
-               hourgam[6][i] * zd[6] + hourgam[7][i] * zd[7];
-   }
-   for(Index_t i = 0; i < 8; i++) {
-      hgfz[i] = coefficient *
-                (hourgam[i][0] * hxx[0] + hourgam[i][1] * hxx[1] +
-                 hourgam[i][2] * hxx[2] + hourgam[i][3] * hxx[3]);
-   }
-}
-
-/******************************************/
-
-static inline
-void CalcFBHourglassForceForElems( Domain &domain,
+void CalcFBHourglassForceForElems( Domain &domain, Int_t part,
                                    Real_t *determ,
                                    Real_t *x8n, Real_t *y8n, Real_t *z8n,
                                    Real_t *dvdx, Real_t *dvdy, Real_t *dvdz,
-                                   Real_t hourg, Index_t numElem,
-                                   Index_t numNode)
+                                   Real_t hourg, Index_t numElem)
 {
 
 #if _OPENMP
@@ -728,286 +526,369 @@ void CalcFBHourglassForceForElems( Domain &domain,
     *
     *************************************************/
   
+   // Colored, the elements of a color share no node and add their
+   // forces to the nodes directly, see IntegrateStressForElems
+   bool colored = domain.colorScatter() ;
+   bool toCorners = (numthreads > 1) && !colored ;
+   Int_t numSets = colored ? domain.numColors() : 1 ;
+
    Index_t numElem8 = numElem * 8 ;
 
    Real_t *fx_elem; 
    Real_t *fy_elem; 
    Real_t *fz_elem; 
 
-   if(numthreads > 1) {
-      fx_elem = Allocate<Real_t>(numElem8) ;
-      fy_elem = Allocate<Real_t>(numElem8) ;
-      fz_elem = Allocate<Real_t>(numElem8) ;
+   if(toCorners) {
+      fx_elem = domain.AllocateScratch<Real_t>(numElem8) ;
+      fy_elem = domain.AllocateScratch<Real_t>(numElem8) ;
+      fz_elem = domain.AllocateScratch<Real_t>(numElem8) ;
    }
 
-   Real_t  gamma[4][8];
-
-   gamma[0][0] = Real_t( 1.);
-   gamma[0][1] = Real_t( 1.);
-   gamma[0][2] = Real_t(-1.);
-   gamma[0][3] = Real_t(-1.);
-   gamma[0][4] = Real_t(-1.);
-   gamma[0][5] = Real_t(-1.);
-   gamma[0][6] = Real_t( 1.);
-   gamma[0][7] = Real_t( 1.);
-   gamma[1][0] = Real_t( 1.);
-   gamma[1][1] = Real_t(-1.);
-   gamma[1][2] = Real_t(-1.);
-   gamma[1][3] = Real_t( 1.);
-   gamma[1][4] = Real_t(-1.);
-   gamma[1][5] = Real_t( 1.);
-   gamma[1][6] = Real_t( 1.);
-   gamma[1][7] = Real_t(-1.);
-   gamma[2][0] = Real_t( 1.);
-   gamma[2][1] = Real_t(-1.);
-   gamma[2][2] = Real_t( 1.);
-   gamma[2][3] = Real_t(-1.);
-   gamma[2][4] = Real_t( 1.);
-   gamma[2][5] = Real_t(-1.);
-   gamma[2][6] = Real_t( 1.);
-   gamma[2][7] = Real_t(-1.);
-   gamma[3][0] = Real_t(-1.);
-   gamma[3][1] = Real_t( 1.);
-   gamma[3][2] = Real_t(-1.);
-   gamma[3][3] = Real_t( 1.);
-   gamma[3][4] = Real_t( 1.);
-   gamma[3][5] = Real_t(-1.);
-   gamma[3][6] = Real_t( 1.);
-   gamma[3][7] = Real_t(-1.);
+   const Real_t (*gamma)[8] = hourglassGamma ;
 
 /*************************************************/
 /*    compute the hourglass modes */
 
+   for (Int_t c=0 ; c<numSets ; ++c) {
+      const Index_t *elemList = colored ? domain.colorElemList(part, c)
+                                        : domain.partElemList(part) ;
+      Index_t numSetElem = colored ? domain.colorElemSize(part, c)
+                                   : domain.partElemSize(part) ;
+
+      // elements before j2Tail go by batches, the others one by one
+      Index_t j2Tail = 0 ;
+
+#if LULESH_BATCHED
+      const Index_t W = ElemBatch::width ;
+      j2Tail = numSetElem - numSetElem % W ;
+
+#pragma omp parallel for firstprivate(j2Tail, hourg)
+      for(Index_t j0=0;j0<j2Tail;j0+=W){
+         Index_t elems[ElemBatch::width] ;
+         ElemBatch hgfx[8], hgfy[8], hgfz[8] ;
+         ElemBatch coefficient, volinv ;
+         ElemBatch hourgam[8][4];
+         ElemBatch xd1[8], yd1[8], zd1[8] ;
+         ElemBatch x8[8], y8[8], z8[8] ;
+         ElemBatch dx8[8], dy8[8], dz8[8] ;
+
+         for (Index_t l=0 ; l<W ; ++l) {
+            elems[l] = elemList ? elemList[j0+l] : j0+l ;
+         }
 
-#pragma omp parallel for firstprivate(numElem, hourg)
-   for(Index_t i2=0;i2<numElem;++i2){
-      Real_t *fx_local, *fy_local, *fz_local ;
-      Real_t hgfx[8], hgfy[8], hgfz[8] ;
-
-      Real_t coefficient;
-
-      Real_t hourgam[8][4];
-      Real_t xd1[8], yd1[8], zd1[8] ;
-
-      const Index_t *elemToNode = domain.nodelist(i2);
-      Index_t i3=8*i2;
-      Real_t volinv=Real_t(1.0)/determ[i2];
-      Real_t ss1, mass1, volume13 ;
-      for(Index_t i1=0;i1<4;++i1){
-
-         Real_t hourmodx =
-            x8n[i3] * gamma[i1][0] + x8n[i3+1] * gamma[i1][1] +
-            x8n[i3+2] * gamma[i1][2] + x8n[i3+3] * gamma[i1][3] +
-            x8n[i3+4] * gamma[i1][4] + x8n[i3+5] * gamma[i1][5] +
-            x8n[i3+6] * gamma[i1][6] + x8n[i3+7] * gamma[i1][7];
-
-         Real_t hourmody =
-            y8n[i3] * gamma[i1][0] + y8n[i3+1] * gamma[i1][1] +
-            y8n[i3+2] * gamma[i1][2] + y8n[i3+3] * gamma[i1][3] +
-            y8n[i3+4] * gamma[i1][4] + y8n[i3+5] * gamma[i1][5] +
-            y8n[i3+6] * gamma[i1][6] + y8n[i3+7] * gamma[i1][7];
-
-         Real_t hourmodz =
-            z8n[i3] * gamma[i1][0] + z8n[i3+1] * gamma[i1][1] +
-            z8n[i3+2] * gamma[i1][2] + z8n[i3+3] * gamma[i1][3] +
-            z8n[i3+4] * gamma[i1][4] + z8n[i3+5] * gamma[i1][5] +
-            z8n[i3+6] * gamma[i1][6] + z8n[i3+7] * gamma[i1][7];
-
-         hourgam[0][i1] = gamma[i1][0] -  volinv*(dvdx[i3  ] * hourmodx +
-                                                  dvdy[i3  ] * hourmody +
-                                                  dvdz[i3  ] * hourmodz );
-
-         hourgam[1][i1] = gamma[i1][1] -  volinv*(dvdx[i3+1] * hourmodx +
-                                                  dvdy[i3+1] * hourmody +
-                                                  dvdz[i3+1] * hourmodz );
-
-         hourgam[2][i1] = gamma[i1][2] -  volinv*(dvdx[i3+2] * hourmodx +
-                                                  dvdy[i3+2] * hourmody +
-                                                  dvdz[i3+2] * hourmodz );
-
-         hourgam[3][i1] = gamma[i1][3] -  volinv*(dvdx[i3+3] * hourmodx +
-                                                  dvdy[i3+3] * hourmody +
-                                                  dvdz[i3+3] * hourmodz );
-
-         hourgam[4][i1] = gamma[i1][4] -  volinv*(dvdx[i3+4] * hourmodx +
-                                                  dvdy[i3+4] * hourmody +
-                                                  dvdz[i3+4] * hourmodz );
-
-         hourgam[5][i1] = gamma[i1][5] -  volinv*(dvdx[i3+5] * hourmodx +
-                                                  dvdy[i3+5] * hourmody +
-                                                  dvdz[i3+5] * hourmodz );
-
-         hourgam[6][i1] = gamma[i1][6] -  volinv*(dvdx[i3+6] * hourmodx +
-                                                  dvdy[i3+6] * hourmody +
-                                                  dvdz[i3+6] * hourmodz );
-
-         hourgam[7][i1] = gamma[i1][7] -  volinv*(dvdx[i3+7] * hourmodx +
-                                                  dvdy[i3+7] * hourmody +
-                                                  dvdz[i3+7] * hourmodz );
-
-      }
-
-      /* compute forces */
-      /* store forces into h arrays (force arrays) */
-
-      ss1=domain.ss(i2);
-      mass1=domain.elemMass(i2);
-      volume13=CBRT(determ[i2]);
-
-      Index_t n0si2 = elemToNode[0];
-      Index_t n1si2 = elemToNode[1];
-      Index_t n2si2 = elemToNode[2];
-      Index_t n3si2 = elemToNode[3];
-      Index_t n4si2 = elemToNode[4];
-      Index_t n5si2 = elemToNode[5];
-      Index_t n6si2 = elemToNode[6];
-      Index_t n7si2 = elemToNode[7];
-
-      xd1[0] = domain.xd(n0si2);
-      xd1[1] = domain.xd(n1si2);
-      xd1[2] = domain.xd(n2si2);
-      xd1[3] = domain.xd(n3si2);
-      xd1[4] = domain.xd(n4si2);
-      xd1[5] = domain.xd(n5si2);
-      xd1[6] = domain.xd(n6si2);
-      xd1[7] = domain.xd(n7si2);
-
-      yd1[0] = domain.yd(n0si2);
-      yd1[1] = domain.yd(n1si2);
-      yd1[2] = domain.yd(n2si2);
-      yd1[3] = domain.yd(n3si2);
-      yd1[4] = domain.yd(n4si2);
-      yd1[5] = domain.yd(n5si2);
-      yd1[6] = domain.yd(n6si2);
-      yd1[7] = domain.yd(n7si2);
-
-      zd1[0] = domain.zd(n0si2);
-      zd1[1] = domain.zd(n1si2);
-      zd1[2] = domain.zd(n2si2);
-      zd1[3] = domain.zd(n3si2);
-      zd1[4] = domain.zd(n4si2);
-      zd1[5] = domain.zd(n5si2);
-      zd1[6] = domain.zd(n6si2);
-      zd1[7] = domain.zd(n7si2);
-
-      coefficient = - hourg * Real_t(0.01) * ss1 * mass1 / volume13;
-
-      CalcElemFBHourglassForce(xd1,yd1,zd1,
-                      hourgam,
-                      coefficient, hgfx, hgfy, hgfz);
-
-      // With the threaded version, we write into local arrays per elem
-      // so we don't have to worry about race conditions
-      if (numthreads > 1) {
-         fx_local = &fx_elem[i3] ;
-         fx_local[0] = hgfx[0];
-         fx_local[1] = hgfx[1];
-         fx_local[2] = hgfx[2];
-         fx_local[3] = hgfx[3];
-         fx_local[4] = hgfx[4];
-         fx_local[5] = hgfx[5];
-         fx_local[6] = hgfx[6];
-         fx_local[7] = hgfx[7];
-
-         fy_local = &fy_elem[i3] ;
-         fy_local[0] = hgfy[0];
-         fy_local[1] = hgfy[1];
-         fy_local[2] = hgfy[2];
-         fy_local[3] = hgfy[3];
-         fy_local[4] = hgfy[4];
-         fy_local[5] = hgfy[5];
-         fy_local[6] = hgfy[6];
-         fy_local[7] = hgfy[7];
-
-         fz_local = &fz_elem[i3] ;
-         fz_local[0] = hgfz[0];
-         fz_local[1] = hgfz[1];
-         fz_local[2] = hgfz[2];
-         fz_local[3] = hgfz[3];
-         fz_local[4] = hgfz[4];
-         fz_local[5] = hgfz[5];
-         fz_local[6] = hgfz[6];
-         fz_local[7] = hgfz[7];
-      }
-      else {
-         domain.fx(n0si2) += hgfx[0];
-         domain.fy(n0si2) += hgfy[0];
-         domain.fz(n0si2) += hgfz[0];
-
-         domain.fx(n1si2) += hgfx[1];
-         domain.fy(n1si2) += hgfy[1];
-         domain.fz(n1si2) += hgfz[1];
-
-         domain.fx(n2si2) += hgfx[2];
-         domain.fy(n2si2) += hgfy[2];
-         domain.fz(n2si2) += hgfz[2];
-
-         domain.fx(n3si2) += hgfx[3];
-         domain.fy(n3si2) += hgfy[3];
-         domain.fz(n3si2) += hgfz[3];
+         for (Index_t l=0 ; l<W ; ++l) {
+            Index_t i2 = elems[l] ;
+            const Index_t *elemToNode = domain.nodelist(i2);
+            Index_t i3=8*i2;
+            for (Index_t n=0 ; n<8 ; ++n) {
+               x8[n].v[l]  = x8n[i3+n] ;
+               y8[n].v[l]  = y8n[i3+n] ;
+               z8[n].v[l]  = z8n[i3+n] ;
+               dx8[n].v[l] = dvdx[i3+n] ;
+               dy8[n].v[l] = dvdy[i3+n] ;
+               dz8[n].v[l] = dvdz[i3+n] ;
+               xd1[n].v[l] = domain.xd(elemToNode[n]) ;
+               yd1[n].v[l] = domain.yd(elemToNode[n]) ;
+               zd1[n].v[l] = domain.zd(elemToNode[n]) ;
+            }
+            volinv.v[l] = Real_t(1.0)/determ[i2] ;
+            coefficient.v[l] = - hourg * Real_t(0.01) * domain.ss(i2) *
+                               domain.elemMass(i2) / CBRT(determ[i2]) ;
+         }
 
-         domain.fx(n4si2) += hgfx[4];
-         domain.fy(n4si2) += hgfy[4];
-         domain.fz(n4si2) += hgfz[4];
+         CalcElemHourglassModes(x8, y8, z8, dx8, dy8, dz8, volinv, hourgam);
+
+         CalcElemFBHourglassForce(xd1,yd1,zd1,
+                         hourgam,
+                         coefficient, hgfx, hgfy, hgfz);
+
+         for (Index_t l=0 ; l<W ; ++l) {
+            Index_t i2 = elems[l] ;
+            const Index_t *elemToNode = domain.nodelist(i2);
+            Index_t i3=8*i2;
+            for (Index_t n=0 ; n<8 ; ++n) {
+               if (toCorners) {
+                  fx_elem[i3+n] = hgfx[n].v[l];
+                  fy_elem[i3+n] = hgfy[n].v[l];
+                  fz_elem[i3+n] = hgfz[n].v[l];
+               }
+               else {
+                  domain.fx(elemToNode[n]) += hgfx[n].v[l];
+                  domain.fy(elemToNode[n]) += hgfy[n].v[l];
+                  domain.fz(elemToNode[n]) += hgfz[n].v[l];
+               }
+            }
+         }
+      }
+#endif
 
-         domain.fx(n5si2) += hgfx[5];
-         domain.fy(n5si2) += hgfy[5];
-         domain.fz(n5si2) += hgfz[5];
+#pragma omp parallel for firstprivate(numSetElem, hourg)
+      for(Index_t j2=j2Tail;j2<numSetElem;++j2){
+         Index_t i2 = elemList ? elemList[j2] : j2 ;
+         Real_t *fx_local, *fy_local, *fz_local ;
+         Real_t hgfx[8], hgfy[8], hgfz[8] ;
+
+         Real_t coefficient;
+
+         Real_t hourgam[8][4];
+         Real_t xd1[8], yd1[8], zd1[8] ;
+
+         const Index_t *elemToNode = domain.nodelist(i2);
+         Index_t i3=8*i2;
+         Real_t volinv=Real_t(1.0)/determ[i2];
+         Real_t ss1, mass1, volume13 ;
+         for(Index_t i1=0;i1<4;++i1){
+
+            Real_t hourmodx =
+               x8n[i3] * gamma[i1][0] + x8n[i3+1] * gamma[i1][1] +
+               x8n[i3+2] * gamma[i1][2] + x8n[i3+3] * gamma[i1][3] +
+               x8n[i3+4] * gamma[i1][4] + x8n[i3+5] * gamma[i1][5] +
+               x8n[i3+6] * gamma[i1][6] + x8n[i3+7] * gamma[i1][7];
+
+            Real_t hourmody =
+               y8n[i3] * gamma[i1][0] + y8n[i3+1] * gamma[i1][1] +
+               y8n[i3+2] * gamma[i1][2] + y8n[i3+3] * gamma[i1][3] +
+               y8n[i3+4] * gamma[i1][4] + y8n[i3+5] * gamma[i1][5] +
+               y8n[i3+6] * gamma[i1][6] + y8n[i3+7] * gamma[i1][7];
+
+            Real_t hourmodz =
+               z8n[i3] * gamma[i1][0] + z8n[i3+1] * gamma[i1][1] +
+               z8n[i3+2] * gamma[i1][2] + z8n[i3+3] * gamma[i1][3] +
+               z8n[i3+4] * gamma[i1][4] + z8n[i3+5] * gamma[i1][5] +
+               z8n[i3+6] * gamma[i1][6] + z8n[i3+7] * gamma[i1][7];
+
+            hourgam[0][i1] = gamma[i1][0] -  volinv*(dvdx[i3  ] * hourmodx +
+                                                     dvdy[i3  ] * hourmody +
+                                                     dvdz[i3  ] * hourmodz );
+
+            hourgam[1][i1] = gamma[i1][1] -  volinv*(dvdx[i3+1] * hourmodx +
+                                                     dvdy[i3+1] * hourmody +
+                                                     dvdz[i3+1] * hourmodz );
+
+            hourgam[2][i1] = gamma[i1][2] -  volinv*(dvdx[i3+2] * hourmodx +
+                                                     dvdy[i3+2] * hourmody +
+                                                     dvdz[i3+2] * hourmodz );
+
+            hourgam[3][i1] = gamma[i1][3] -  volinv*(dvdx[i3+3] * hourmodx +
+                                                     dvdy[i3+3] * hourmody +
+                                                     dvdz[i3+3] * hourmodz );
+
+            hourgam[4][i1] = gamma[i1][4] -  volinv*(dvdx[i3+4] * hourmodx +
+                                                     dvdy[i3+4] * hourmody +
+                                                     dvdz[i3+4] * hourmodz );
+
+            hourgam[5][i1] = gamma[i1][5] -  volinv*(dvdx[i3+5] * hourmodx +
+                                                     dvdy[i3+5] * hourmody +
+                                                     dvdz[i3+5] * hourmodz );
+
+            hourgam[6][i1] = gamma[i1][6] -  volinv*(dvdx[i3+6] * hourmodx +
+                                                     dvdy[i3+6] * hourmody +
+                                                     dvdz[i3+6] * hourmodz );
+
+            hourgam[7][i1] = gamma[i1][7] -  volinv*(dvdx[i3+7] * hourmodx +
+                                                     dvdy[i3+7] * hourmody +
+                                                     dvdz[i3+7] * hourmodz );
 
-         domain.fx(n6si2) += hgfx[6];
-         domain.fy(n6si2) += hgfy[6];
-         domain.fz(n6si2) += hgfz[6];
+         }
 
-         domain.fx(n7si2) += hgfx[7];
-         domain.fy(n7si2) += hgfy[7];
-         domain.fz(n7si2) += hgfz[7];
+         /* compute forces */
+         /* store forces into h arrays (force arrays) */
+
+         ss1=domain.ss(i2);
+         mass1=domain.elemMass(i2);
+         volume13=CBRT(determ[i2]);
+
+         Index_t n0si2 = elemToNode[0];
+         Index_t n1si2 = elemToNode[1];
+         Index_t n2si2 = elemToNode[2];
+         Index_t n3si2 = elemToNode[3];
+         Index_t n4si2 = elemToNode[4];
+         Index_t n5si2 = elemToNode[5];
+         Index_t n6si2 = elemToNode[6];
+         Index_t n7si2 = elemToNode[7];
+
+         xd1[0] = domain.xd(n0si2);
+         xd1[1] = domain.xd(n1si2);
+         xd1[2] = domain.xd(n2si2);
+         xd1[3] = domain.xd(n3si2);
+         xd1[4] = domain.xd(n4si2);
+         xd1[5] = domain.xd(n5si2);
+         xd1[6] = domain.xd(n6si2);
+         xd1[7] = domain.xd(n7si2);
+
+         yd1[0] = domain.yd(n0si2);
+         yd1[1] = domain.yd(n1si2);
+         yd1[2] = domain.yd(n2si2);
+         yd1[3] = domain.yd(n3si2);
+         yd1[4] = domain.yd(n4si2);
+         yd1[5] = domain.yd(n5si2);
+         yd1[6] = domain.yd(n6si2);
+         yd1[7] = domain.yd(n7si2);
+
+         zd1[0] = domain.zd(n0si2);
+         zd1[1] = domain.zd(n1si2);
+         zd1[2] = domain.zd(n2si2);
+         zd1[3] = domain.zd(n3si2);
+         zd1[4] = domain.zd(n4si2);
+         zd1[5] = domain.zd(n5si2);
+         zd1[6] = domain.zd(n6si2);
+         zd1[7] = domain.zd(n7si2);
+
+         coefficient = - hourg * Real_t(0.01) * ss1 * mass1 / volume13;
+
+         CalcElemFBHourglassForce(xd1,yd1,zd1,
+                         hourgam,
+                         coefficient, hgfx, hgfy, hgfz);
+
+         // With the threaded version, we write into local arrays per elem
+         // so we don't have to worry about race conditions
+         if (toCorners) {
+            fx_local = &fx_elem[i3] ;
+            fx_local[0] = hgfx[0];
+            fx_local[1] = hgfx[1];
+            fx_local[2] = hgfx[2];
+            fx_local[3] = hgfx[3];
+            fx_local[4] = hgfx[4];
+            fx_local[5] = hgfx[5];
+            fx_local[6] = hgfx[6];
+            fx_local[7] = hgfx[7];
+
+            fy_local = &fy_elem[i3] ;
+            fy_local[0] = hgfy[0];
+            fy_local[1] = hgfy[1];
+            fy_local[2] = hgfy[2];
+            fy_local[3] = hgfy[3];
+            fy_local[4] = hgfy[4];
+            fy_local[5] = hgfy[5];
+            fy_local[6] = hgfy[6];
+            fy_local[7] = hgfy[7];
+
+            fz_local = &fz_elem[i3] ;
+            fz_local[0] = hgfz[0];
+            fz_local[1] = hgfz[1];
+            fz_local[2] = hgfz[2];
+            fz_local[3] = hgfz[3];
+            fz_local[4] = hgfz[4];
+            fz_local[5] = hgfz[5];
+            fz_local[6] = hgfz[6];
+            fz_local[7] = hgfz[7];
+         }
+         else {
+            domain.fx(n0si2) += hgfx[0];
+            domain.fy(n0si2) += hgfy[0];
+            domain.fz(n0si2) += hgfz[0];
+
+            domain.fx(n1si2) += hgfx[1];
+            domain.fy(n1si2) += hgfy[1];
+            domain.fz(n1si2) += hgfz[1];
+
+            domain.fx(n2si2) += hgfx[2];
+            domain.fy(n2si2) += hgfy[2];
+            domain.fz(n2si2) += hgfz[2];
+
+            domain.fx(n3si2) += hgfx[3];
+            domain.fy(n3si2) += hgfy[3];
+            domain.fz(n3si2) += hgfz[3];
+
+            domain.fx(n4si2) += hgfx[4];
+            domain.fy(n4si2) += hgfy[4];
+            domain.fz(n4si2) += hgfz[4];
+
+            domain.fx(n5si2) += hgfx[5];
+            domain.fy(n5si2) += hgfy[5];
+            domain.fz(n5si2) += hgfz[5];
+
+            domain.fx(n6si2) += hgfx[6];
+            domain.fy(n6si2) += hgfy[6];
+            domain.fz(n6si2) += hgfz[6];
+
+            domain.fx(n7si2) += hgfx[7];
+            domain.fy(n7si2) += hgfy[7];
+            domain.fz(n7si2) += hgfz[7];
+         }
       }
    }
 
-   if (numthreads > 1) {
+   if (toCorners) {
      // Collect the data from the local arrays into the final force arrays
-#pragma omp parallel for firstprivate(numNode)
-      for( Index_t gnode=0 ; gnode<numNode ; ++gnode )
-      {
-         Index_t count = domain.nodeElemCount(gnode) ;
-         Index_t *cornerList = domain.nodeElemCornerList(gnode) ;
-         Real_t fx_tmp = Real_t(0.0) ;
-         Real_t fy_tmp = Real_t(0.0) ;
-         Real_t fz_tmp = Real_t(0.0) ;
-         for (Index_t i=0 ; i < count ; ++i) {
-            Index_t ielem = cornerList[i] ;
-            fx_tmp += fx_elem[ielem] ;
-            fy_tmp += fy_elem[ielem] ;
-            fz_tmp += fz_elem[ielem] ;
-         }
-         domain.fx(gnode) += fx_tmp ;
-         domain.fy(gnode) += fy_tmp ;
-         domain.fz(gnode) += fz_tmp ;
-      }
-      Release(&fz_elem) ;
-      Release(&fy_elem) ;
-      Release(&fx_elem) ;
+      GatherCornerForcesForNodes(domain, part, fx_elem, fy_elem, fz_elem) ;
+      domain.ReleaseScratch(&fz_elem) ;
+      domain.ReleaseScratch(&fy_elem) ;
+      domain.ReleaseScratch(&fx_elem) ;
    }
 }
 
 /******************************************/
 
 static inline
-void CalcHourglassControlForElems(Domain& domain,
+void CalcHourglassControlForElems(Domain& domain, Int_t part,
                                   Real_t determ[], Real_t hgcoef)
 {
    Index_t numElem = domain.numElem() ;
    Index_t numElem8 = numElem * 8 ;
-   Real_t *dvdx = Allocate<Real_t>(numElem8) ;
-   Real_t *dvdy = Allocate<Real_t>(numElem8) ;
-   Real_t *dvdz = Allocate<Real_t>(numElem8) ;
-   Real_t *x8n  = Allocate<Real_t>(numElem8) ;
-   Real_t *y8n  = Allocate<Real_t>(numElem8) ;
-   Real_t *z8n  = Allocate<Real_t>(numElem8) ;
+   const Index_t *elemList = domain.partElemList(part) ;
+   Index_t numPartElem = domain.partElemSize(part) ;
+   Real_t *dvdx = domain.AllocateScratch<Real_t>(numElem8) ;
+   Real_t *dvdy = domain.AllocateScratch<Real_t>(numElem8) ;
+   Real_t *dvdz = domain.AllocateScratch<Real_t>(numElem8) ;
+   Real_t *x8n  = domain.AllocateScratch<Real_t>(numElem8) ;
+   Real_t *y8n  = domain.AllocateScratch<Real_t>(numElem8) ;
+   Real_t *z8n  = domain.AllocateScratch<Real_t>(numElem8) ;
+
+   // elements before jTail go by batches, the others one by one
+   Index_t jTail = 0 ;
+
+#if LULESH_BATCHED
+   const Index_t W = ElemBatch::width ;
+   jTail = numPartElem - numPartElem % W ;
+
+#pragma omp parallel for firstprivate(jTail)
+   for (Index_t j0=0 ; j0<jTail ; j0+=W){
+      Index_t elems[ElemBatch::width] ;
+      ElemBatch  x1[8],  y1[8],  z1[8] ;
+      ElemBatch pfx[8], pfy[8], pfz[8] ;
+
+      for (Index_t l=0 ; l<W ; ++l) {
+         elems[l] = elemList ? elemList[j0+l] : j0+l ;
+      }
+
+      CollectDomainNodesToElemNodes(domain, elems, x1, y1, z1);
+
+      CalcElemVolumeDerivative(pfx, pfy, pfz, x1, y1, z1);
+
+      for (Index_t l=0 ; l<W ; ++l) {
+         Index_t i = elems[l] ;
+
+         /* load into temporary storage for FB Hour Glass control */
+         for(Index_t ii=0;ii<8;++ii){
+            Index_t jj=8*i+ii;
+
+            dvdx[jj] = pfx[ii].v[l];
+            dvdy[jj] = pfy[ii].v[l];
+            dvdz[jj] = pfz[ii].v[l];
+            x8n[jj]  = x1[ii].v[l];
+            y8n[jj]  = y1[ii].v[l];
+            z8n[jj]  = z1[ii].v[l];
+         }
+
+         determ[i] = domain.volo(i) * domain.v(i);
+
+         /* Do a check for negative volumes */
+         if ( domain.v(i) <= Real_t(0.0) ) {
+#if USE_MPI         
+            MPI_Abort(MPI_COMM_WORLD, VolumeError) ;
+#else
+            exit(VolumeError);
+#endif
+         }
+      }
+   }
+#endif
 
    /* start loop over elements */
-#pragma omp parallel for firstprivate(numElem)
-   for (Index_t i=0 ; i<numElem ; ++i){
+#pragma omp parallel for firstprivate(numPartElem)
+   for (Index_t j=jTail ; j<numPartElem ; ++j){
+      Index_t i = elemList ? elemList[j] : j ;
       Real_t  x1[8],  y1[8],  z1[8] ;
       Real_t pfx[8], pfy[8], pfz[8] ;
 
@@ -1041,17 +922,17 @@ void CalcHourglassControlForElems(Domain& domain,
    }
 
    if ( hgcoef > Real_t(0.) ) {
-      CalcFBHourglassForceForElems( domain,
+      CalcFBHourglassForceForElems( domain, part,
                                     determ, x8n, y8n, z8n, dvdx, dvdy, dvdz,
-                                    hgcoef, numElem, domain.numNode()) ;
+                                    hgcoef, numElem) ;
    }
 
-   Release(&z8n) ;
-   Release(&y8n) ;
-   Release(&x8n) ;
-   Release(&dvdz) ;
-   Release(&dvdy) ;
-   Release(&dvdx) ;
+   domain.ReleaseScratch(&z8n) ;
+   domain.ReleaseScratch(&y8n) ;
+   domain.ReleaseScratch(&x8n) ;
+   domain.ReleaseScratch(&dvdz) ;
+   domain.ReleaseScratch(&dvdy) ;
+   domain.ReleaseScratch(&dvdx) ;
 
    return ;
 }
@@ -1059,28 +940,30 @@ void CalcHourglassControlForElems(Domain& domain,
 /******************************************/
 
 static inline
-void CalcVolumeForceForElems(Domain& domain)
+void CalcVolumeForceForElems(Domain& domain, Int_t part)
 {
    Index_t numElem = domain.numElem() ;
    if (numElem != 0) {
       Real_t  hgcoef = domain.hgcoef() ;
-      Real_t *sigxx  = Allocate<Real_t>(numElem) ;
-      Real_t *sigyy  = Allocate<Real_t>(numElem) ;
-      Real_t *sigzz  = Allocate<Real_t>(numElem) ;
-      Real_t *determ = Allocate<Real_t>(numElem) ;
+      Real_t *sigxx  = domain.AllocateScratch<Real_t>(numElem) ;
+      Real_t *sigyy  = domain.AllocateScratch<Real_t>(numElem) ;
+      Real_t *sigzz  = domain.AllocateScratch<Real_t>(numElem) ;
+      Real_t *determ = domain.AllocateScratch<Real_t>(numElem) ;
+      const Index_t *elemList = domain.partElemList(part) ;
+      Index_t numPartElem = domain.partElemSize(part) ;
 
       /* Sum contributions to total stress tensor */
-      InitStressTermsForElems(domain, sigxx, sigyy, sigzz, numElem);
+      InitStressTermsForElems(domain, part, sigxx, sigyy, sigzz);
 
       // call elemlib stress integration loop to produce nodal forces from
       // material stresses.
-      IntegrateStressForElems( domain,
-                               sigxx, sigyy, sigzz, determ, numElem,
-                               domain.numNode()) ;
+      IntegrateStressForElems( domain, part,
+                               sigxx, sigyy, sigzz, determ, numElem) ;
 
       // check for negative element volume
-#pragma omp parallel for firstprivate(numElem)
-      for ( Index_t k=0 ; k<numElem ; ++k ) {
+#pragma omp parallel for firstprivate(numPartElem)
+      for ( Index_t j=0 ; j<numPartElem ; ++j ) {
+         Index_t k = elemList ? elemList[j] : j ;
          if (determ[k] <= Real_t(0.0)) {
 #if USE_MPI            
             MPI_Abort(MPI_COMM_WORLD, VolumeError) ;
@@ -1090,17 +973,225 @@ void CalcVolumeForceForElems(Domain& domain)
          }
       }
 
-      CalcHourglassControlForElems(domain, determ, hgcoef) ;
+      CalcHourglassControlForElems(domain, part, determ, hgcoef) ;
 
-      Release(&determ) ;
-      Release(&sigzz) ;
-      Release(&sigyy) ;
-      Release(&sigxx) ;
+      domain.ReleaseScratch(&determ) ;
+      domain.ReleaseScratch(&sigzz) ;
+      domain.ReleaseScratch(&sigyy) ;
+      domain.ReleaseScratch(&sigxx) ;
    }
 }
 
 /******************************************/
 
+#if LULESH_FUSED_FORCES
+
+static inline Real_t& Lane(Real_t &value, Index_t)
+{ return value ; }
+
+template <Index_t W>
+static inline Real_t& Lane(RealBatch<W> &value, Index_t l)
+{ return value.v[l] ; }
+
+/******************************************/
+
+/* Stress and hourglass forces at the corners of one element, or one
+   batch of elements, from a single gather of its nodes */
+template <typename T>
+static inline
+void CalcElemVolumeForce(const T x[8], const T y[8], const T z[8],
+                         const T xd[8], const T yd[8], const T zd[8],
+                         const T sig, const T volinv, const T coefficient,
+                         bool hourglass, T *volume,
+                         T fx[8], T fy[8], T fz[8])
+{
+   T B[3][8] ;// shape function derivatives
+
+   CalcElemShapeFunctionDerivatives(x, y, z, B, volume);
+
+   CalcElemNodeNormals( B[0] , B[1], B[2], x, y, z );
+
+   SumElemStressesToNodeForces( B, sig, sig, sig, fx, fy, fz ) ;
+
+   if (hourglass) {
+      T dvdx[8], dvdy[8], dvdz[8] ;
+      T hourgam[8][4] ;
+      T hgfx[8], hgfy[8], hgfz[8] ;
+
+      CalcElemVolumeDerivative(dvdx, dvdy, dvdz, x, y, z);
+
+      CalcElemHourglassModes(x, y, z, dvdx, dvdy, dvdz, volinv, hourgam);
+
+      CalcElemFBHourglassForce(xd, yd, zd, hourgam, coefficient,
+                               hgfx, hgfy, hgfz);
+
+      for (Index_t i=0 ; i<8 ; ++i) {
+         fx[i] += hgfx[i] ;
+         fy[i] += hgfy[i] ;
+         fz[i] += hgfz[i] ;
+      }
+   }
+}
+
+/******************************************/
+
+/* Forces of elements elems[0] to elems[width - 1], with T = Real_t for
+   one element and T = ElemBatch for a batch.  They go to the corners
+   fx_elem, or straight to the nodes when fx_elem is NULL */
+template <typename T>
+static inline
+void CalcVolumeForceForElemBlock(Domain &domain, const Index_t elems[],
+                                 Index_t width, Real_t hgcoef,
+                                 Real_t *fx_elem, Real_t *fy_elem,
+                                 Real_t *fz_elem)
+{
+   T x[8], y[8], z[8] ;
+   T xd[8], yd[8], zd[8] ;
+   T fx[8], fy[8], fz[8] ;
+   T sig, volinv, coefficient, volume ;
+
+   for (Index_t l=0 ; l<width ; ++l) {
+      Index_t k = elems[l] ;
+      const Index_t* const elemToNode = domain.nodelist(k);
+      for (Index_t n=0 ; n<8 ; ++n) {
+         Lane(x[n], l)  = domain.x(elemToNode[n]) ;
+         Lane(y[n], l)  = domain.y(elemToNode[n]) ;
+         Lane(z[n], l)  = domain.z(elemToNode[n]) ;
+         Lane(xd[n], l) = domain.xd(elemToNode[n]) ;
+         Lane(yd[n], l) = domain.yd(elemToNode[n]) ;
+         Lane(zd[n], l) = domain.zd(elemToNode[n]) ;
+      }
+
+      /* Do a check for negative volumes */
+      if ( domain.v(k) <= Real_t(0.0) ) {
+#if USE_MPI         
+         MPI_Abort(MPI_COMM_WORLD, VolumeError) ;
+#else
+         exit(VolumeError);
+#endif
+      }
+
+      Real_t determ = domain.volo(k) * domain.v(k) ;
+      Lane(sig, l) = - domain.p(k) - domain.q(k) ;
+      Lane(volinv, l) = Real_t(1.0)/determ ;
+      Lane(coefficient, l) = - hgcoef * Real_t(0.01) * domain.ss(k) *
+                             domain.elemMass(k) / CBRT(determ) ;
+   }
+
+   CalcElemVolumeForce(x, y, z, xd, yd, zd, sig, volinv, coefficient,
+                       hgcoef > Real_t(0.), &volume, fx, fy, fz) ;
+
+   for (Index_t l=0 ; l<width ; ++l) {
+      Index_t k = elems[l] ;
+      const Index_t* const elemToNode = domain.nodelist(k);
+
+      // check for negative element volume
+      if (Lane(volume, l) <= Real_t(0.0)) {
+#if USE_MPI            
+         MPI_Abort(MPI_COMM_WORLD, VolumeError) ;
+#else
+         exit(VolumeError);
+#endif
+      }
+
+      for( Index_t lnode=0 ; lnode<8 ; ++lnode ) {
+         if (fx_elem != NULL) {
+            fx_elem[k*8+lnode] = Lane(fx[lnode], l) ;
+            fy_elem[k*8+lnode] = Lane(fy[lnode], l) ;
+            fz_elem[k*8+lnode] = Lane(fz[lnode], l) ;
+         }
+         else {
+            Index_t gnode = elemToNode[lnode];
+            domain.fx(gnode) += Lane(fx[lnode], l) ;
+            domain.fy(gnode) += Lane(fy[lnode], l) ;
+            domain.fz(gnode) += Lane(fz[lnode], l) ;
+         }
+      }
+   }
+}
+
+/******************************************/
+
+/* Same forces as CalcVolumeForceForElems, in a single pass over the
+   elements: the stress and hourglass contributions are summed at the
+   corners, without the element arrays between the two */
+static inline
+void CalcFusedVolumeForceForElems(Domain& domain, Int_t part)
+{
+   Index_t numElem = domain.numElem() ;
+   if (numElem == 0) {
+      return ;
+   }
+
+#if _OPENMP
+   Index_t numthreads = omp_get_max_threads();
+#else
+   Index_t numthreads = 1;
+#endif
+
+   // Colored, the elements of a color share no node and add their
+   // forces to the nodes directly, see IntegrateStressForElems
+   bool colored = domain.colorScatter() ;
+   bool toCorners = (numthreads > 1) && !colored ;
+   Int_t numSets = colored ? domain.numColors() : 1 ;
+
+   Real_t hgcoef = domain.hgcoef() ;
+   Index_t numElem8 = numElem * 8 ;
+   Real_t *fx_elem = NULL ;
+   Real_t *fy_elem = NULL ;
+   Real_t *fz_elem = NULL ;
+
+   if (toCorners) {
+      fx_elem = domain.AllocateScratch<Real_t>(numElem8) ;
+      fy_elem = domain.AllocateScratch<Real_t>(numElem8) ;
+      fz_elem = domain.AllocateScratch<Real_t>(numElem8) ;
+   }
+
+   for (Int_t c=0 ; c<numSets ; ++c) {
+      const Index_t *elemList = colored ? domain.colorElemList(part, c)
+                                        : domain.partElemList(part) ;
+      Index_t numSetElem = colored ? domain.colorElemSize(part, c)
+                                   : domain.partElemSize(part) ;
+
+      // elements before jTail go by batches, the others one by one
+      Index_t jTail = 0 ;
+
+#if LULESH_BATCHED
+      const Index_t W = ElemBatch::width ;
+      jTail = numSetElem - numSetElem % W ;
+
+#pragma omp parallel for firstprivate(jTail, hgcoef)
+      for (Index_t j0=0 ; j0<jTail ; j0+=W) {
+         Index_t elems[ElemBatch::width] ;
+         for (Index_t l=0 ; l<W ; ++l) {
+            elems[l] = elemList ? elemList[j0+l] : j0+l ;
+         }
+         CalcVolumeForceForElemBlock<ElemBatch>(domain, elems, W, hgcoef,
+                                                fx_elem, fy_elem, fz_elem) ;
+      }
+#endif
+
+#pragma omp parallel for firstprivate(numSetElem, hgcoef)
+      for (Index_t j=jTail ; j<numSetElem ; ++j) {
+         Index_t k = elemList ? elemList[j] : j ;
+         CalcVolumeForceForElemBlock<Real_t>(domain, &k, 1, hgcoef,
+                                             fx_elem, fy_elem, fz_elem) ;
+      }
+   }
+
+   if (toCorners) {
+     // Collect the data from the local arrays into the final force arrays
+      GatherCornerForcesForNodes(domain, part, fx_elem, fy_elem, fz_elem) ;
+      domain.ReleaseScratch(&fz_elem) ;
+      domain.ReleaseScratch(&fy_elem) ;
+      domain.ReleaseScratch(&fx_elem) ;
+   }
+}
+
+/******************************************/
+
+#endif
+
 static inline void CalcForceForNodes(Domain& domain)
 {
   Index_t numNode = domain.numNode() ;
@@ -1118,18 +1209,33 @@ static inline void CalcForceForNodes(Domain& domain)
      domain.fz(i) = Real_t(0.0) ;
   }
 
-  /* Calcforce calls partial, force, hourq */
-  CalcVolumeForceForElems(domain) ;
-
 #if USE_MPI  
   Domain_member fieldData[3] ;
   fieldData[0] = &Domain::fx ;
   fieldData[1] = &Domain::fy ;
   fieldData[2] = &Domain::fz ;
-  
-  CommSend(domain, MSG_COMM_SBN, 3, fieldData,
-           domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() +  1,
-           true, false) ;
+#endif  
+
+  // The forces of the nodes shared with the neighbors are complete
+  // after part 0, they are sent while the other elements go on
+  for (Int_t part=0 ; part<domain.numParts() ; ++part) {
+     /* Calcforce calls partial, force, hourq */
+#if LULESH_FUSED_FORCES
+     CalcFusedVolumeForceForElems(domain, part) ;
+#else
+     CalcVolumeForceForElems(domain, part) ;
+#endif
+
+#if USE_MPI  
+     if (part == 0) {
+        CommSend(domain, MSG_COMM_SBN, 3, fieldData,
+                 domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() +  1,
+                 true, false) ;
+     }
+#endif  
+  }
+
+#if USE_MPI  
   CommSBN(domain, 3, fieldData) ;
 #endif  
 }
@@ -1153,26 +1259,27 @@ void CalcAccelerationForNodes(Domain &domain, Index_t numNode)
 static inline
 void ApplyAccelerationBoundaryConditionsForNodes(Domain& domain)
 {
-   Index_t size = domain.sizeX();
-   Index_t numNodeBC = (size+1)*(size+1) ;
+   Index_t numNodeBCX = domain.symmXsize() ;
+   Index_t numNodeBCY = domain.symmYsize() ;
+   Index_t numNodeBCZ = domain.symmZsize() ;
 
 #pragma omp parallel
    {
       if (!domain.symmXempty() != 0) {
-#pragma omp for nowait firstprivate(numNodeBC)
-         for(Index_t i=0 ; i<numNodeBC ; ++i)
+#pragma omp for nowait firstprivate(numNodeBCX)
+         for(Index_t i=0 ; i<numNodeBCX ; ++i)
             domain.xdd(domain.symmX(i)) = Real_t(0.0) ;
       }
 
       if (!domain.symmYempty() != 0) {
-#pragma omp for nowait firstprivate(numNodeBC)
-         for(Index_t i=0 ; i<numNodeBC ; ++i)
+#pragma omp for nowait firstprivate(numNodeBCY)
+         for(Index_t i=0 ; i<numNodeBCY ; ++i)
             domain.ydd(domain.symmY(i)) = Real_t(0.0) ;
       }
 
       if (!domain.symmZempty() != 0) {
-#pragma omp for nowait firstprivate(numNodeBC)
-         for(Index_t i=0 ; i<numNodeBC ; ++i)
+#pragma omp for nowait firstprivate(numNodeBCZ)
+         for(Index_t i=0 ; i<numNodeBCZ ; ++i)
             domain.zdd(domain.symmZ(i)) = Real_t(0.0) ;
       }
    }
@@ -1182,12 +1289,15 @@ void ApplyAccelerationBoundaryConditionsForNodes(Domain& domain)
 
 static inline
 void CalcVelocityForNodes(Domain &domain, const Real_t dt, const Real_t u_cut,
-                          Index_t numNode)
+                          Int_t part)
 {
+   const Index_t *nodeList = domain.partNodeList(part) ;
+   Index_t numPartNode = domain.partNodeSize(part) ;
 
-#pragma omp parallel for firstprivate(numNode)
-   for ( Index_t i = 0 ; i < numNode ; ++i )
+#pragma omp parallel for firstprivate(numPartNode)
+   for ( Index_t j = 0 ; j < numPartNode ; ++j )
    {
+     Index_t i = nodeList ? nodeList[j] : j ;
      Real_t xdtmp, ydtmp, zdtmp ;
 
      xdtmp = domain.xd(i) + domain.xdd(i) * dt ;
@@ -1207,11 +1317,15 @@ void CalcVelocityForNodes(Domain &domain, const Real_t dt, const Real_t u_cut,
 /******************************************/
 
 static inline
-void CalcPositionForNodes(Domain &domain, const Real_t dt, Index_t numNode)
+void CalcPositionForNodes(Domain &domain, const Real_t dt, Int_t part)
 {
-#pragma omp parallel for firstprivate(numNode)
-   for ( Index_t i = 0 ; i < numNode ; ++i )
+   const Index_t *nodeList = domain.partNodeList(part) ;
+   Index_t numPartNode = domain.partNodeSize(part) ;
+
+#pragma omp parallel for firstprivate(numPartNode)
+   for ( Index_t j = 0 ; j < numPartNode ; ++j )
    {
+     Index_t i = nodeList ? nodeList[j] : j ;
      domain.x(i) += domain.xd(i) * dt ;
      domain.y(i) += domain.yd(i) * dt ;
      domain.z(i) += domain.zd(i) * dt ;
@@ -1246,9 +1360,6 @@ void LagrangeNodal(Domain& domain)
    
    ApplyAccelerationBoundaryConditionsForNodes(domain);
 
-   CalcVelocityForNodes( domain, delt, u_cut, domain.numNode()) ;
-
-   CalcPositionForNodes( domain, delt, domain.numNode() );
 #if USE_MPI
 #ifdef SEDOV_SYNC_POS_VEL_EARLY
   fieldData[0] = &Domain::x ;
@@ -1257,10 +1368,27 @@ void LagrangeNodal(Domain& domain)
   fieldData[3] = &Domain::xd ;
   fieldData[4] = &Domain::yd ;
   fieldData[5] = &Domain::zd ;
+#endif
+#endif
 
-   CommSend(domain, MSG_SYNC_POS_VEL, 6, fieldData,
-            domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
-            false, false) ;
+   // The nodes shared with the neighbors (part 0) are sent while the
+   // others move
+   for (Int_t part=0 ; part<domain.numParts() ; ++part) {
+      CalcVelocityForNodes( domain, delt, u_cut, part) ;
+
+      CalcPositionForNodes( domain, delt, part );
+#if USE_MPI
+#ifdef SEDOV_SYNC_POS_VEL_EARLY
+      if (part == 0) {
+         CommSend(domain, MSG_SYNC_POS_VEL, 6, fieldData,
+                  domain.sizeX() + 1, domain.sizeY() + 1, domain.sizeZ() + 1,
+                  false, false) ;
+      }
+#endif
+#endif
+   }
+#if USE_MPI
+#ifdef SEDOV_SYNC_POS_VEL_EARLY
    CommSyncPosVel(domain) ;
 #endif
 #endif
@@ -1611,12 +1739,14 @@ void CalcLagrangeElements(Domain& domain)
 /******************************************/
 
 static inline
-void CalcMonotonicQGradientsForElems(Domain& domain)
+void CalcMonotonicQGradientsForElems(Domain& domain, Int_t part)
 {
-   Index_t numElem = domain.numElem();
+   const Index_t *elemList = domain.partElemList(part) ;
+   Index_t numPartElem = domain.partElemSize(part) ;
 
-#pragma omp parallel for firstprivate(numElem)
-   for (Index_t i = 0 ; i < numElem ; ++i ) {
+#pragma omp parallel for firstprivate(numPartElem)
+   for (Index_t j = 0 ; j < numPartElem ; ++j ) {
+      Index_t i = elemList ? elemList[j] : j ;
       const Real_t ptiny = Real_t(1.e-36) ;
       Real_t ax,ay,az ;
       Real_t dxv,dyv,dzv ;
@@ -1965,9 +2095,6 @@ void CalcQForElems(Domain& domain)
                true, true) ;
 #endif      
 
-      /* Calculate velocity gradients */
-      CalcMonotonicQGradientsForElems(domain);
-
 #if USE_MPI      
       Domain_member fieldData[3] ;
       
@@ -1977,11 +2104,23 @@ void CalcQForElems(Domain& domain)
       fieldData[0] = &Domain::delv_xi ;
       fieldData[1] = &Domain::delv_eta ;
       fieldData[2] = &Domain::delv_zeta ;
+#endif      
 
-      CommSend(domain, MSG_MONOQ, 3, fieldData,
-               domain.sizeX(), domain.sizeY(), domain.sizeZ(),
-               true, true) ;
+      /* Calculate velocity gradients, the elements at the faces shared
+         with the neighbors (part 0) are sent while the others go on */
+      for (Int_t part=0 ; part<domain.numParts() ; ++part) {
+         CalcMonotonicQGradientsForElems(domain, part);
+
+#if USE_MPI      
+         if (part == 0) {
+            CommSend(domain, MSG_MONOQ, 3, fieldData,
+                     domain.sizeX(), domain.sizeY(), domain.sizeZ(),
+                     true, true) ;
+         }
+#endif      
+      }
 
+#if USE_MPI      
       CommMonoQ(domain) ;
 #endif      
 
@@ -2046,7 +2185,8 @@ void CalcPressureForElems(Real_t* p_new, Real_t* bvc,
 /******************************************/
 
 static inline
-void CalcEnergyForElems(Real_t* p_new, Real_t* e_new, Real_t* q_new,
+void CalcEnergyForElems(Domain &domain,
+                        Real_t* p_new, Real_t* e_new, Real_t* q_new,
                         Real_t* bvc, Real_t* pbvc,
                         Real_t* p_old, Real_t* e_old, Real_t* q_old,
                         Real_t* compression, Real_t* compHalfStep,
@@ -2057,7 +2197,7 @@ void CalcEnergyForElems(Real_t* p_new, Real_t* e_new, Real_t* q_new,
                         Real_t eosvmax,
                         Index_t length, Index_t *regElemList)
 {
-   Real_t *pHalfStep = Allocate<Real_t>(length) ;
+   Real_t *pHalfStep = domain.AllocateScratch<Real_t>(length) ;
 
 #pragma omp parallel for firstprivate(length, emin)
    for (Index_t i = 0 ; i < length ; ++i) {
@@ -2170,7 +2310,7 @@ void CalcEnergyForElems(Real_t* p_new, Real_t* e_new, Real_t* q_new,
       }
    }
 
-   Release(&pHalfStep) ;
+   domain.ReleaseScratch(&pHalfStep) ;
 
    return ;
 }
@@ -2219,20 +2359,20 @@ void EvalEOSForElems(Domain& domain, Real_t *vnewc,
    // These temporaries will be of different size for 
    // each call (due to different sized region element
    // lists)
-   Real_t *e_old = Allocate<Real_t>(numElemReg) ;
-   Real_t *delvc = Allocate<Real_t>(numElemReg) ;
-   Real_t *p_old = Allocate<Real_t>(numElemReg) ;
-   Real_t *q_old = Allocate<Real_t>(numElemReg) ;
-   Real_t *compression = Allocate<Real_t>(numElemReg) ;
-   Real_t *compHalfStep = Allocate<Real_t>(numElemReg) ;
-   Real_t *qq_old = Allocate<Real_t>(numElemReg) ;
-   Real_t *ql_old = Allocate<Real_t>(numElemReg) ;
-   Real_t *work = Allocate<Real_t>(numElemReg) ;
-   Real_t *p_new = Allocate<Real_t>(numElemReg) ;
-   Real_t *e_new = Allocate<Real_t>(numElemReg) ;
-   Real_t *q_new = Allocate<Real_t>(numElemReg) ;
-   Real_t *bvc = Allocate<Real_t>(numElemReg) ;
-   Real_t *pbvc = Allocate<Real_t>(numElemReg) ;
+   Real_t *e_old = domain.AllocateScratch<Real_t>(numElemReg) ;
+   Real_t *delvc = domain.AllocateScratch<Real_t>(numElemReg) ;
+   Real_t *p_old = domain.AllocateScratch<Real_t>(numElemReg) ;
+   Real_t *q_old = domain.AllocateScratch<Real_t>(numElemReg) ;
+   Real_t *compression = domain.AllocateScratch<Real_t>(numElemReg) ;
+   Real_t *compHalfStep = domain.AllocateScratch<Real_t>(numElemReg) ;
+   Real_t *qq_old = domain.AllocateScratch<Real_t>(numElemReg) ;
+   Real_t *ql_old = domain.AllocateScratch<Real_t>(numElemReg) ;
+   Real_t *work = domain.AllocateScratch<Real_t>(numElemReg) ;
+   Real_t *p_new = domain.AllocateScratch<Real_t>(numElemReg) ;
+   Real_t *e_new = domain.AllocateScratch<Real_t>(numElemReg) ;
+   Real_t *q_new = domain.AllocateScratch<Real_t>(numElemReg) ;
+   Real_t *bvc = domain.AllocateScratch<Real_t>(numElemReg) ;
+   Real_t *pbvc = domain.AllocateScratch<Real_t>(numElemReg) ;
  
    //loop to add load imbalance based on region number 
    for(Int_t j = 0; j < rep; j++) {
@@ -2286,7 +2426,7 @@ void EvalEOSForElems(Domain& domain, Real_t *vnewc,
             work[i] = Real_t(0.) ; 
          }
       }
-      CalcEnergyForElems(p_new, e_new, q_new, bvc, pbvc,
+      CalcEnergyForElems(domain, p_new, e_new, q_new, bvc, pbvc,
                          p_old, e_old,  q_old, compression, compHalfStep,
                          vnewc, work,  delvc, pmin,
                          p_cut, e_cut, q_cut, emin,
@@ -2307,20 +2447,20 @@ void EvalEOSForElems(Domain& domain, Real_t *vnewc,
                           pbvc, bvc, ss4o3,
                           numElemReg, regElemList) ;
 
-   Release(&pbvc) ;
-   Release(&bvc) ;
-   Release(&q_new) ;
-   Release(&e_new) ;
-   Release(&p_new) ;
-   Release(&work) ;
-   Release(&ql_old) ;
-   Release(&qq_old) ;
-   Release(&compHalfStep) ;
-   Release(&compression) ;
-   Release(&q_old) ;
-   Release(&p_old) ;
-   Release(&delvc) ;
-   Release(&e_old) ;
+   domain.ReleaseScratch(&pbvc) ;
+   domain.ReleaseScratch(&bvc) ;
+   domain.ReleaseScratch(&q_new) ;
+   domain.ReleaseScratch(&e_new) ;
+   domain.ReleaseScratch(&p_new) ;
+   domain.ReleaseScratch(&work) ;
+   domain.ReleaseScratch(&ql_old) ;
+   domain.ReleaseScratch(&qq_old) ;
+   domain.ReleaseScratch(&compHalfStep) ;
+   domain.ReleaseScratch(&compression) ;
+   domain.ReleaseScratch(&q_old) ;
+   domain.ReleaseScratch(&p_old) ;
+   domain.ReleaseScratch(&delvc) ;
+   domain.ReleaseScratch(&e_old) ;
 }
 
 /******************************************/
@@ -2334,7 +2474,7 @@ void ApplyMaterialPropertiesForElems(Domain& domain)
     /* Expose all of the variables needed for material evaluation */
     Real_t eosvmin = domain.eosvmin() ;
     Real_t eosvmax = domain.eosvmax() ;
-    Real_t *vnewc = Allocate<Real_t>(numElem) ;
+    Real_t *vnewc = domain.AllocateScratch<Real_t>(numElem) ;
 
 #pragma omp parallel
     {
@@ -2401,7 +2541,7 @@ void ApplyMaterialPropertiesForElems(Domain& domain)
        EvalEOSForElems(domain, vnewc, numElemReg, regElemList, rep);
     }
 
-    Release(&vnewc) ;
+    domain.ReleaseScratch(&vnewc) ;
   }
 }
 
@@ -2681,6 +2821,7 @@ int main(int argc, char *argv[])
    /* Set defaults that can be overridden by command line opts */
    opts.its = 9999999;
    opts.nx  = 30;
+   opts.meshSize = 0;
    opts.numReg = 11;
    opts.numFiles = (int)(numRanks+10)/9;
    opts.showProg = 0;
@@ -2688,32 +2829,78 @@ int main(int argc, char *argv[])
    opts.viz = 0;
    opts.balance = 1;
    opts.cost = 1;
+   opts.colorScatter = 0;
+   opts.neighborComm = 0;
 
    ParseCommandLineOptions(argc, argv, myRank, &opts);
 
+   // Set up the mesh and decompose.  The mesh is a cube of meshSize
+   // elements along side, split over colDoms x rowDoms x planeDoms
+   // domains of about opts.nx elements along side by default
+   Int_t col, row, plane, colDoms, rowDoms, planeDoms;
+   InitMeshDecomp(numRanks, myRank, &col, &row, &plane,
+                  &colDoms, &rowDoms, &planeDoms);
+   Int_t meshSize = opts.meshSize ;
+   if (meshSize == 0) {
+      meshSize = Int_t(opts.nx*cbrt(Real_t(numRanks)) + Real_t(0.5)) ;
+   }
+   if (meshSize < MAX(colDoms, MAX(rowDoms, planeDoms))) {
+      if (myRank == 0) {
+         printf("Mesh of %d elements along side too small for %d x %d x %d domains\n",
+                int(meshSize), int(colDoms), int(rowDoms), int(planeDoms)) ;
+      }
+#if USE_MPI
+      MPI_Abort(MPI_COMM_WORLD, -1) ;
+#else
+      exit(-1) ;
+#endif
+   }
+
    if ((myRank == 0) && (opts.quiet == 0)) {
-      std::cout << "Running problem size " << opts.nx << "^3 per domain until completion\n";
+      if (colDoms == planeDoms && meshSize == colDoms*opts.nx) {
+         std::cout << "Running problem size " << opts.nx << "^3 per domain until completion\n";
+      }
+      else {
+         std::cout << "Running problem size " << meshSize << "^3 on "
+                   << colDoms << "x" << rowDoms << "x" << planeDoms
+                   << " domains until completion\n";
+      }
+      // Slabs: more halo than elements once they get thin
+      if (colDoms > 4*planeDoms) {
+         std::cout << "Warning: " << numRanks << " ranks only split in "
+                   << colDoms << "x" << rowDoms << "x" << planeDoms
+                   << " domains, " << meshSize/colDoms
+                   << " element(s) thick, the halo exchanges will dominate\n";
+      }
       std::cout << "Num processors: "      << numRanks << "\n";
 #if _OPENMP
       std::cout << "Num threads: " << omp_get_max_threads() << "\n";
 #endif
-      std::cout << "Total number of elements: " << ((Int8_t)numRanks*opts.nx*opts.nx*opts.nx) << " \n\n";
+      std::cout << "Node layout: " << NodeLayout::name() << "\n";
+      std::cout << "Force scatter: " << (opts.colorScatter ? "colored" : "default") << "\n";
+#if USE_MPI
+      std::cout << "Halo exchange: " << (opts.neighborComm ? "neighborhood collectives" : "point to point") << "\n";
+#endif
+      std::cout << "Total number of elements: " << ((Int8_t)meshSize*meshSize*meshSize) << " \n\n";
       std::cout << "To run other sizes, use -s <integer>.\n";
       std::cout << "To run a fixed number of iterations, use -i <integer>.\n";
       std::cout << "To run a more or less balanced region set, use -b <integer>.\n";
       std::cout << "To change the relative costs of regions, use -c <integer>.\n";
       std::cout << "To print out progress, use -p\n";
+      std::cout << "To scatter the element forces color by color, use -g\n";
+#if USE_MPI
+      std::cout << "To exchange halos with MPI neighborhood collectives, use -n\n";
+#endif
       std::cout << "To write an output file for VisIt, use -v\n";
       std::cout << "See help (-h) for more options\n\n";
    }
 
-   // Set up the mesh and decompose. Assumes regular cubes for now
-   Int_t col, row, plane, side;
-   InitMeshDecomp(numRanks, myRank, &col, &row, &plane, &side);
-
    // Build the main data structure and initialize it
-   locDom = new Domain(numRanks, col, row, plane, opts.nx,
-                       side, opts.numReg, opts.balance, opts.cost) ;
+   locDom = new Domain(numRanks, col, row, plane, meshSize,
+                       colDoms, rowDoms, planeDoms,
+                       opts.numReg, opts.balance, opts.cost) ;
+   locDom->colorScatter() = opts.colorScatter ;
+   locDom->neighborComm() = opts.neighborComm ;
 
 
 #if USE_MPI   
@@ -2779,7 +2966,7 @@ int main(int argc, char *argv[])
    }
    
    if ((myRank == 0) && (opts.quiet == 0)) {
-      VerifyAndWriteFinalOutput(elapsed_timeG, *locDom, opts.nx, numRanks);
+      VerifyAndWriteFinalOutput(elapsed_timeG, *locDom, meshSize, numRanks);
    }
 
    delete locDom; 
@@ -39,7 +39,7 @@ typedef Int4_t  Index_t ; // array subscript and loop index
 typedef real8   Real_t ;  // floating point representation
 typedef Int4_t  Int_t ;   // integer representation
 
-enum { VolumeError = -1, QStopError = -2 } ;
+enum { VolumeError = -1, QStopError = -2, ScratchError = -3 } ;
 
 inline real4  SQRT(real4  arg) { return sqrtf(arg) ; }
 inline real8  SQRT(real8  arg) { return sqrt(arg) ; }
@@ -122,6 +122,208 @@ void Release(T **ptr)
    }
 }
 
+/*
+ * Stack of temporaries reserved once for the whole run, so that the
+ * timestep does not go through malloc and fault fresh pages every cycle.
+ * Allocations are handed out in cache-aligned slices and must be released
+ * in reverse order: the start of every live slice is kept on a stack, and
+ * releasing anything but the last one aborts.  Reserve() first-touches the
+ * pages from the OpenMP threads.
+ */
+class ScratchArena {
+
+   public:
+
+   ScratchArena() : m_base(NULL), m_capacity(0), m_top(0), m_highWater(0) {}
+   ~ScratchArena() { free(m_base) ; }
+
+   void Reserve(size_t size) ;  // in Real_t
+
+   template <typename T>
+   T *Allocate(size_t size)
+   {
+      size_t slice = CACHE_ALIGN_REAL((sizeof(T)*size + sizeof(Real_t) - 1) /
+                                      sizeof(Real_t)) ;
+      if (m_top + slice > m_capacity) {
+         Overflow(slice) ;
+      }
+      T *ptr = reinterpret_cast<T *>(m_base + m_top) ;
+      m_slices.push_back(m_top) ;
+      m_top += slice ;
+      m_highWater = MAX(m_highWater, m_top) ;
+      return ptr ;
+   }
+
+   template <typename T>
+   void Release(T **ptr)
+   {
+      if (*ptr != NULL) {
+         size_t start = reinterpret_cast<Real_t *>(*ptr) - m_base ;
+         if (m_slices.empty() || m_slices.back() != start) {
+            Misrelease(start) ;
+         }
+         m_slices.pop_back() ;
+         m_top = start ;
+         *ptr = NULL ;
+      }
+   }
+
+   size_t capacity() const  { return m_capacity ; }
+   size_t highWater() const { return m_highWater ; }
+
+   private:
+
+   void Overflow(size_t slice) ;
+   void Misrelease(size_t start) ;
+
+   Real_t *m_base ;
+   size_t  m_capacity ;
+   size_t  m_top ;
+   size_t  m_highWater ;
+   std::vector<size_t> m_slices ;  // starts of the live slices
+} ;
+
+/*
+ * Layouts of the x, y, z components of a nodal field (coordinates,
+ * velocities, accelerations and forces).  The kernels only go through
+ * the Domain accessors, so the same code builds with any of them:
+ *
+ *    SoALayout           one array per component
+ *    AoSLayout           one { x, y, z } tuple per node
+ *    AoSoALayout<W>      blocks of W x, then W y, then W z
+ *
+ * The layout is chosen at compile time with LULESH_LAYOUT (and
+ * LULESH_AOSOA_WIDTH, 4 or 8, for AoSoA).
+ */
+#define LULESH_LAYOUT_SOA   0
+#define LULESH_LAYOUT_AOS   1
+#define LULESH_LAYOUT_AOSOA 2
+
+#if !defined(LULESH_LAYOUT)
+#define LULESH_LAYOUT LULESH_LAYOUT_SOA
+#endif
+
+#if !defined(LULESH_AOSOA_WIDTH)
+#define LULESH_AOSOA_WIDTH 8
+#elif LULESH_AOSOA_WIDTH != 4 && LULESH_AOSOA_WIDTH != 8
+# error "LULESH_AOSOA_WIDTH should be 4 or 8"
+#endif
+
+class SoALayout {
+
+   public:
+
+   static const char *name() { return "SoA" ; }
+
+   void resize(size_t size)
+   {
+      m_x.resize(size) ;
+      m_y.resize(size) ;
+      m_z.resize(size) ;
+   }
+
+   Real_t& x(Index_t idx) { return m_x[idx] ; }
+   Real_t& y(Index_t idx) { return m_y[idx] ; }
+   Real_t& z(Index_t idx) { return m_z[idx] ; }
+
+   private:
+
+   std::vector<Real_t> m_x ;
+   std::vector<Real_t> m_y ;
+   std::vector<Real_t> m_z ;
+} ;
+
+class AoSLayout {
+
+   public:
+
+   static const char *name() { return "AoS" ; }
+
+   void resize(size_t size) { m_tuple.resize(size) ; }
+
+   Real_t& x(Index_t idx) { return m_tuple[idx].x ; }
+   Real_t& y(Index_t idx) { return m_tuple[idx].y ; }
+   Real_t& z(Index_t idx) { return m_tuple[idx].z ; }
+
+   private:
+
+   struct Tuple3 {
+      Real_t x, y, z ;
+   } ;
+
+   std::vector<Tuple3> m_tuple ;
+} ;
+
+template <Index_t W>
+class AoSoALayout {
+
+   public:
+
+   static const char *name() { return W == 4 ? "AoSoA4" : "AoSoA8" ; }
+
+   void resize(size_t size) { m_block.resize((size + W - 1) / W) ; }
+
+   Real_t& x(Index_t idx) { return m_block[block(idx)].x[lane(idx)] ; }
+   Real_t& y(Index_t idx) { return m_block[block(idx)].y[lane(idx)] ; }
+   Real_t& z(Index_t idx) { return m_block[block(idx)].z[lane(idx)] ; }
+
+   private:
+
+   // Indices are never negative: shift and mask rather than divide
+   static uint32_t block(Index_t idx) { return uint32_t(idx) / W ; }
+   static uint32_t lane(Index_t idx)  { return uint32_t(idx) % W ; }
+
+   struct Block {
+      Real_t x[W] ;
+      Real_t y[W] ;
+      Real_t z[W] ;
+   } ;
+
+   std::vector<Block> m_block ;
+} ;
+
+#if LULESH_LAYOUT == LULESH_LAYOUT_AOS
+typedef AoSLayout NodeLayout ;
+#elif LULESH_LAYOUT == LULESH_LAYOUT_AOSOA
+typedef AoSoALayout<LULESH_AOSOA_WIDTH> NodeLayout ;
+#else
+typedef SoALayout NodeLayout ;
+#endif
+
+#if USE_MPI
+// One message of a halo exchange, its values are the fields at
+// indices[first .. first+count) one field after another 
+struct CommMsg {
+   int     rank ;    // neighbor
+   Index_t count ;   // values per field
+   Index_t offset ;  // in commDataSend or commDataRecv
+   Index_t first ;   // in the index list of the exchange
+} ;
+
+// Halo exchange of one message type, with persistent requests or a
+// neighborhood collective (see lulesh-comm.cc).  numRecv and numSend
+// are -1 until built 
+struct CommPlan {
+   Int_t   msgType ;
+   Index_t xferFields ;
+   bool    neighbor ;   // through graphComm rather than point to point
+   Int_t   numRecv ;
+   Int_t   numSend ;
+   CommMsg recv[26] ;   // 6 faces + 12 edges + 8 corners 
+   CommMsg send[26] ;
+   std::vector<Index_t> recvIndex ;
+   std::vector<Index_t> sendIndex ;
+   std::vector<Index_t> recvOffset ;  // of the indices in the field storage,
+   std::vector<Index_t> sendOffset ;  // set by the first (un)packing 
+   MPI_Request recvRequest[26] ;
+   MPI_Request sendRequest[26] ;
+   MPI_Comm    graphComm ;     // sources and destinations in message order
+   MPI_Request collRequest ;
+   int recvCounts[26], recvDispls[26] ;
+   int sendCounts[26], sendDispls[26] ;
+} ;
+#endif
+
 //////////////////////////////////////////////////////
 // Primary data structure
 //////////////////////////////////////////////////////
@@ -130,7 +332,8 @@ void Release(T **ptr)
  * The implementation of the data abstraction used for lulesh
  * resides entirely in the Domain class below.  You can change
  * grouping and interleaving of fields here to maximize data layout
- * efficiency for your underlying architecture or compiler.
+ * efficiency for your underlying architecture or compiler.  The
+ * nodal vector fields are stored with the NodeLayout chosen above.
  *
  * For example, fields can be implemented as STL objects or
  * raw array pointers.  As another example, individual fields
@@ -152,7 +355,8 @@ class Domain {
    // Constructor
    Domain(Int_t numRanks, Index_t colLoc,
           Index_t rowLoc, Index_t planeLoc,
-          Index_t nx, Int_t tp, Int_t nr, Int_t balance, Int_t cost);
+          Index_t meshEdgeElems, Int_t colDoms, Int_t rowDoms,
+          Int_t planeDoms, Int_t nr, Int_t balance, Int_t cost);
 
    // Destructor
    ~Domain();
@@ -163,21 +367,13 @@ class Domain {
 
    void AllocateNodePersistent(Int_t numNode) // Node-centered
    {
-      m_x.resize(numNode);  // coordinates
-      m_y.resize(numNode);
-      m_z.resize(numNode);
+      m_coord.resize(numNode);  // coordinates
 
-      m_xd.resize(numNode); // velocities
-      m_yd.resize(numNode);
-      m_zd.resize(numNode);
+      m_vel.resize(numNode); // velocities
 
-      m_xdd.resize(numNode); // accelerations
-      m_ydd.resize(numNode);
-      m_zdd.resize(numNode);
+      m_acc.resize(numNode); // accelerations
 
-      m_fx.resize(numNode);  // forces
-      m_fy.resize(numNode);
-      m_fz.resize(numNode);
+      m_force.resize(numNode);  // forces
 
       m_nodalMass.resize(numNode);  // mass
    }
@@ -255,6 +451,27 @@ class Domain {
       Release(&m_dyy) ;
       Release(&m_dxx) ;
    }
+
+   // Timestep temporaries, from the scratch arena when it is built in
+   template <typename T>
+   T *AllocateScratch(size_t size)
+   {
+#if LULESH_SCRATCH_ARENA
+      return m_scratch.Allocate<T>(size) ;
+#else
+      return Allocate<T>(size) ;
+#endif
+   }
+
+   template <typename T>
+   void ReleaseScratch(T **ptr)
+   {
+#if LULESH_SCRATCH_ARENA
+      m_scratch.Release(ptr) ;
+#else
+      Release(ptr) ;
+#endif
+   }
    
    //
    // ACCESSORS
@@ -263,24 +480,24 @@ class Domain {
    // Node-centered
 
    // Nodal coordinates
-   Real_t& x(Index_t idx)    { return m_x[idx] ; }
-   Real_t& y(Index_t idx)    { return m_y[idx] ; }
-   Real_t& z(Index_t idx)    { return m_z[idx] ; }
+   Real_t& x(Index_t idx)    { return m_coord.x(idx) ; }
+   Real_t& y(Index_t idx)    { return m_coord.y(idx) ; }
+   Real_t& z(Index_t idx)    { return m_coord.z(idx) ; }
 
    // Nodal velocities
-   Real_t& xd(Index_t idx)   { return m_xd[idx] ; }
-   Real_t& yd(Index_t idx)   { return m_yd[idx] ; }
-   Real_t& zd(Index_t idx)   { return m_zd[idx] ; }
+   Real_t& xd(Index_t idx)   { return m_vel.x(idx) ; }
+   Real_t& yd(Index_t idx)   { return m_vel.y(idx) ; }
+   Real_t& zd(Index_t idx)   { return m_vel.z(idx) ; }
 
    // Nodal accelerations
-   Real_t& xdd(Index_t idx)  { return m_xdd[idx] ; }
-   Real_t& ydd(Index_t idx)  { return m_ydd[idx] ; }
-   Real_t& zdd(Index_t idx)  { return m_zdd[idx] ; }
+   Real_t& xdd(Index_t idx)  { return m_acc.x(idx) ; }
+   Real_t& ydd(Index_t idx)  { return m_acc.y(idx) ; }
+   Real_t& zdd(Index_t idx)  { return m_acc.z(idx) ; }
 
    // Nodal forces
-   Real_t& fx(Index_t idx)   { return m_fx[idx] ; }
-   Real_t& fy(Index_t idx)   { return m_fy[idx] ; }
-   Real_t& fz(Index_t idx)   { return m_fz[idx] ; }
+   Real_t& fx(Index_t idx)   { return m_force.x(idx) ; }
+   Real_t& fy(Index_t idx)   { return m_force.y(idx) ; }
+   Real_t& fz(Index_t idx)   { return m_force.z(idx) ; }
 
    // Nodal mass
    Real_t& nodalMass(Index_t idx) { return m_nodalMass[idx] ; }
@@ -292,6 +509,9 @@ class Domain {
    bool symmXempty()          { return m_symmX.empty(); }
    bool symmYempty()          { return m_symmY.empty(); }
    bool symmZempty()          { return m_symmZ.empty(); }
+   Index_t symmXsize()        { return m_symmX.size(); }
+   Index_t symmYsize()        { return m_symmY.size(); }
+   Index_t symmZsize()        { return m_symmZ.size(); }
 
    //
    // Element-centered
@@ -366,12 +586,54 @@ class Domain {
    // Element mass
    Real_t& elemMass(Index_t idx)  { return m_elemMass[idx] ; }
 
+   // Element and node parts.  With LULESH_COMM_OVERLAP, part 0 holds
+   // the elements and nodes on the faces shared with neighbor domains,
+   // part 1 the others; otherwise part 0 is the whole domain, and its
+   // lists are NULL for 0 to numElem-1 (numNode-1)
+   Int_t numParts() const             { return m_numParts ; }
+
+   Index_t partElemSize(Int_t part)
+   { return m_partElemStart[part+1] - m_partElemStart[part] ; }
+
+   Index_t *partElemList(Int_t part)
+   { return m_partElemList ? &m_partElemList[m_partElemStart[part]] : NULL ; }
+
+   Index_t partNodeSize(Int_t part)
+   { return m_partNodeStart[part+1] - m_partNodeStart[part] ; }
+
+   Index_t *partNodeList(Int_t part)
+   { return m_partNodeList ? &m_partNodeList[m_partNodeStart[part]] : NULL ; }
+
+   // Corners of the elements of a part, per node they touch: entries
+   // cornerNodeBegin(part) to cornerNodeEnd(part) - 1, entry i at node
+   // cornerNode(i)
+   Index_t cornerNodeBegin(Int_t part) { return m_cornerNodeStart[part] ; }
+   Index_t cornerNodeEnd(Int_t part)   { return m_cornerNodeStart[part+1] ; }
+
+   Index_t cornerNode(Index_t idx)
+   { return m_cornerNodeList ? m_cornerNodeList[idx] : idx ; }
+
    Index_t nodeElemCount(Index_t idx)
    { return m_nodeElemStart[idx+1] - m_nodeElemStart[idx] ; }
 
    Index_t *nodeElemCornerList(Index_t idx)
    { return &m_nodeElemCornerList[m_nodeElemStart[idx]] ; }
 
+   // Element coloring, the elements of one color share no node
+   Int_t numColors() const            { return 8 ; }
+
+   Index_t colorElemSize(Int_t part, Int_t color)
+   { return m_colorElemStart[part*8+color+1] - m_colorElemStart[part*8+color] ; }
+
+   Index_t *colorElemList(Int_t part, Int_t color)
+   { return &m_colorElemList[m_colorElemStart[part*8+color]] ; }
+
+   // Scatter the element forces to the nodes color by color
+   Int_t&  colorScatter()             { return m_colorScatter ; }
+
+   // Halo exchanges through MPI neighborhood collectives
+   Int_t&  neighborComm()             { return m_neighborComm ; }
+
    // Parameters 
 
    // Cutoffs
@@ -415,7 +677,11 @@ class Domain {
    Index_t&  colLoc()             { return m_colLoc ; }
    Index_t&  rowLoc()             { return m_rowLoc ; }
    Index_t&  planeLoc()           { return m_planeLoc ; }
-   Index_t&  tp()                 { return m_tp ; }
+
+   // Domains along the columns, rows and planes of the mesh
+   Index_t&  colDoms()            { return m_colDoms ; }
+   Index_t&  rowDoms()            { return m_rowDoms ; }
+   Index_t&  planeDoms()          { return m_planeDoms ; }
 
    Index_t&  sizeX()              { return m_sizeX ; }
    Index_t&  sizeY()              { return m_sizeY ; }
@@ -437,41 +703,34 @@ class Domain {
    Real_t *commDataSend ;
    Real_t *commDataRecv ;
    
-   // Maximum number of block neighbors 
-   MPI_Request recvRequest[26] ; // 6 faces + 12 edges + 8 corners 
-   MPI_Request sendRequest[26] ; // 6 faces + 12 edges + 8 corners 
+   // Halo exchanges, one per message type and number of fields 
+   std::vector<CommPlan *> commPlans ;
 #endif
 
   private:
 
-   void BuildMesh(Int_t nx, Int_t edgeNodes, Int_t edgeElems);
+   void BuildMesh(Index_t meshEdgeElems, const Index_t firstElem[3]);
    void SetupThreadSupportStructures();
+   void SetupElemSets();
+   void SetupScratchArena();
    void CreateRegionIndexSets(Int_t nreg, Int_t balance);
-   void SetupCommBuffers(Int_t edgeNodes);
-   void SetupSymmetryPlanes(Int_t edgeNodes);
-   void SetupElementConnectivities(Int_t edgeElems);
-   void SetupBoundaryConditions(Int_t edgeElems);
+   void SetupCommBuffers();
+   void SetupSymmetryPlanes();
+   void SetupElementConnectivities();
+   void SetupBoundaryConditions();
 
    //
    // IMPLEMENTATION
    //
 
    /* Node-centered */
-   std::vector<Real_t> m_x ;  /* coordinates */
-   std::vector<Real_t> m_y ;
-   std::vector<Real_t> m_z ;
+   NodeLayout m_coord ;  /* coordinates */
 
-   std::vector<Real_t> m_xd ; /* velocities */
-   std::vector<Real_t> m_yd ;
-   std::vector<Real_t> m_zd ;
+   NodeLayout m_vel ;    /* velocities */
 
-   std::vector<Real_t> m_xdd ; /* accelerations */
-   std::vector<Real_t> m_ydd ;
-   std::vector<Real_t> m_zdd ;
+   NodeLayout m_acc ;    /* accelerations */
 
-   std::vector<Real_t> m_fx ;  /* forces */
-   std::vector<Real_t> m_fy ;
-   std::vector<Real_t> m_fz ;
+   NodeLayout m_force ;  /* forces */
 
    std::vector<Real_t> m_nodalMass ;  /* mass */
 
@@ -488,6 +747,11 @@ class Domain {
    Index_t *m_regNumList ;    // Region number per domain element
    Index_t **m_regElemlist ;  // region indexset 
 
+   // Element coloring, by part
+   Index_t  m_colorElemStart[17] ;
+   Index_t *m_colorElemList ;
+   Int_t    m_colorScatter ;
+
    std::vector<Index_t>  m_nodelist ;     /* elemToNode connectivity */
 
    std::vector<Index_t>  m_lxim ;  /* element connectivity across each face */
@@ -572,7 +836,9 @@ class Domain {
    Index_t m_colLoc ;
    Index_t m_rowLoc ;
    Index_t m_planeLoc ;
-   Index_t m_tp ;
+   Index_t m_colDoms ;
+   Index_t m_rowDoms ;
+   Index_t m_planeDoms ;
 
    Index_t m_sizeX ;
    Index_t m_sizeY ;
@@ -583,10 +849,25 @@ class Domain {
    Index_t m_maxPlaneSize ;
    Index_t m_maxEdgeSize ;
 
+   // Element and node parts
+   Int_t    m_numParts ;
+   Index_t  m_partElemStart[3] ;
+   Index_t *m_partElemList ;
+   Index_t  m_partNodeStart[3] ;
+   Index_t *m_partNodeList ;
+
    // OMP hack 
+   Index_t  m_cornerNodeStart[3] ;
+   Index_t *m_cornerNodeList ;
    Index_t *m_nodeElemStart ;
    Index_t *m_nodeElemCornerList ;
 
+   Int_t    m_neighborComm ;
+
+#if LULESH_SCRATCH_ARENA
+   ScratchArena m_scratch ;
+#endif
+
    // Used in setup
    Index_t m_rowMin, m_rowMax;
    Index_t m_colMin, m_colMax;
@@ -599,6 +880,7 @@ typedef Real_t &(Domain::* Domain_member )(Index_t) ;
 struct cmdLineOpts {
    Int_t its; // -i 
    Int_t nx;  // -s 
+   Int_t meshSize; // -S
    Int_t numReg; // -r 
    Int_t numFiles; // -f
    Int_t showProg; // -p
@@ -606,6 +888,8 @@ struct cmdLineOpts {
    Int_t viz; // -v 
    Int_t cost; // -c
    Int_t balance; // -b
+   Int_t colorScatter; // -g
+   Int_t neighborComm; // -n
 };
 
 
@@ -622,7 +906,7 @@ void ParseCommandLineOptions(int argc, char *argv[],
                              Int_t myRank, struct cmdLineOpts *opts);
 void VerifyAndWriteFinalOutput(Real_t elapsed_time,
                                Domain& locDom,
-                               Int_t nx,
+                               Int_t meshSize,
                                Int_t numRanks);
 
 // lulesh-viz
@@ -639,7 +923,9 @@ void CommSend(Domain& domain, Int_t msgType,
 void CommSBN(Domain& domain, Int_t xferFields, Domain_member *fieldData);
 void CommSyncPosVel(Domain& domain);
 void CommMonoQ(Domain& domain);
+void CommFreePlans(Domain& domain);
 
 // lulesh-init
 void InitMeshDecomp(Int_t numRanks, Int_t myRank,
-                    Int_t *col, Int_t *row, Int_t *plane, Int_t *side);
+                    Int_t *col, Int_t *row, Int_t *plane,
+                    Int_t *colDoms, Int_t *rowDoms, Int_t *planeDoms);
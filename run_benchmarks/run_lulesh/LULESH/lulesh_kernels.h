@@ -0,0 +1,462 @@
+#if !defined(LULESH_KERNELS_H)
+#define LULESH_KERNELS_H
+
+/*
+ * Element kernels shared by lulesh.cc and the kernel microbenchmark,
+ * to be included after lulesh.h.
+ *
+ * They are templates on the value type: with T = Real_t they process
+ * one hexahedron, with T = RealBatch<W> they process W hexahedra at
+ * once, each lane holding the same node of a different element.  The
+ * operations are the same in both cases and in the same order, so each
+ * lane gives the scalar result up to the rounding of contracted
+ * multiply-adds.
+ */
+
+/*
+ * W values, one per element of a batch.  Every operator is a loop over
+ * the lanes that the compiler turns into SIMD instructions (W = 4 fills
+ * an AVX2 register of doubles, W = 8 an AVX-512 one).
+ */
+template <Index_t W>
+struct RealBatch {
+
+   static const Index_t width = W ;
+
+   Real_t v[W] ;
+
+   RealBatch() {}
+
+   RealBatch(Real_t s)
+   {
+#pragma omp simd
+      for (Index_t l = 0 ; l < W ; ++l) v[l] = s ;
+   }
+
+   RealBatch& operator+=(const RealBatch& b)
+   {
+#pragma omp simd
+      for (Index_t l = 0 ; l < W ; ++l) v[l] += b.v[l] ;
+      return *this ;
+   }
+
+   RealBatch& operator*=(const RealBatch& b)
+   {
+#pragma omp simd
+      for (Index_t l = 0 ; l < W ; ++l) v[l] *= b.v[l] ;
+      return *this ;
+   }
+
+   friend RealBatch operator-(const RealBatch& a)
+   {
+      RealBatch r ;
+#pragma omp simd
+      for (Index_t l = 0 ; l < W ; ++l) r.v[l] = -a.v[l] ;
+      return r ;
+   }
+
+   friend RealBatch operator+(const RealBatch& a, const RealBatch& b)
+   {
+      RealBatch r ;
+#pragma omp simd
+      for (Index_t l = 0 ; l < W ; ++l) r.v[l] = a.v[l] + b.v[l] ;
+      return r ;
+   }
+
+   friend RealBatch operator-(const RealBatch& a, const RealBatch& b)
+   {
+      RealBatch r ;
+#pragma omp simd
+      for (Index_t l = 0 ; l < W ; ++l) r.v[l] = a.v[l] - b.v[l] ;
+      return r ;
+   }
+
+   friend RealBatch operator*(const RealBatch& a, const RealBatch& b)
+   {
+      RealBatch r ;
+#pragma omp simd
+      for (Index_t l = 0 ; l < W ; ++l) r.v[l] = a.v[l] * b.v[l] ;
+      return r ;
+   }
+} ;
+
+/*
+ * Batch width of lulesh.cc when it is built with LULESH_BATCHED, unless
+ * LULESH_BATCH_WIDTH is given.  4 even on AVX-512 targets: lulesh2.0-kernels
+ * measures 8 as no faster than 4 there, and slower for most kernels.
+ */
+#if LULESH_BATCHED && !defined(LULESH_BATCH_WIDTH)
+# define LULESH_BATCH_WIDTH 4
+#endif
+
+/******************************************/
+
+template <typename T>
+inline
+void CalcElemShapeFunctionDerivatives( T const x[],
+                                       T const y[],
+                                       T const z[],
+                                       T b[][8],
+                                       T* const volume )
+{
+  const T x0 = x[0] ;   const T x1 = x[1] ;
+  const T x2 = x[2] ;   const T x3 = x[3] ;
+  const T x4 = x[4] ;   const T x5 = x[5] ;
+  const T x6 = x[6] ;   const T x7 = x[7] ;
+
+  const T y0 = y[0] ;   const T y1 = y[1] ;
+  const T y2 = y[2] ;   const T y3 = y[3] ;
+  const T y4 = y[4] ;   const T y5 = y[5] ;
+  const T y6 = y[6] ;   const T y7 = y[7] ;
+
+  const T z0 = z[0] ;   const T z1 = z[1] ;
+  const T z2 = z[2] ;   const T z3 = z[3] ;
+  const T z4 = z[4] ;   const T z5 = z[5] ;
+  const T z6 = z[6] ;   const T z7 = z[7] ;
+
+  T fjxxi, fjxet, fjxze;
+  T fjyxi, fjyet, fjyze;
+  T fjzxi, fjzet, fjzze;
+  T cjxxi, cjxet, cjxze;
+  T cjyxi, cjyet, cjyze;
+  T cjzxi, cjzet, cjzze;
+
+  fjxxi = Real_t(.125) * ( (x6-x0) + (x5-x3) - (x7-x1) - (x4-x2) );
+  fjxet = Real_t(.125) * ( (x6-x0) - (x5-x3) + (x7-x1) - (x4-x2) );
+  fjxze = Real_t(.125) * ( (x6-x0) + (x5-x3) + (x7-x1) + (x4-x2) );
+
+  fjyxi = Real_t(.125) * ( (y6-y0) + (y5-y3) - (y7-y1) - (y4-y2) );
+  fjyet = Real_t(.125) * ( (y6-y0) - (y5-y3) + (y7-y1) - (y4-y2) );
+  fjyze = Real_t(.125) * ( (y6-y0) + (y5-y3) + (y7-y1) + (y4-y2) );
+
+  fjzxi = Real_t(.125) * ( (z6-z0) + (z5-z3) - (z7-z1) - (z4-z2) );
+  fjzet = Real_t(.125) * ( (z6-z0) - (z5-z3) + (z7-z1) - (z4-z2) );
+  fjzze = Real_t(.125) * ( (z6-z0) + (z5-z3) + (z7-z1) + (z4-z2) );
+
+  /* compute cofactors */
+  cjxxi =    (fjyet * fjzze) - (fjzet * fjyze);
+  cjxet =  - (fjyxi * fjzze) + (fjzxi * fjyze);
+  cjxze =    (fjyxi * fjzet) - (fjzxi * fjyet);
+
+  cjyxi =  - (fjxet * fjzze) + (fjzet * fjxze);
+  cjyet =    (fjxxi * fjzze) - (fjzxi * fjxze);
+  cjyze =  - (fjxxi * fjzet) + (fjzxi * fjxet);
+
+  cjzxi =    (fjxet * fjyze) - (fjyet * fjxze);
+  cjzet =  - (fjxxi * fjyze) + (fjyxi * fjxze);
+  cjzze =    (fjxxi * fjyet) - (fjyxi * fjxet);
+
+  /* calculate partials :
+     this need only be done for l = 0,1,2,3   since , by symmetry ,
+     (6,7,4,5) = - (0,1,2,3) .
+  */
+  b[0][0] =   -  cjxxi  -  cjxet  -  cjxze;
+  b[0][1] =      cjxxi  -  cjxet  -  cjxze;
+  b[0][2] =      cjxxi  +  cjxet  -  cjxze;
+  b[0][3] =   -  cjxxi  +  cjxet  -  cjxze;
+  b[0][4] = -b[0][2];
+  b[0][5] = -b[0][3];
+  b[0][6] = -b[0][0];
+  b[0][7] = -b[0][1];
+
+  b[1][0] =   -  cjyxi  -  cjyet  -  cjyze;
+  b[1][1] =      cjyxi  -  cjyet  -  cjyze;
+  b[1][2] =      cjyxi  +  cjyet  -  cjyze;
+  b[1][3] =   -  cjyxi  +  cjyet  -  cjyze;
+  b[1][4] = -b[1][2];
+  b[1][5] = -b[1][3];
+  b[1][6] = -b[1][0];
+  b[1][7] = -b[1][1];
+
+  b[2][0] =   -  cjzxi  -  cjzet  -  cjzze;
+  b[2][1] =      cjzxi  -  cjzet  -  cjzze;
+  b[2][2] =      cjzxi  +  cjzet  -  cjzze;
+  b[2][3] =   -  cjzxi  +  cjzet  -  cjzze;
+  b[2][4] = -b[2][2];
+  b[2][5] = -b[2][3];
+  b[2][6] = -b[2][0];
+  b[2][7] = -b[2][1];
+
+  /* calculate jacobian determinant (volume) */
+  *volume = Real_t(8.) * ( fjxet * cjxet + fjyet * cjyet + fjzet * cjzet);
+}
+
+/******************************************/
+
+template <typename T>
+inline
+void SumElemFaceNormal(T *normalX0, T *normalY0, T *normalZ0,
+                       T *normalX1, T *normalY1, T *normalZ1,
+                       T *normalX2, T *normalY2, T *normalZ2,
+                       T *normalX3, T *normalY3, T *normalZ3,
+                       const T x0, const T y0, const T z0,
+                       const T x1, const T y1, const T z1,
+                       const T x2, const T y2, const T z2,
+                       const T x3, const T y3, const T z3)
+{
+   T bisectX0 = Real_t(0.5) * (x3 + x2 - x1 - x0);
+   T bisectY0 = Real_t(0.5) * (y3 + y2 - y1 - y0);
+   T bisectZ0 = Real_t(0.5) * (z3 + z2 - z1 - z0);
+   T bisectX1 = Real_t(0.5) * (x2 + x1 - x3 - x0);
+   T bisectY1 = Real_t(0.5) * (y2 + y1 - y3 - y0);
+   T bisectZ1 = Real_t(0.5) * (z2 + z1 - z3 - z0);
+   T areaX = Real_t(0.25) * (bisectY0 * bisectZ1 - bisectZ0 * bisectY1);
+   T areaY = Real_t(0.25) * (bisectZ0 * bisectX1 - bisectX0 * bisectZ1);
+   T areaZ = Real_t(0.25) * (bisectX0 * bisectY1 - bisectY0 * bisectX1);
+
+   *normalX0 += areaX;
+   *normalX1 += areaX;
+   *normalX2 += areaX;
+   *normalX3 += areaX;
+
+   *normalY0 += areaY;
+   *normalY1 += areaY;
+   *normalY2 += areaY;
+   *normalY3 += areaY;
+
+   *normalZ0 += areaZ;
+   *normalZ1 += areaZ;
+   *normalZ2 += areaZ;
+   *normalZ3 += areaZ;
+}
+
+/******************************************/
+
+template <typename T>
+inline
+void CalcElemNodeNormals(T pfx[8],
+                         T pfy[8],
+                         T pfz[8],
+                         const T x[8],
+                         const T y[8],
+                         const T z[8])
+{
+   for (Index_t i = 0 ; i < 8 ; ++i) {
+      pfx[i] = Real_t(0.0);
+      pfy[i] = Real_t(0.0);
+      pfz[i] = Real_t(0.0);
+   }
+   /* evaluate face one: nodes 0, 1, 2, 3 */
+   SumElemFaceNormal(&pfx[0], &pfy[0], &pfz[0],
+                  &pfx[1], &pfy[1], &pfz[1],
+                  &pfx[2], &pfy[2], &pfz[2],
+                  &pfx[3], &pfy[3], &pfz[3],
+                  x[0], y[0], z[0], x[1], y[1], z[1],
+                  x[2], y[2], z[2], x[3], y[3], z[3]);
+   /* evaluate face two: nodes 0, 4, 5, 1 */
+   SumElemFaceNormal(&pfx[0], &pfy[0], &pfz[0],
+                  &pfx[4], &pfy[4], &pfz[4],
+                  &pfx[5], &pfy[5], &pfz[5],
+                  &pfx[1], &pfy[1], &pfz[1],
+                  x[0], y[0], z[0], x[4], y[4], z[4],
+                  x[5], y[5], z[5], x[1], y[1], z[1]);
+   /* evaluate face three: nodes 1, 5, 6, 2 */
+   SumElemFaceNormal(&pfx[1], &pfy[1], &pfz[1],
+                  &pfx[5], &pfy[5], &pfz[5],
+                  &pfx[6], &pfy[6], &pfz[6],
+                  &pfx[2], &pfy[2], &pfz[2],
+                  x[1], y[1], z[1], x[5], y[5], z[5],
+                  x[6], y[6], z[6], x[2], y[2], z[2]);
+   /* evaluate face four: nodes 2, 6, 7, 3 */
+   SumElemFaceNormal(&pfx[2], &pfy[2], &pfz[2],
+                  &pfx[6], &pfy[6], &pfz[6],
+                  &pfx[7], &pfy[7], &pfz[7],
+                  &pfx[3], &pfy[3], &pfz[3],
+                  x[2], y[2], z[2], x[6], y[6], z[6],
+                  x[7], y[7], z[7], x[3], y[3], z[3]);
+   /* evaluate face five: nodes 3, 7, 4, 0 */
+   SumElemFaceNormal(&pfx[3], &pfy[3], &pfz[3],
+                  &pfx[7], &pfy[7], &pfz[7],
+                  &pfx[4], &pfy[4], &pfz[4],
+                  &pfx[0], &pfy[0], &pfz[0],
+                  x[3], y[3], z[3], x[7], y[7], z[7],
+                  x[4], y[4], z[4], x[0], y[0], z[0]);
+   /* evaluate face six: nodes 4, 7, 6, 5 */
+   SumElemFaceNormal(&pfx[4], &pfy[4], &pfz[4],
+                  &pfx[7], &pfy[7], &pfz[7],
+                  &pfx[6], &pfy[6], &pfz[6],
+                  &pfx[5], &pfy[5], &pfz[5],
+                  x[4], y[4], z[4], x[7], y[7], z[7],
+                  x[6], y[6], z[6], x[5], y[5], z[5]);
+}
+
+/******************************************/
+
+template <typename T>
+inline
+void SumElemStressesToNodeForces( const T B[][8],
+                                  const T stress_xx,
+                                  const T stress_yy,
+                                  const T stress_zz,
+                                  T fx[], T fy[], T fz[] )
+{
+   for(Index_t i = 0; i < 8; i++) {
+      fx[i] = -( stress_xx * B[0][i] );
+      fy[i] = -( stress_yy * B[1][i]  );
+      fz[i] = -( stress_zz * B[2][i] );
+   }
+}
+
+/******************************************/
+
+template <typename T>
+inline
+void VoluDer(const T x0, const T x1, const T x2,
+             const T x3, const T x4, const T x5,
+             const T y0, const T y1, const T y2,
+             const T y3, const T y4, const T y5,
+             const T z0, const T z1, const T z2,
+             const T z3, const T z4, const T z5,
+             T* dvdx, T* dvdy, T* dvdz)
+{
+   const Real_t twelfth = Real_t(1.0) / Real_t(12.0) ;
+
+   *dvdx =
+      (y1 + y2) * (z0 + z1) - (y0 + y1) * (z1 + z2) +
+      (y0 + y4) * (z3 + z4) - (y3 + y4) * (z0 + z4) -
+      (y2 + y5) * (z3 + z5) + (y3 + y5) * (z2 + z5);
+   *dvdy =
+      - (x1 + x2) * (z0 + z1) + (x0 + x1) * (z1 + z2) -
+      (x0 + x4) * (z3 + z4) + (x3 + x4) * (z0 + z4) +
+      (x2 + x5) * (z3 + z5) - (x3 + x5) * (z2 + z5);
+
+   *dvdz =
+      - (y1 + y2) * (x0 + x1) + (y0 + y1) * (x1 + x2) -
+      (y0 + y4) * (x3 + x4) + (y3 + y4) * (x0 + x4) +
+      (y2 + y5) * (x3 + x5) - (y3 + y5) * (x2 + x5);
+
+   *dvdx *= twelfth;
+   *dvdy *= twelfth;
+   *dvdz *= twelfth;
+}
+
+/******************************************/
+
+template <typename T>
+inline
+void CalcElemVolumeDerivative(T dvdx[8],
+                              T dvdy[8],
+                              T dvdz[8],
+                              const T x[8],
+                              const T y[8],
+                              const T z[8])
+{
+   VoluDer(x[1], x[2], x[3], x[4], x[5], x[7],
+           y[1], y[2], y[3], y[4], y[5], y[7],
+           z[1], z[2], z[3], z[4], z[5], z[7],
+           &dvdx[0], &dvdy[0], &dvdz[0]);
+   VoluDer(x[0], x[1], x[2], x[7], x[4], x[6],
+           y[0], y[1], y[2], y[7], y[4], y[6],
+           z[0], z[1], z[2], z[7], z[4], z[6],
+           &dvdx[3], &dvdy[3], &dvdz[3]);
+   VoluDer(x[3], x[0], x[1], x[6], x[7], x[5],
+           y[3], y[0], y[1], y[6], y[7], y[5],
+           z[3], z[0], z[1], z[6], z[7], z[5],
+           &dvdx[2], &dvdy[2], &dvdz[2]);
+   VoluDer(x[2], x[3], x[0], x[5], x[6], x[4],
+           y[2], y[3], y[0], y[5], y[6], y[4],
+           z[2], z[3], z[0], z[5], z[6], z[4],
+           &dvdx[1], &dvdy[1], &dvdz[1]);
+   VoluDer(x[7], x[6], x[5], x[0], x[3], x[1],
+           y[7], y[6], y[5], y[0], y[3], y[1],
+           z[7], z[6], z[5], z[0], z[3], z[1],
+           &dvdx[4], &dvdy[4], &dvdz[4]);
+   VoluDer(x[4], x[7], x[6], x[1], x[0], x[2],
+           y[4], y[7], y[6], y[1], y[0], y[2],
+           z[4], z[7], z[6], z[1], z[0], z[2],
+           &dvdx[5], &dvdy[5], &dvdz[5]);
+   VoluDer(x[5], x[4], x[7], x[2], x[1], x[3],
+           y[5], y[4], y[7], y[2], y[1], y[3],
+           z[5], z[4], z[7], z[2], z[1], z[3],
+           &dvdx[6], &dvdy[6], &dvdz[6]);
+   VoluDer(x[6], x[5], x[4], x[3], x[2], x[0],
+           y[6], y[5], y[4], y[3], y[2], y[0],
+           z[6], z[5], z[4], z[3], z[2], z[0],
+           &dvdx[7], &dvdy[7], &dvdz[7]);
+}
+
+/******************************************/
+
+/* Base vectors of the Flanagan-Belytschko hourglass modes */
+static const Real_t hourglassGamma[4][8] = {
+   { Real_t( 1.), Real_t( 1.), Real_t(-1.), Real_t(-1.),
+     Real_t(-1.), Real_t(-1.), Real_t( 1.), Real_t( 1.) },
+   { Real_t( 1.), Real_t(-1.), Real_t(-1.), Real_t( 1.),
+     Real_t(-1.), Real_t( 1.), Real_t( 1.), Real_t(-1.) },
+   { Real_t( 1.), Real_t(-1.), Real_t( 1.), Real_t(-1.),
+     Real_t( 1.), Real_t(-1.), Real_t( 1.), Real_t(-1.) },
+   { Real_t(-1.), Real_t( 1.), Real_t(-1.), Real_t( 1.),
+     Real_t( 1.), Real_t(-1.), Real_t( 1.), Real_t(-1.) }
+} ;
+
+/******************************************/
+
+template <typename T>
+inline
+void CalcElemHourglassModes(const T x8[8], const T y8[8], const T z8[8],
+                            const T dvdx[8], const T dvdy[8], const T dvdz[8],
+                            const T volinv, T hourgam[][4])
+{
+   for(Index_t i1=0;i1<4;++i1){
+      T hourmodx = x8[0] * hourglassGamma[i1][0] ;
+      T hourmody = y8[0] * hourglassGamma[i1][0] ;
+      T hourmodz = z8[0] * hourglassGamma[i1][0] ;
+      for (Index_t n=1 ; n<8 ; ++n) {
+         hourmodx += x8[n] * hourglassGamma[i1][n] ;
+         hourmody += y8[n] * hourglassGamma[i1][n] ;
+         hourmodz += z8[n] * hourglassGamma[i1][n] ;
+      }
+      for (Index_t n=0 ; n<8 ; ++n) {
+         hourgam[n][i1] = hourglassGamma[i1][n] - volinv*(dvdx[n] * hourmodx +
+                                                          dvdy[n] * hourmody +
+                                                          dvdz[n] * hourmodz );
+      }
+   }
+}
+
+/******************************************/
+
+template <typename T>
+inline
+void CalcElemFBHourglassForce(const T *xd, const T *yd, const T *zd,
+                              const T hourgam[][4],
+                              const T coefficient,
+                              T *hgfx, T *hgfy, T *hgfz )
+{
+   T hxx[4];
+   for(Index_t i = 0; i < 4; i++) {
+      hxx[i] = hourgam[0][i] * xd[0] + hourgam[1][i] * xd[1] +
+               hourgam[2][i] * xd[2] + hourgam[3][i] * xd[3] +
+               hourgam[4][i] * xd[4] + hourgam[5][i] * xd[5] +
+               hourgam[6][i] * xd[6] + hourgam[7][i] * xd[7];
+   }
+   for(Index_t i = 0; i < 8; i++) {
+      hgfx[i] = coefficient *
+                (hourgam[i][0] * hxx[0] + hourgam[i][1] * hxx[1] +
+                 hourgam[i][2] * hxx[2] + hourgam[i][3] * hxx[3]);
+   }
+   for(Index_t i = 0; i < 4; i++) {
+      hxx[i] = hourgam[0][i] * yd[0] + hourgam[1][i] * yd[1] +
+               hourgam[2][i] * yd[2] + hourgam[3][i] * yd[3] +
+               hourgam[4][i] * yd[4] + hourgam[5][i] * yd[5] +
+               hourgam[6][i] * yd[6] + hourgam[7][i] * yd[7];
+   }
+   for(Index_t i = 0; i < 8; i++) {
+      hgfy[i] = coefficient *
+                (hourgam[i][0] * hxx[0] + hourgam[i][1] * hxx[1] +
+                 hourgam[i][2] * hxx[2] + hourgam[i][3] * hxx[3]);
+   }
+   for(Index_t i = 0; i < 4; i++) {
+      hxx[i] = hourgam[0][i] * zd[0] + hourgam[1][i] * zd[1] +
+               hourgam[2][i] * zd[2] + hourgam[3][i] * zd[3] +
+               hourgam[4][i] * zd[4] + hourgam[5][i] * zd[5] +
+               hourgam[6][i] * zd[6] + hourgam[7][i] * zd[7];
+   }
+   for(Index_t i = 0; i < 8; i++) {
+      hgfz[i] = coefficient *
+                (hourgam[i][0] * hxx[0] + hourgam[i][1] * hxx[1] +
+                 hourgam[i][2] * hxx[2] + hourgam[i][3] * hxx[3]);
+   }
+}
+
+#endif
@@ -9,6 +9,8 @@ mkdir -p $log_dir
 mkdir -p $traces_dir
 mkdir -p $details_dir
 
+source $PWD/pallas_stats.sh
+
 cd $lulesh_dir
 
 NB_SIM=10
@@ -28,22 +30,7 @@ for i in $(seq $NB_SIM) ; do
 
     mv *0_trace $traces_dir/lulesh_trace_${i}
 
-    cat $PWD/zstd.csv | tail -n 1 >> "$log_file_eztrace"
-    cat $PWD/write.csv | tail -n 1 >> "$log_file_eztrace"
-    cat $PWD/write_vector.csv | tail -n 1 >> "$log_file_eztrace"
-    cat $PWD/write_duration_vector.csv | tail -n 1 >> "$log_file_eztrace"
-    cat $PWD/write_dur_subvec.csv | tail -n 1 >> "$log_file_eztrace"
-    cat $PWD/write_subvec.csv | tail -n 1 >> "$log_file_eztrace"
-
-
-
-        mv $PWD/zstd_details.csv ${details_dir}/zstd_details_${app_name}.csv
-        mv $PWD/write_details.csv ${details_dir}/write_details_${app_name}.csv
-        mv $PWD/write_vector_details.csv ${details_dir}/write_vector_details_${app_name}.csv
-        mv $PWD/write_duration_vector_details.csv ${details_dir}/write_duration_vector_details_${app_name}.csv
-        mv $PWD/write_dur_subvec_details.csv ${details_dir}/write_dur_subvec_details_${app_name}.csv
-        mv $PWD/write_subvec_details.csv ${details_dir}/write_subvec_details_${app_name}.csv
-
-
-    rm $PWD/*.csv
+    pallas_stats_collect "$log_file_eztrace" "lulesh_${i}" "$details_dir"
+    pallas_stats_provenance "$log_file_vanilla"
+    pallas_stats_provenance "$log_file_eztrace"
 done
@@ -4,10 +4,12 @@ nas_dir=$PWD/run_nas_benchmark/20_iter
 bin_dir=$nas_dir/../NPB3.4-MPI/bin
 log_dir=$nas_dir/log
 traces_dir=$nas_dir/traces
+details_dir=$nas_dir/details
 
 mkdir -p $log_dir
 mkdir -p $traces_dir
 
+source $PWD/pallas_stats.sh
 
 cd $nas_dir
 
@@ -29,6 +31,10 @@ for i in $(seq $NB_ITER) ; do
 
         mv $nas_dir/${app_name}_trace $traces_dir/${app_name}_trace_${i}
 
+        pallas_stats_collect "$log_file_eztrace" "${app_name}_${i}" "$details_dir"
+        pallas_stats_provenance "$log_file_vanilla"
+        pallas_stats_provenance "$log_file_eztrace"
+
         done
 done
 
@@ -10,6 +10,7 @@ mkdir -p $log_dir
 mkdir -p $traces_dir
 mkdir -p $details_dir
 
+source $PWD/pallas_stats.sh
 
 cd $nas_dir
 
@@ -28,30 +29,8 @@ for i in $(seq $NB_ITER) ; do
 
         mv $nas_dir/${app_name}_trace $traces_dir/${app_name}_trace_${i}
 
-        cat $PWD/zstd.csv | tail -n 1 >> "$log_file_eztrace"
-        cat $PWD/write.csv | tail -n 1 >> "$log_file_eztrace"
-        cat $PWD/write_vector.csv | tail -n 1 >> "$log_file_eztrace"
-        cat $PWD/write_duration_vector.csv | tail -n 1 >> "$log_file_eztrace"
-        cat $PWD/write_dur_subvec.csv | tail -n 1 >> "$log_file_eztrace"
-        cat $PWD/write_subvec.csv | tail -n 1 >> "$log_file_eztrace"
-
-        
-        mv $PWD/zstd_details.csv ${details_dir}/zstd_details_${app_name}.csv
-        mv $PWD/write_details.csv ${details_dir}/write_details_${app_name}.csv
-        mv $PWD/write_vector_details.csv ${details_dir}/write_vector_details_${app_name}.csv
-        mv $PWD/write_duration_vector_details.csv ${details_dir}/write_duration_vector_details_${app_name}.csv
-        mv $PWD/write_dur_subvec_details.csv ${details_dir}/write_dur_subvec_details_${app_name}.csv
-        mv $PWD/write_subvec_details.csv ${details_dir}/write_subvec_details_${app_name}.csv
-
-        mv $PWD/pcw_enc_alg_details.csv ${details_dir}/pcw_enc_alg_details_${app_name}.csv
-        mv $PWD/pcw_details.csv ${details_dir}/pcw_details_${app_name}.csv
-        mv $PWD/pcw_comp_alg_details.csv ${details_dir}/pcw_comp_alg_details_${app_name}.csv
-        mv $PWD/pcw_write_details.csv ${details_dir}/pcw_write_details_${app_name}.csv
-        mv $PWD/write_dur_subvec_ftell_details.csv ${details_dir}/write_dur_subvec_ftell_details_${app_name}.csv
-        mv $PWD/write_dur_subvec_pcw_details.csv ${details_dir}/write_dur_subvec_pcw_details_${app_name}.csv
-        mv $PWD/write_dur_subvec_delete_details.csv ${details_dir}/write_dur_subvec_delete_details_${app_name}.csv
-
-        rm $PWD/*.csv
+        pallas_stats_collect "$log_file_eztrace" "${app_name}" "$details_dir"
+        pallas_stats_provenance "$log_file_eztrace"
     done
 done
 
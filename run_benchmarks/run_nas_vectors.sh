@@ -7,6 +7,8 @@ bin_dir=$PWD/run_nas_benchmark/NPB3.4-MPI/bin
 pallas_dir=$PWD/../soft/pallas/build/
 patches_dir=$PWD/patches_nas
 
+source $PWD/pallas_stats.sh
+
 NB_RANKS=64
 
 cd "$pallas_dir"
@@ -42,26 +44,13 @@ for patch_file in "$patches_dir"/*.patch; do
         mv $nas_dir/${app_name}_trace $traces_dir/${app_name}_trace
 
 
-        cat $PWD/zstd.csv | tail -n 1 >> "$log_file_eztrace"
-        cat $PWD/write.csv | tail -n 1 >> "$log_file_eztrace"
-        cat $PWD/write_vector.csv | tail -n 1 >> "$log_file_eztrace"
-        cat $PWD/write_duration_vector.csv | tail -n 1 >> "$log_file_eztrace"
-        cat $PWD/write_dur_subvec.csv | tail -n 1 >> "$log_file_eztrace"
-        cat $PWD/write_subvec.csv | tail -n 1 >> "$log_file_eztrace"
-
-        mv $PWD/zstd_details.csv ${details_dir}/zstd_details_${app_name}.csv
-        mv $PWD/write_details.csv ${details_dir}/write_details_${app_name}.csv
-        mv $PWD/write_vector_details.csv ${details_dir}/write_vector_details_${app_name}.csv
-        mv $PWD/write_dur_vect_details.csv ${details_dir}/write_dur_vect_details_${app_name}.csv
-        mv $PWD/write_dur_subvec_details.csv ${details_dir}/write_dur_subvec_details_${app_name}.csv
-        mv $PWD/write_subvec_details.csv ${details_dir}/write_subvec_details_${app_name}.csv
+        pallas_stats_collect "$log_file_eztrace" "${app_name}" "$details_dir"
+        pallas_stats_provenance "$log_file_eztrace"
 
         time=$(grep -e "\[TIME\]" $log_file_eztrace | sed -e "s/\[TIME\]//g" | sed -e "s/ //g")
         max_memory=$(grep -e "\[MAX_MEMORY\]" $log_file_eztrace | sed -e "s/\[MAX_MEMORY\]//g" | sed -e "s/ //g")
 
         echo "${time},${max_memory}" >> "${res_patch}/perfo.csv"
-
-        rm $PWD/*.csv
     done
 
 done
@@ -0,0 +1,121 @@
+#!/bin/bash
+
+## Vector-size / configuration sweep of the NAS benchmarks under eztrace.
+##
+## Each vector size is built once into its own Pallas install, from a git
+## worktree of ../soft/pallas: the shared install used by the other scripts
+## is never modified, and a size that was already built is reused. Every run
+## selects its install through PATH/LD_LIBRARY_PATH and its Pallas
+## configuration file (codec, ...) through PALLAS_CONFIG_PATH.
+##
+## A sweep point is <vector_size>:<config>, where <config> is the name of a
+## file sweep_configs/<config>.json, or "default" for Pallas' defaults. Each
+## point has its own directory, so JOBS points can run at the same time.
+##
+##   VECTOR_SIZES="100 1000" CONFIGS="default zstd" JOBS=2 bash run_sweep.sh
+
+soft_dir=$PWD/../soft
+pallas_src=$soft_dir/pallas
+variants_dir=$soft_dir/pallas_variants
+configs_dir=$PWD/sweep_configs
+sweep_dir=$PWD/run_nas_benchmark/sweep
+bin_dir=$PWD/run_nas_benchmark/NPB3.4-MPI/bin
+
+source $PWD/pallas_stats.sh
+
+VECTOR_SIZES=${VECTOR_SIZES:-"100 1000 10000 100000 500000 1000000"}
+CONFIGS=${CONFIGS:-default}
+PALLAS_REV=${PALLAS_REV:-nikolai}
+NB_RANKS=${NB_RANKS:-64}
+JOBS=${JOBS:-1}
+APPS=${APPS:-$(ls $bin_dir)}
+
+export ZFP_ROOT=${ZFP_ROOT:-$soft_dir/zfp/install}
+export ZFP_INCLUDE_DIRS=${ZFP_INCLUDE_DIRS:-$ZFP_ROOT/include/}
+export ZFP_LIBRARIES=${ZFP_LIBRARIES:-$ZFP_ROOT/lib/}
+
+mkdir -p $variants_dir $sweep_dir
+
+## build_variant <vector_size>
+build_variant() {
+    local size=$1
+    local variant=$variants_dir/vec_${size}
+
+    if [ -e "$variant/install/.built" ]; then
+        return 0
+    fi
+
+    if [ ! -d "$variant/src" ]; then
+        git -C "$pallas_src" worktree add --detach "$variant/src" "$PALLAS_REV" || return 1
+    fi
+    sed -i "s/^#define DEFAULT_VECTOR_SIZE .*/#define DEFAULT_VECTOR_SIZE ${size}/" \
+        "$variant/src/libraries/pallas/include/pallas/pallas_linked_vector.h"
+
+    mkdir -p "$variant/build"
+    cd "$variant/build"
+    cmake ../src -DCMAKE_INSTALL_PREFIX="$variant/install" \
+          -DENABLE_PYTHON=OFF -DENABLE_ZFP=ON -DENABLE_SZ=OFF > /dev/null && \
+    make -j 14 && make install && touch "$variant/install/.built"
+    local ret=$?
+    cd - > /dev/null
+    return $ret
+}
+
+## run_point <vector_size> <config>
+run_point() {
+    local size=$1
+    local config=$2
+    local variant=$variants_dir/vec_${size}/install
+    local point_dir=$sweep_dir/vec_${size}_${config}
+    local log_dir=$point_dir/log
+    local traces_dir=$point_dir/traces
+    local details_dir=$point_dir/details
+
+    mkdir -p "$log_dir" "$traces_dir"
+
+    local config_env=()
+    if [ "$config" != "default" ]; then
+        config_env=(PALLAS_CONFIG_PATH=$configs_dir/${config}.json)
+    fi
+
+    ## Pallas drops its timer files in the working directory
+    cd "$point_dir"
+    for app_name in $APPS ; do
+        log_file_eztrace="$log_dir/${app_name}_eztrace.log"
+        echo -n > "$log_file_eztrace"
+
+        env PATH=$variant/bin:$PATH \
+            LD_LIBRARY_PATH=$variant/lib:$LD_LIBRARY_PATH \
+            "${config_env[@]}" \
+        /usr/bin/time -f "[TIME] %e\n [MAX_MEMORY] %M\n" \
+        mpirun -np "$NB_RANKS" eztrace -m -t "mpi compiler_instrumentation" "$bin_dir/$app_name" \
+            < /dev/null >> "$log_file_eztrace" 2>&1
+
+        rm -rf $traces_dir/${app_name}_trace
+        mv $point_dir/${app_name}_trace $traces_dir/${app_name}_trace
+        pallas_stats_collect "$log_file_eztrace" "${app_name}" "$details_dir"
+        pallas_stats_provenance "$log_file_eztrace" "$variants_dir/vec_${size}/src" "$variants_dir/vec_${size}/build"
+    done
+}
+
+for config in $CONFIGS ; do
+    if [ "$config" != "default" ] && [ ! -f "$configs_dir/${config}.json" ]; then
+        echo "No configuration $configs_dir/${config}.json"
+        exit 1
+    fi
+done
+
+## Builds are sequential, they share ../soft/pallas' object store
+for size in $VECTOR_SIZES ; do
+    build_variant $size || { echo "Cannot build Pallas with vectors of $size"; exit 1; }
+done
+
+for size in $VECTOR_SIZES ; do
+    for config in $CONFIGS ; do
+        while [ "$(jobs -rp | wc -l)" -ge "$JOBS" ]; do
+            wait -n
+        done
+        run_point $size $config > "$sweep_dir/vec_${size}_${config}.out" 2>&1 &
+    done
+done
+wait
@@ -0,0 +1,79 @@
+#!/bin/bash
+
+## Replays synthetic event streams into Pallas over a grid of stream shapes.
+## Every value list below is swept; each point is generated by evs_generate,
+## written by pallas_replay, and appended to results.csv. The input column
+## names the point, e.g. t4_e1000000_d3_l2_r0.9_s0.1_vec1000_default.
+##
+##   REGULARITY="1 0.99 0.9" NOISE="0 0.1" VECTOR_SIZES="1000 100000" bash run_synthetic.sh
+##
+## Vector sizes use the installs built by run_sweep.sh, "default" the shared
+## Pallas install; configurations are the sweep_configs/<config>.json files.
+
+bench_dir=$PWD/pallas_bench
+soft_dir=$PWD/../soft
+variants_dir=$soft_dir/pallas_variants
+configs_dir=$PWD/sweep_configs
+out_dir=$PWD/run_nas_benchmark/synthetic
+streams_dir=$out_dir/streams
+
+THREADS=${THREADS:-"1 4"}
+EVENTS=${EVENTS:-"1000000 100000000"}
+DEPTH=${DEPTH:-3}
+LOOPS=${LOOPS:-2}
+REGULARITY=${REGULARITY:-"1 0.9"}
+NOISE=${NOISE:-0.1}
+VECTOR_SIZES=${VECTOR_SIZES:-default}
+CONFIGS=${CONFIGS:-default}
+KEEP_STREAMS=${KEEP_STREAMS:-0}
+
+PALLAS_ROOT=${PALLAS_ROOT:-$soft_dir/pallas/install}
+
+mkdir -p $streams_dir
+cmake -S $bench_dir -B $bench_dir/build -DPALLAS_ROOT=$PALLAS_ROOT > /dev/null && \
+    cmake --build $bench_dir/build > /dev/null || exit 1
+if [ ! -x $bench_dir/build/pallas_replay ]; then
+    echo "pallas_replay was not built, check PALLAS_ROOT"
+    exit 1
+fi
+
+for threads in $THREADS ; do
+for events in $EVENTS ; do
+for depth in $DEPTH ; do
+for loops in $LOOPS ; do
+for regularity in $REGULARITY ; do
+for noise in $NOISE ; do
+    point=t${threads}_e${events}_d${depth}_l${loops}_r${regularity}_s${noise}
+    stream=$streams_dir/$point.evs
+    if [ ! -f $stream ]; then
+        $bench_dir/build/evs_generate -t $threads -e $events -d $depth -l $loops \
+            -r $regularity -s $noise $stream || exit 1
+    fi
+
+    for size in $VECTOR_SIZES ; do
+        lib_env=()
+        if [ "$size" != "default" ]; then
+            lib_env=(LD_LIBRARY_PATH=$variants_dir/vec_${size}/install/lib:$LD_LIBRARY_PATH)
+        fi
+        for config in $CONFIGS ; do
+            config_env=()
+            if [ "$config" != "default" ]; then
+                config_env=(PALLAS_CONFIG_PATH=$configs_dir/${config}.json)
+            fi
+            rm -rf $out_dir/archive
+            env "${lib_env[@]}" "${config_env[@]}" \
+                $bench_dir/build/pallas_replay -t $threads -o $out_dir/archive \
+                -n ${point}_vec${size}_${config} -r $out_dir/results.csv $stream
+        done
+    done
+
+    if [ "$KEEP_STREAMS" = 0 ]; then
+        rm -f $stream
+    fi
+done
+done
+done
+done
+done
+done
+rm -rf $out_dir/archive